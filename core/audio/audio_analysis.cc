@@ -0,0 +1,196 @@
+#include "audio/audio_analysis.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace foxglove {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x46574746;  // "FGWF"
+// Bump on any change to the format.
+constexpr uint32_t kVersion = 1;
+
+class Writer {
+ public:
+  template <typename T>
+  void Put(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    data_.insert(data_.end(), bytes, bytes + sizeof(T));
+  }
+  void PutBytes(const void* bytes, size_t size) {
+    const auto* begin = static_cast<const uint8_t*>(bytes);
+    data_.insert(data_.end(), begin, begin + size);
+  }
+
+  std::vector<uint8_t> Take() { return std::move(data_); }
+
+ private:
+  std::vector<uint8_t> data_;
+};
+
+class Reader {
+ public:
+  explicit Reader(const std::vector<uint8_t>& data) : data_(data) {}
+
+  template <typename T>
+  bool Get(T* value) {
+    return GetBytes(value, sizeof(T));
+  }
+  bool GetBytes(void* bytes, size_t size) {
+    if (data_.size() - position_ < size) {
+      return false;
+    }
+    memcpy(bytes, data_.data() + position_, size);
+    position_ += size;
+    return true;
+  }
+  size_t remaining() const { return data_.size() - position_; }
+
+ private:
+  const std::vector<uint8_t>& data_;
+  size_t position_ = 0;
+};
+
+// FNV-1a, to derive file names from paths.
+uint64_t HashPath(const std::string& path) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (const auto c : path) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+}  // namespace
+
+std::vector<uint8_t> SerializeAudioAnalysis(const AudioAnalysis& analysis,
+                                            const std::string& path,
+                                            int64_t mtime) {
+  Writer writer;
+  writer.Put(kMagic);
+  writer.Put(kVersion);
+  writer.Put(static_cast<uint32_t>(path.size()));
+  writer.PutBytes(path.data(), path.size());
+  writer.Put(mtime);
+  writer.Put(analysis.sample_rate);
+  writer.Put(analysis.channels);
+  writer.Put(analysis.frame_count);
+  writer.Put(analysis.integrated_loudness);
+  writer.Put(static_cast<uint32_t>(analysis.waveform.levels.size()));
+  for (const auto& level : analysis.waveform.levels) {
+    writer.Put(level.frames_per_bucket);
+    writer.Put(static_cast<uint64_t>(level.min.size()));
+    writer.PutBytes(level.min.data(), level.min.size());
+    writer.PutBytes(level.max.data(), level.max.size());
+  }
+  return writer.Take();
+}
+
+std::optional<AudioAnalysis> DeserializeAudioAnalysis(
+    const std::vector<uint8_t>& data, const std::string& path,
+    int64_t mtime) {
+  Reader reader(data);
+  uint32_t magic;
+  uint32_t version;
+  uint32_t path_size;
+  if (!reader.Get(&magic) || magic != kMagic || !reader.Get(&version) ||
+      version != kVersion || !reader.Get(&path_size) ||
+      path_size != path.size()) {
+    return std::nullopt;
+  }
+  std::string stored_path(path_size, '\0');
+  int64_t stored_mtime;
+  if (!reader.GetBytes(stored_path.data(), path_size) ||
+      stored_path != path || !reader.Get(&stored_mtime) ||
+      stored_mtime != mtime) {
+    return std::nullopt;
+  }
+
+  AudioAnalysis analysis;
+  uint32_t level_count;
+  if (!reader.Get(&analysis.sample_rate) || !reader.Get(&analysis.channels) ||
+      !reader.Get(&analysis.frame_count) ||
+      !reader.Get(&analysis.integrated_loudness) ||
+      !reader.Get(&level_count)) {
+    return std::nullopt;
+  }
+  for (uint32_t i = 0; i < level_count; i++) {
+    WaveformLevel level;
+    uint64_t bucket_count;
+    if (!reader.Get(&level.frames_per_bucket) || !reader.Get(&bucket_count) ||
+        bucket_count > reader.remaining() / 2) {
+      return std::nullopt;
+    }
+    level.min.resize(bucket_count);
+    level.max.resize(bucket_count);
+    reader.GetBytes(level.min.data(), bucket_count);
+    reader.GetBytes(level.max.data(), bucket_count);
+    analysis.waveform.levels.push_back(std::move(level));
+  }
+  return analysis;
+}
+
+AudioAnalysisCache::AudioAnalysisCache(std::string directory)
+    : directory_(std::move(directory)) {}
+
+std::shared_ptr<const AudioAnalysis> AudioAnalysisCache::Load(
+    const std::string& path, int64_t mtime) {
+  std::ifstream file(EntryPath(path), std::ios::binary);
+  if (!file) {
+    return nullptr;
+  }
+  const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                                  std::istreambuf_iterator<char>());
+  auto analysis = DeserializeAudioAnalysis(data, path, mtime);
+  if (!analysis) {
+    return nullptr;
+  }
+  return std::make_shared<const AudioAnalysis>(std::move(*analysis));
+}
+
+Status<ErrorDetails> AudioAnalysisCache::Store(const std::string& path,
+                                               int64_t mtime,
+                                               const AudioAnalysis& analysis) {
+  const auto data = SerializeAudioAnalysis(analysis, path, mtime);
+  const auto entry_path = EntryPath(path);
+  auto temp_path = entry_path;
+  temp_path += ".tmp";
+
+  const std::lock_guard<std::mutex> lock(store_mutex_);
+  std::error_code ec;
+  std::filesystem::create_directories(std::filesystem::u8path(directory_),
+                                      ec);
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (!file) {
+      return ErrorDetails("Writing audio analysis cache entry failed");
+    }
+  }
+  // Readers see either the old or the new entry, never a partial one.
+  std::filesystem::rename(temp_path, entry_path, ec);
+  if (ec) {
+    return ErrorDetails("Writing audio analysis cache entry failed",
+                        ec.message(), ec.value());
+  }
+  return OkStatus();
+}
+
+std::filesystem::path AudioAnalysisCache::EntryPath(
+    const std::string& path) const {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.fgwf",
+           static_cast<unsigned long long>(HashPath(path)));
+  // Paths are UTF-8, which path's std::string constructor doesn't assume on
+  // Windows.
+  return std::filesystem::u8path(directory_) / name;
+}
+
+}  // namespace foxglove
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "audio/waveform.h"
+#include "base/error_details.h"
+#include "base/status.h"
+
+namespace foxglove {
+
+struct AudioAnalysis {
+  uint32_t sample_rate = 0;
+  uint32_t channels = 0;
+  uint64_t frame_count = 0;
+  // EBU R128 integrated loudness in LUFS, -HUGE_VAL for silence.
+  double integrated_loudness = 0;
+  Waveform waveform;
+};
+
+// Serializes to a compact binary format in native byte order.
+std::vector<uint8_t> SerializeAudioAnalysis(const AudioAnalysis& analysis,
+                                            const std::string& path,
+                                            int64_t mtime);
+// Returns nothing if |data| is invalid or was written for another |path|
+// or |mtime|.
+std::optional<AudioAnalysis> DeserializeAudioAnalysis(
+    const std::vector<uint8_t>& data, const std::string& path, int64_t mtime);
+
+// Stores one file per analyzed media file in a directory, keyed by the
+// media file's path and modification time. May be used from any thread.
+class AudioAnalysisCache final {
+ public:
+  explicit AudioAnalysisCache(std::string directory);
+
+  // Returns nothing on a miss, including when the file changed since.
+  std::shared_ptr<const AudioAnalysis> Load(const std::string& path,
+                                            int64_t mtime);
+  Status<ErrorDetails> Store(const std::string& path, int64_t mtime,
+                             const AudioAnalysis& analysis);
+
+ private:
+  std::string directory_;
+  // Serializes writers so they don't race on the temporary file.
+  std::mutex store_mutex_;
+
+  std::filesystem::path EntryPath(const std::string& path) const;
+};
+
+}  // namespace foxglove
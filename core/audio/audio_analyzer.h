@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+#include "audio/audio_format.h"
+
+namespace foxglove {
+
+// Inspects decoded audio on the audio thread, which must never block, so
+// analyzers have to be cheap.
+class AudioAnalyzer {
+ public:
+  virtual ~AudioAnalyzer() = default;
+
+  // |frames| holds |frame_count| interleaved frames of |format| and is only
+  // valid for the duration of the call.
+  virtual void Analyze(const AudioFormat& format, const void* frames,
+                       size_t frame_count) = 0;
+};
+
+}  // namespace foxglove
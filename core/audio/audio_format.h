@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace foxglove {
+
+enum class SampleFormat {
+  // Signed 16-bit, native byte order.
+  kS16,
+  // 32-bit float in [-1, 1], native byte order.
+  kFloat32
+};
+
+inline size_t BytesPerSample(SampleFormat format) {
+  return format == SampleFormat::kS16 ? 2 : 4;
+}
+
+// Interleaved PCM.
+struct AudioFormat {
+  SampleFormat sample_format = SampleFormat::kFloat32;
+  uint32_t sample_rate = 48000;
+  uint32_t channels = 2;
+
+  // Size of one frame, i.e. one sample of every channel.
+  size_t frame_size() const {
+    return BytesPerSample(sample_format) * channels;
+  }
+
+  bool operator==(const AudioFormat& other) const {
+    return sample_format == other.sample_format &&
+           sample_rate == other.sample_rate && channels == other.channels;
+  }
+  bool operator!=(const AudioFormat& other) const {
+    return !operator==(other);
+  }
+};
+
+}  // namespace foxglove
@@ -0,0 +1,195 @@
+#include "audio/audio_level_meter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+#include "base/cpu_features.h"
+
+namespace foxglove {
+
+namespace {
+
+// S16 samples are converted in chunks of this many frames.
+constexpr size_t kChunkFrames = 512;
+
+// Raises |peaks| to the absolute peak and adds the sum of squares of every
+// channel of |frame_count| interleaved frames to |sums|.
+template <uint32_t kChannels>
+void MeasureFrames(const float* samples, size_t frame_count, float* peaks,
+                   double* sums) {
+  size_t frame = 0;
+#ifdef FOXGLOVE_HAS_SSE2
+  // Four frames span kChannels vectors, so lane j of vector k always holds
+  // channel (4 * k + j) % kChannels.
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  __m128 max_acc[kChannels];
+  __m128 sum_acc[kChannels];
+  for (uint32_t k = 0; k < kChannels; k++) {
+    max_acc[k] = _mm_setzero_ps();
+    sum_acc[k] = _mm_setzero_ps();
+  }
+  for (; frame + 4 <= frame_count; frame += 4) {
+    const float* src = samples + frame * kChannels;
+    for (uint32_t k = 0; k < kChannels; k++) {
+      const __m128 v = _mm_and_ps(_mm_loadu_ps(src + k * 4), abs_mask);
+      max_acc[k] = _mm_max_ps(max_acc[k], v);
+      sum_acc[k] = _mm_add_ps(sum_acc[k], _mm_mul_ps(v, v));
+    }
+  }
+  alignas(16) float max_lanes[kChannels * 4];
+  alignas(16) float sum_lanes[kChannels * 4];
+  for (uint32_t k = 0; k < kChannels; k++) {
+    _mm_store_ps(max_lanes + k * 4, max_acc[k]);
+    _mm_store_ps(sum_lanes + k * 4, sum_acc[k]);
+  }
+  for (uint32_t i = 0; i < kChannels * 4; i++) {
+    peaks[i % kChannels] = std::max(peaks[i % kChannels], max_lanes[i]);
+    sums[i % kChannels] += sum_lanes[i];
+  }
+#endif
+  for (; frame < frame_count; frame++) {
+    const float* src = samples + frame * kChannels;
+    for (uint32_t c = 0; c < kChannels; c++) {
+      const float v = std::abs(src[c]);
+      peaks[c] = std::max(peaks[c], v);
+      sums[c] += v * v;
+    }
+  }
+}
+
+void Measure(const float* samples, size_t frame_count, uint32_t channels,
+             float* peaks, double* sums) {
+  switch (channels) {
+    case 1:
+      return MeasureFrames<1>(samples, frame_count, peaks, sums);
+    case 2:
+      return MeasureFrames<2>(samples, frame_count, peaks, sums);
+    case 3:
+      return MeasureFrames<3>(samples, frame_count, peaks, sums);
+    case 4:
+      return MeasureFrames<4>(samples, frame_count, peaks, sums);
+    case 5:
+      return MeasureFrames<5>(samples, frame_count, peaks, sums);
+    case 6:
+      return MeasureFrames<6>(samples, frame_count, peaks, sums);
+    case 7:
+      return MeasureFrames<7>(samples, frame_count, peaks, sums);
+    case 8:
+      return MeasureFrames<8>(samples, frame_count, peaks, sums);
+  }
+}
+
+void S16ToFloat(const int16_t* src, float* dst, size_t count) {
+  constexpr float kScale = 1.0f / 32768;
+  size_t i = 0;
+#ifdef FOXGLOVE_HAS_SSE2
+  const __m128 scale = _mm_set1_ps(kScale);
+  for (; i + 8 <= count; i += 8) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    // Sign extend by moving each sample into the upper half of a lane.
+    const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+    _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+    _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+  }
+#endif
+  for (; i < count; i++) {
+    dst[i] = src[i] * kScale;
+  }
+}
+
+// Smoothing coefficient for a block of |seconds| and a time constant of
+// |time_constant_ms|.
+double Coefficient(double seconds, double time_constant_ms) {
+  if (time_constant_ms <= 0) {
+    return 1;
+  }
+  return 1 - std::exp(-seconds * 1000 / time_constant_ms);
+}
+
+}  // namespace
+
+AudioLevelMeter::AudioLevelMeter(const AudioLevelMeterOptions& options,
+                                 AudioLevelEventCallback callback)
+    : options_(options), callback_(std::move(callback)) {}
+
+void AudioLevelMeter::Analyze(const AudioFormat& format, const void* frames,
+                              size_t frame_count) {
+  if (format.channels == 0 || format.sample_rate == 0 || frame_count == 0) {
+    return;
+  }
+  if (format != format_) {
+    format_ = format;
+    peak_.fill(0);
+    mean_square_.fill(0);
+    frames_until_event_ = 0;
+  }
+
+  // S16 gets converted and wider frames get cut down to their leading
+  // channels in chunks, float frames are measured in place.
+  const auto channels =
+      std::min<uint32_t>(format.channels, kMaxMeteredChannels);
+  std::array<float, kMaxMeteredChannels> peaks{};
+  std::array<double, kMaxMeteredChannels> sums{};
+  if (format.sample_format == SampleFormat::kFloat32 &&
+      channels == format.channels) {
+    Measure(static_cast<const float*>(frames), frame_count, channels,
+            peaks.data(), sums.data());
+  } else {
+    scratch_.resize(kChunkFrames * format.channels);
+    for (size_t offset = 0; offset < frame_count; offset += kChunkFrames) {
+      const auto count = std::min(kChunkFrames, frame_count - offset);
+      const auto samples = count * format.channels;
+      if (format.sample_format == SampleFormat::kS16) {
+        S16ToFloat(static_cast<const int16_t*>(frames) +
+                       offset * format.channels,
+                   scratch_.data(), samples);
+      } else {
+        std::copy_n(
+            static_cast<const float*>(frames) + offset * format.channels,
+            samples, scratch_.data());
+      }
+      if (channels != format.channels) {
+        for (size_t i = 0; i < count; i++) {
+          std::copy_n(scratch_.data() + i * format.channels, channels,
+                      scratch_.data() + i * channels);
+        }
+      }
+      Measure(scratch_.data(), count, channels, peaks.data(), sums.data());
+    }
+  }
+
+  const double seconds = static_cast<double>(frame_count) / format.sample_rate;
+  const double attack = Coefficient(seconds, options_.attack_ms);
+  const double release = Coefficient(seconds, options_.release_ms);
+  for (uint32_t c = 0; c < channels; c++) {
+    const double peak = peaks[c];
+    peak_[c] += (peak > peak_[c] ? attack : release) * (peak - peak_[c]);
+    const double mean_square = sums[c] / frame_count;
+    mean_square_[c] += (mean_square > mean_square_[c] ? attack : release) *
+                       (mean_square - mean_square_[c]);
+  }
+
+  frames_until_event_ -= static_cast<double>(frame_count);
+  if (frames_until_event_ > 0 || !callback_) {
+    return;
+  }
+  const double interval =
+      options_.events_per_second > 0
+          ? format.sample_rate / options_.events_per_second
+          : 0;
+  frames_until_event_ = std::max(frames_until_event_ + interval, 0.0);
+
+  AudioLevelEvent event;
+  event.channels = channels;
+  for (uint32_t c = 0; c < channels; c++) {
+    event.peak[c] = static_cast<float>(peak_[c]);
+    event.rms[c] = static_cast<float>(std::sqrt(mean_square_[c]));
+  }
+  callback_(event);
+}
+
+}  // namespace foxglove
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "audio/audio_analyzer.h"
+#include "events.h"
+
+namespace foxglove {
+
+struct AudioLevelMeterOptions {
+  // Time constants of the smoothing while levels rise and fall, 0 follows
+  // the measured blocks instantly.
+  double attack_ms = 10;
+  double release_ms = 300;
+  // Events raised per second of audio.
+  double events_per_second = 30;
+};
+
+typedef std::function<void(const AudioLevelEvent& event)>
+    AudioLevelEventCallback;
+
+// Measures the peak and RMS level of every channel over each block of
+// decoded audio and smooths them with separate attack and release times,
+// for driving level meters.
+class AudioLevelMeter : public AudioAnalyzer {
+ public:
+  // |callback| runs on the audio thread and must not block.
+  AudioLevelMeter(const AudioLevelMeterOptions& options,
+                  AudioLevelEventCallback callback);
+
+  void Analyze(const AudioFormat& format, const void* frames,
+               size_t frame_count) override;
+
+ private:
+  AudioLevelMeterOptions options_;
+  AudioLevelEventCallback callback_;
+  AudioFormat format_;
+  std::array<double, kMaxMeteredChannels> peak_{};
+  std::array<double, kMaxMeteredChannels> mean_square_{};
+  // Frames of audio left until the next event.
+  double frames_until_event_ = 0;
+  // S16 samples converted to float.
+  std::vector<float> scratch_;
+};
+
+}  // namespace foxglove
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+
+#include "audio/audio_analyzer.h"
+#include "audio/audio_format.h"
+
+namespace foxglove {
+
+class AudioOutput {
+ public:
+  virtual ~AudioOutput() = default;
+
+  // The format decoded audio gets converted to.
+  virtual const AudioFormat& format() const = 0;
+
+  // Runs |analyzer| on all decoded audio. May be called from any thread.
+  // Returns false if the output doesn't support analysis.
+  virtual bool AddAudioAnalyzer(std::shared_ptr<AudioAnalyzer> /*analyzer*/) {
+    return false;
+  }
+  // Waits for a running analysis to finish. Returns false if |analyzer|
+  // wasn't added.
+  virtual bool RemoveAudioAnalyzer(const AudioAnalyzer* /*analyzer*/) {
+    return false;
+  }
+};
+
+}  // namespace foxglove
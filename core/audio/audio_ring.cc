@@ -0,0 +1,85 @@
+#include "audio/audio_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace foxglove {
+
+AudioRing::AudioRing(const AudioFormat& format, size_t capacity_frames)
+    : format_(format),
+      frame_size_(format.frame_size()),
+      capacity_(capacity_frames),
+      memory_(capacity_frames * format.frame_size()) {
+  if (!memory_) {
+    capacity_ = 0;
+  }
+}
+
+size_t AudioRing::Write(const void* frames, size_t frame_count) {
+  const auto write = write_index_.load(std::memory_order_relaxed);
+  const auto read = read_index_.load(std::memory_order_acquire);
+  const auto free = capacity_ - static_cast<size_t>(write - read);
+  const auto count = std::min(frame_count, free);
+  if (count < frame_count) {
+    frames_dropped_.fetch_add(frame_count - count, std::memory_order_relaxed);
+  }
+  if (count > 0) {
+    // Split at the end of the ring.
+    const auto* src = static_cast<const uint8_t*>(frames);
+    const auto offset = static_cast<size_t>(write % capacity_) * frame_size_;
+    const auto size = count * frame_size_;
+    const auto first = std::min(size, memory_.size() - offset);
+    memcpy(memory_.data() + offset, src, first);
+    memcpy(memory_.data(), src + first, size - first);
+    write_index_.store(write + count, std::memory_order_release);
+  }
+  return count;
+}
+
+void AudioRing::Flush() {
+  flush_index_.store(write_index_.load(std::memory_order_relaxed),
+                     std::memory_order_release);
+}
+
+size_t AudioRing::Read(void* frames, size_t max_frames) {
+  auto read = read_index_.load(std::memory_order_relaxed);
+  const auto flush = flush_index_.exchange(kNoFlush, std::memory_order_acquire);
+  if (flush != kNoFlush && flush > read) {
+    frames_flushed_.fetch_add(flush - read, std::memory_order_relaxed);
+    read = flush;
+  }
+  const auto write = write_index_.load(std::memory_order_acquire);
+  const auto count = std::min(max_frames, static_cast<size_t>(write - read));
+  if (count > 0) {
+    auto* dst = static_cast<uint8_t*>(frames);
+    const auto offset = static_cast<size_t>(read % capacity_) * frame_size_;
+    const auto size = count * frame_size_;
+    const auto first = std::min(size, memory_.size() - offset);
+    memcpy(dst, memory_.data() + offset, first);
+    memcpy(dst + first, memory_.data(), size - first);
+  }
+  read_index_.store(read + count, std::memory_order_release);
+  return count;
+}
+
+size_t AudioRing::available() const {
+  auto read = read_index_.load(std::memory_order_relaxed);
+  const auto flush = flush_index_.load(std::memory_order_acquire);
+  if (flush != kNoFlush) {
+    read = std::max(read, flush);
+  }
+  return static_cast<size_t>(write_index_.load(std::memory_order_acquire) -
+                             read);
+}
+
+AudioRingStats AudioRing::stats() const {
+  AudioRingStats stats;
+  stats.frames_written = write_index_.load(std::memory_order_relaxed);
+  stats.frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+  stats.frames_flushed = frames_flushed_.load(std::memory_order_relaxed);
+  stats.frames_read = read_index_.load(std::memory_order_relaxed) -
+                      stats.frames_flushed;
+  return stats;
+}
+
+}  // namespace foxglove
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "audio/audio_format.h"
+#include "base/aligned_memory.h"
+
+namespace foxglove {
+
+struct AudioRingStats {
+  uint64_t frames_written = 0;
+  uint64_t frames_read = 0;
+  // Frames that didn't fit because the consumer fell behind.
+  uint64_t frames_dropped = 0;
+  // Frames discarded unread by Flush().
+  uint64_t frames_flushed = 0;
+};
+
+// Lock-free single producer, single consumer ring of interleaved PCM
+// frames. Neither side ever waits for the other: when the ring is full the
+// newest frames get dropped, and reads return what's available.
+class AudioRing final {
+ public:
+  AudioRing(const AudioFormat& format, size_t capacity_frames);
+
+  AudioRing(const AudioRing&) = delete;
+  AudioRing& operator=(const AudioRing&) = delete;
+
+  const AudioFormat& format() const { return format_; }
+  size_t capacity() const { return capacity_; }
+  bool is_valid() const { return static_cast<bool>(memory_); }
+
+  // Producer side. Must be called from a single thread.
+  // Appends up to |frame_count| frames and returns how many fit.
+  size_t Write(const void* frames, size_t frame_count);
+  // Discards the frames written so far once the consumer reads next, e.g.
+  // after seeking.
+  void Flush();
+
+  // Consumer side. Must be called from a single thread.
+  // Copies up to |max_frames| frames to |frames| and returns how many.
+  size_t Read(void* frames, size_t max_frames);
+  // Frames a Read() would return at least.
+  size_t available() const;
+
+  // May be called from any thread.
+  AudioRingStats stats() const;
+
+ private:
+  static constexpr uint64_t kNoFlush = std::numeric_limits<uint64_t>::max();
+
+  AudioFormat format_;
+  size_t frame_size_;
+  size_t capacity_;
+  AlignedMemory memory_;
+
+  // Frame counters that only ever increase, on separate cache lines so
+  // producer and consumer don't contend.
+  alignas(64) std::atomic<uint64_t> write_index_ = 0;
+  alignas(64) std::atomic<uint64_t> read_index_ = 0;
+  // Write index at the last Flush() the consumer hasn't applied yet.
+  std::atomic<uint64_t> flush_index_ = kNoFlush;
+
+  std::atomic<uint64_t> frames_dropped_ = 0;
+  std::atomic<uint64_t> frames_flushed_ = 0;
+};
+
+}  // namespace foxglove
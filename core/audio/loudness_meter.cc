@@ -0,0 +1,120 @@
+#include "audio/loudness_meter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace foxglove {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kAbsoluteGate = -70;
+constexpr double kRelativeGate = -10;
+
+double ToLoudness(double mean_square) {
+  return -0.691 + 10 * std::log10(mean_square);
+}
+
+}  // namespace
+
+LoudnessMeter::LoudnessMeter(uint32_t sample_rate, uint32_t channels)
+    : channels_(std::clamp<uint32_t>(channels, 1, kMaxChannels)),
+      step_frames_(std::max<uint32_t>(sample_rate / 10, 1)) {
+  // BS.1770 gives the K-weighting coefficients for 48 kHz, these are the
+  // analog prototypes they derive from, mapped to |sample_rate|.
+  const double rate = std::max<uint32_t>(sample_rate, 1);
+  {
+    const double f0 = 1681.974450955533;
+    const double gain_db = 3.999843853973347;
+    const double q = 0.7071752369554196;
+    const double k = std::tan(kPi * f0 / rate);
+    const double vh = std::pow(10.0, gain_db / 20);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    const double a0 = 1 + k / q + k * k;
+    shelf_.b0 = (vh + vb * k / q + k * k) / a0;
+    shelf_.b1 = 2 * (k * k - vh) / a0;
+    shelf_.b2 = (vh - vb * k / q + k * k) / a0;
+    shelf_.a1 = 2 * (k * k - 1) / a0;
+    shelf_.a2 = (1 - k / q + k * k) / a0;
+  }
+  {
+    const double f0 = 38.13547087602444;
+    const double q = 0.5003270373238773;
+    const double k = std::tan(kPi * f0 / rate);
+    const double a0 = 1 + k / q + k * k;
+    high_pass_.b0 = 1;
+    high_pass_.b1 = -2;
+    high_pass_.b2 = 1;
+    high_pass_.a1 = 2 * (k * k - 1) / a0;
+    high_pass_.a2 = (1 - k / q + k * k) / a0;
+  }
+}
+
+void LoudnessMeter::Add(const float* frames, size_t frame_count) {
+  for (size_t i = 0; i < frame_count; i++) {
+    const float* frame = frames + i * channels_;
+    for (uint32_t c = 0; c < channels_; c++) {
+      // Transposed direct form II, shelf then high pass.
+      auto& s = shelf_state_[c];
+      const double x = frame[c];
+      const double y = shelf_.b0 * x + s.z1;
+      s.z1 = shelf_.b1 * x - shelf_.a1 * y + s.z2;
+      s.z2 = shelf_.b2 * x - shelf_.a2 * y;
+
+      auto& h = high_pass_state_[c];
+      const double z = high_pass_.b0 * y + h.z1;
+      h.z1 = high_pass_.b1 * y - high_pass_.a1 * z + h.z2;
+      h.z2 = high_pass_.b2 * y - high_pass_.a2 * z;
+      step_sum_ += z * z;
+    }
+
+    if (++step_position_ < step_frames_) {
+      continue;
+    }
+    steps_[step_count_ % steps_.size()] = step_sum_;
+    step_count_++;
+    step_sum_ = 0;
+    step_position_ = 0;
+    if (step_count_ >= steps_.size()) {
+      double block = 0;
+      for (const auto step : steps_) {
+        block += step;
+      }
+      blocks_.push_back(block / (step_frames_ * steps_.size()));
+    }
+  }
+}
+
+double LoudnessMeter::IntegratedLoudness() const {
+  const double absolute_threshold =
+      std::pow(10.0, (kAbsoluteGate + 0.691) / 10);
+  double sum = 0;
+  size_t count = 0;
+  for (const auto block : blocks_) {
+    if (block > absolute_threshold) {
+      sum += block;
+      count++;
+    }
+  }
+  if (count == 0) {
+    return -HUGE_VAL;
+  }
+
+  const double relative_threshold =
+      sum / count * std::pow(10.0, kRelativeGate / 10);
+  const double threshold = std::max(absolute_threshold, relative_threshold);
+  sum = 0;
+  count = 0;
+  for (const auto block : blocks_) {
+    if (block > threshold) {
+      sum += block;
+      count++;
+    }
+  }
+  if (count == 0) {
+    return -HUGE_VAL;
+  }
+  return ToLoudness(sum / count);
+}
+
+}  // namespace foxglove
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace foxglove {
+
+// Measures integrated loudness according to EBU R128 (ITU-R BS.1770-4):
+// K-weighted mean square over 400 ms blocks overlapping by 75%, gated at
+// -70 LUFS and 10 LU below the ungated level. All channels are weighted
+// equally, which is what BS.1770 specifies for mono and stereo.
+class LoudnessMeter final {
+ public:
+  static constexpr uint32_t kMaxChannels = 8;
+
+  LoudnessMeter(uint32_t sample_rate, uint32_t channels);
+
+  // Takes interleaved float frames.
+  void Add(const float* frames, size_t frame_count);
+
+  // In LUFS, -HUGE_VAL if everything was gated, e.g. silence.
+  double IntegratedLoudness() const;
+
+ private:
+  struct Biquad {
+    double b0, b1, b2, a1, a2;
+  };
+  struct FilterState {
+    double z1 = 0;
+    double z2 = 0;
+  };
+
+  uint32_t channels_;
+  // Frames per 100 ms step.
+  uint32_t step_frames_;
+  Biquad shelf_;
+  Biquad high_pass_;
+  std::array<FilterState, kMaxChannels> shelf_state_{};
+  std::array<FilterState, kMaxChannels> high_pass_state_{};
+
+  // Sum of the filtered squares of all channels in the current step.
+  double step_sum_ = 0;
+  uint32_t step_position_ = 0;
+  // The last four step sums, which make up a block.
+  std::array<double, 4> steps_{};
+  uint64_t step_count_ = 0;
+  // Mean square of every block.
+  std::vector<double> blocks_;
+};
+
+}  // namespace foxglove
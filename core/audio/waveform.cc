@@ -0,0 +1,103 @@
+#include "audio/waveform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "base/cpu_features.h"
+
+namespace foxglove {
+
+namespace {
+
+// Lowers |*min| and raises |*max| to the extremes of |count| samples.
+void MinMax(const float* samples, size_t count, float* min, float* max) {
+  size_t i = 0;
+#ifdef FOXGLOVE_HAS_SSE2
+  if (count >= 4) {
+    __m128 vmin = _mm_set1_ps(*min);
+    __m128 vmax = _mm_set1_ps(*max);
+    for (; i + 4 <= count; i += 4) {
+      const __m128 v = _mm_loadu_ps(samples + i);
+      vmin = _mm_min_ps(vmin, v);
+      vmax = _mm_max_ps(vmax, v);
+    }
+    alignas(16) float lanes[8];
+    _mm_store_ps(lanes, vmin);
+    _mm_store_ps(lanes + 4, vmax);
+    *min = std::min({lanes[0], lanes[1], lanes[2], lanes[3]});
+    *max = std::max({lanes[4], lanes[5], lanes[6], lanes[7]});
+  }
+#endif
+  for (; i < count; i++) {
+    *min = std::min(*min, samples[i]);
+    *max = std::max(*max, samples[i]);
+  }
+}
+
+int8_t Quantize(float value) {
+  return static_cast<int8_t>(
+      std::lround(std::clamp(value, -1.0f, 1.0f) * 127));
+}
+
+}  // namespace
+
+WaveformBuilder::WaveformBuilder(uint32_t channels,
+                                 uint32_t frames_per_bucket)
+    : channels_(std::max<uint32_t>(channels, 1)),
+      frames_per_bucket_(std::max<uint32_t>(frames_per_bucket, 1)) {
+  base_.frames_per_bucket = frames_per_bucket_;
+  bucket_min_ = std::numeric_limits<float>::infinity();
+  bucket_max_ = -std::numeric_limits<float>::infinity();
+}
+
+void WaveformBuilder::Add(const float* frames, size_t frame_count) {
+  while (frame_count > 0) {
+    const auto count = std::min<size_t>(frame_count,
+                                        frames_per_bucket_ - bucket_frames_);
+    MinMax(frames, count * channels_, &bucket_min_, &bucket_max_);
+    bucket_frames_ += static_cast<uint32_t>(count);
+    if (bucket_frames_ == frames_per_bucket_) {
+      CloseBucket();
+    }
+    frames += count * channels_;
+    frame_count -= count;
+  }
+}
+
+Waveform WaveformBuilder::Finish(uint32_t level_count) {
+  if (bucket_frames_ > 0) {
+    CloseBucket();
+  }
+  Waveform waveform;
+  waveform.levels.push_back(std::move(base_));
+  for (uint32_t level = 1; level < level_count; level++) {
+    const auto& parent = waveform.levels.back();
+    if (parent.min.size() <= 1) {
+      break;
+    }
+    WaveformLevel next;
+    next.frames_per_bucket = parent.frames_per_bucket * 2;
+    const auto buckets = (parent.min.size() + 1) / 2;
+    next.min.resize(buckets);
+    next.max.resize(buckets);
+    for (size_t i = 0; i < buckets; i++) {
+      const auto second = std::min(i * 2 + 1, parent.min.size() - 1);
+      next.min[i] = std::min(parent.min[i * 2], parent.min[second]);
+      next.max[i] = std::max(parent.max[i * 2], parent.max[second]);
+    }
+    waveform.levels.push_back(std::move(next));
+  }
+  return waveform;
+}
+
+void WaveformBuilder::CloseBucket() {
+  base_.min.push_back(Quantize(bucket_min_));
+  base_.max.push_back(Quantize(bucket_max_));
+  bucket_frames_ = 0;
+  bucket_min_ = std::numeric_limits<float>::infinity();
+  bucket_max_ = -std::numeric_limits<float>::infinity();
+}
+
+}  // namespace foxglove
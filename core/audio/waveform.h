@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace foxglove {
+
+// Minimum and maximum sample of every bucket of a fixed number of frames,
+// across all channels, scaled to -127..127.
+struct WaveformLevel {
+  uint32_t frames_per_bucket = 0;
+  std::vector<int8_t> min;
+  std::vector<int8_t> max;
+};
+
+// Peak overview at several resolutions, each level having half as many
+// buckets as the one before.
+struct Waveform {
+  std::vector<WaveformLevel> levels;
+};
+
+// Builds a Waveform from interleaved float frames.
+class WaveformBuilder final {
+ public:
+  WaveformBuilder(uint32_t channels, uint32_t frames_per_bucket);
+
+  void Add(const float* frames, size_t frame_count);
+  // Adds the partial last bucket and derives |level_count| levels in total
+  // (at least one).
+  Waveform Finish(uint32_t level_count);
+
+ private:
+  uint32_t channels_;
+  uint32_t frames_per_bucket_;
+  WaveformLevel base_;
+  // The bucket being filled.
+  uint32_t bucket_frames_ = 0;
+  float bucket_min_;
+  float bucket_max_;
+
+  void CloseBucket();
+};
+
+}  // namespace foxglove
@@ -0,0 +1,138 @@
+#include "base/aligned_memory.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace foxglove {
+
+namespace {
+
+#ifdef __linux__
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+#endif
+
+constexpr size_t RoundUp(size_t value, size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+}  // namespace
+
+AlignedMemory::AlignedMemory(size_t size, bool use_huge_pages,
+                             size_t alignment)
+    : size_(size) {
+  assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+  if (size == 0) {
+    return;
+  }
+
+  if (use_huge_pages) {
+#ifdef _WIN32
+    // Requires SeLockMemoryPrivilege, so failing here is the common case.
+    const auto large_page_size = GetLargePageMinimum();
+    if (large_page_size > 0) {
+      const auto mapped_size = RoundUp(size, large_page_size);
+      data_ = static_cast<uint8_t*>(
+          VirtualAlloc(nullptr, mapped_size,
+                       MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                       PAGE_READWRITE));
+      if (data_) {
+        mapped_size_ = mapped_size;
+        is_huge_page_backed_ = true;
+        return;
+      }
+    }
+#elif defined(__linux__)
+    const auto mapped_size = RoundUp(size, kHugePageSize);
+    // Explicit huge pages only work if the administrator reserved some
+    // (vm.nr_hugepages), so fall back to transparent huge pages.
+    auto ptr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) {
+      is_huge_page_backed_ = true;
+    } else {
+      ptr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (ptr != MAP_FAILED) {
+        is_huge_page_backed_ = madvise(ptr, mapped_size, MADV_HUGEPAGE) == 0;
+      }
+    }
+    if (ptr != MAP_FAILED) {
+      data_ = static_cast<uint8_t*>(ptr);
+      mapped_size_ = mapped_size;
+      // Fault in all pages up front instead of on the first frames.
+      memset(data_, 0, mapped_size_);
+      return;
+    }
+#endif
+  }
+
+  const auto allocation_size = RoundUp(size, alignment);
+#ifdef _WIN32
+  data_ = static_cast<uint8_t*>(_aligned_malloc(allocation_size, alignment));
+#else
+  void* ptr = nullptr;
+  if (posix_memalign(&ptr, alignment, allocation_size) == 0) {
+    data_ = static_cast<uint8_t*>(ptr);
+  }
+#endif
+  if (data_) {
+    memset(data_, 0, allocation_size);
+  } else {
+    size_ = 0;
+  }
+}
+
+AlignedMemory::~AlignedMemory() { Reset(); }
+
+AlignedMemory::AlignedMemory(AlignedMemory&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      mapped_size_(std::exchange(other.mapped_size_, 0)),
+      is_huge_page_backed_(std::exchange(other.is_huge_page_backed_, false)) {}
+
+AlignedMemory& AlignedMemory::operator=(AlignedMemory&& other) noexcept {
+  if (this != &other) {
+    Reset();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    mapped_size_ = std::exchange(other.mapped_size_, 0);
+    is_huge_page_backed_ = std::exchange(other.is_huge_page_backed_, false);
+  }
+  return *this;
+}
+
+void AlignedMemory::Reset() {
+  if (!data_) {
+    return;
+  }
+
+  if (mapped_size_ > 0) {
+#ifdef _WIN32
+    VirtualFree(data_, 0, MEM_RELEASE);
+#else
+    munmap(data_, mapped_size_);
+#endif
+  } else {
+#ifdef _WIN32
+    _aligned_free(data_);
+#else
+    free(data_);
+#endif
+  }
+
+  data_ = nullptr;
+  size_ = 0;
+  mapped_size_ = 0;
+  is_huge_page_backed_ = false;
+}
+
+}  // namespace foxglove
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace foxglove {
+
+// Move-only owner of a zero-initialized, aligned block of memory that can
+// optionally be backed by huge (large) pages.
+class AlignedMemory final {
+ public:
+  static constexpr size_t kDefaultAlignment = 64;
+
+  AlignedMemory() = default;
+  AlignedMemory(size_t size, bool use_huge_pages = false,
+                size_t alignment = kDefaultAlignment);
+  ~AlignedMemory();
+
+  AlignedMemory(const AlignedMemory&) = delete;
+  AlignedMemory& operator=(const AlignedMemory&) = delete;
+  AlignedMemory(AlignedMemory&& other) noexcept;
+  AlignedMemory& operator=(AlignedMemory&& other) noexcept;
+
+  uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool is_huge_page_backed() const { return is_huge_page_backed_; }
+
+  explicit operator bool() const { return data_ != nullptr; }
+
+ private:
+  uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  size_t mapped_size_ = 0;
+  bool is_huge_page_backed_ = false;
+
+  void Reset();
+};
+
+}  // namespace foxglove
@@ -0,0 +1,78 @@
+#include "base/cpu_features.h"
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#include <immintrin.h>
+#define FOXGLOVE_X86 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define FOXGLOVE_X86 1
+#endif
+
+namespace foxglove {
+
+namespace {
+
+#ifdef FOXGLOVE_X86
+
+void CpuId(int leaf, int subleaf, int registers[4]) {
+#ifdef _MSC_VER
+  __cpuidex(registers, leaf, subleaf);
+#else
+  unsigned int eax, ebx, ecx, edx;
+  __cpuid_count(leaf, subleaf, eax, ebx, ecx, edx);
+  registers[0] = eax;
+  registers[1] = ebx;
+  registers[2] = ecx;
+  registers[3] = edx;
+#endif
+}
+
+unsigned long long ReadXcr0() {
+#ifdef _MSC_VER
+  return _xgetbv(0);
+#else
+  unsigned int eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+CpuFeatures DetectCpuFeatures() {
+  CpuFeatures features;
+
+  int registers[4];
+  CpuId(0, 0, registers);
+  const auto max_leaf = registers[0];
+
+  CpuId(1, 0, registers);
+  features.sse2 = (registers[3] & (1 << 26)) != 0;
+
+  const bool has_osxsave = (registers[2] & (1 << 27)) != 0;
+  const bool has_avx = (registers[2] & (1 << 28)) != 0;
+  // The OS has to preserve the YMM registers across context switches.
+  const bool os_supports_ymm =
+      has_osxsave && has_avx && (ReadXcr0() & 0x6) == 0x6;
+
+  if (max_leaf >= 7 && os_supports_ymm) {
+    CpuId(7, 0, registers);
+    features.avx2 = (registers[1] & (1 << 5)) != 0;
+  }
+
+  return features;
+}
+
+#else
+
+CpuFeatures DetectCpuFeatures() { return {}; }
+
+#endif
+
+}  // namespace
+
+const CpuFeatures& GetCpuFeatures() {
+  static const CpuFeatures features = DetectCpuFeatures();
+  return features;
+}
+
+}  // namespace foxglove
@@ -0,0 +1,22 @@
+#pragma once
+
+// Defined if the compiler targets SSE2, which every x64 CPU supports, so
+// code using it needs no runtime check.
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FOXGLOVE_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace foxglove {
+
+struct CpuFeatures {
+  bool sse2 = false;
+  bool avx2 = false;
+};
+
+// Returns the SIMD extensions supported by the CPU and the operating system.
+// Detection runs once on first use.
+const CpuFeatures& GetCpuFeatures();
+
+}  // namespace foxglove
@@ -0,0 +1,192 @@
+#include "base/lz4.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace foxglove {
+namespace lz4 {
+
+namespace {
+
+constexpr size_t kMinMatch = 4;
+// The last match has to start this many bytes before the end of the input
+// and the last this many bytes are always literals, as the format requires.
+constexpr size_t kMatchStartLimit = 12;
+constexpr size_t kLastLiterals = 5;
+constexpr size_t kMaxOffset = 65535;
+
+constexpr int kHashBits = 12;
+// Misses before the search step grows, skipping incompressible data faster.
+constexpr int kSkipShift = 6;
+
+inline uint32_t Read32(const uint8_t* p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint32_t Hash(uint32_t value) {
+  return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+// Writes the part of a length beyond the 4 bits stored in the token.
+inline uint8_t* WriteLength(uint8_t* op, size_t length) {
+  for (; length >= 255; length -= 255) {
+    *op++ = 255;
+  }
+  *op++ = static_cast<uint8_t>(length);
+  return op;
+}
+
+inline bool ReadLength(const uint8_t** ip, const uint8_t* end,
+                       size_t* length) {
+  uint8_t value;
+  do {
+    if (*ip >= end) {
+      return false;
+    }
+    value = *(*ip)++;
+    *length += value;
+  } while (value == 255);
+  return true;
+}
+
+uint8_t* WriteSequence(uint8_t* op, const uint8_t* literals,
+                       size_t literal_length, size_t offset,
+                       size_t match_length) {
+  auto* token = op++;
+  *token = static_cast<uint8_t>(std::min<size_t>(literal_length, 15) << 4);
+  if (literal_length >= 15) {
+    op = WriteLength(op, literal_length - 15);
+  }
+  if (literal_length > 0) {
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+  }
+  if (match_length == 0) {
+    return op;
+  }
+
+  *op++ = static_cast<uint8_t>(offset);
+  *op++ = static_cast<uint8_t>(offset >> 8);
+  const auto length = match_length - kMinMatch;
+  *token |= static_cast<uint8_t>(std::min<size_t>(length, 15));
+  if (length >= 15) {
+    op = WriteLength(op, length - 15);
+  }
+  return op;
+}
+
+}  // namespace
+
+size_t Compress(const uint8_t* src, size_t size, uint8_t* dst,
+                size_t dst_capacity) {
+  if (dst_capacity < CompressBound(size)) {
+    return 0;
+  }
+
+  const auto* end = src + size;
+  const auto* anchor = src;
+  auto* op = dst;
+  if (size > kMatchStartLimit) {
+    uint32_t table[1 << kHashBits] = {};
+    const auto* match_start_limit = end - kMatchStartLimit;
+    const auto* match_end_limit = end - kLastLiterals;
+    const auto* ip = src + 1;
+    uint32_t misses = 0;
+    while (ip < match_start_limit) {
+      const auto hash = Hash(Read32(ip));
+      const auto* candidate = src + table[hash];
+      table[hash] = static_cast<uint32_t>(ip - src);
+      if (static_cast<size_t>(ip - candidate) > kMaxOffset ||
+          Read32(candidate) != Read32(ip)) {
+        ip += 1 + (misses++ >> kSkipShift);
+        continue;
+      }
+
+      while (ip > anchor && candidate > src && ip[-1] == candidate[-1]) {
+        ip--;
+        candidate--;
+      }
+      size_t length = kMinMatch;
+      while (ip + length < match_end_limit && ip[length] == candidate[length]) {
+        length++;
+      }
+
+      op = WriteSequence(op, anchor, ip - anchor, ip - candidate, length);
+      ip += length;
+      anchor = ip;
+      misses = 0;
+      // Lets the next search find repetitions of the data just matched.
+      if (ip < match_start_limit) {
+        table[Hash(Read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - src);
+      }
+    }
+  }
+
+  op = WriteSequence(op, anchor, end - anchor, 0, 0);
+  return op - dst;
+}
+
+bool Decompress(const uint8_t* src, size_t size, uint8_t* dst,
+                size_t dst_size) {
+  const auto* ip = src;
+  const auto* end = src + size;
+  auto* op = dst;
+  const auto* dst_end = dst + dst_size;
+  while (true) {
+    if (ip >= end) {
+      return false;
+    }
+    const auto token = *ip++;
+
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !ReadLength(&ip, end, &literal_length)) {
+      return false;
+    }
+    if (literal_length > static_cast<size_t>(end - ip) ||
+        literal_length > static_cast<size_t>(dst_end - op)) {
+      return false;
+    }
+    if (literal_length > 0) {
+      memcpy(op, ip, literal_length);
+      op += literal_length;
+      ip += literal_length;
+    }
+    // The last sequence has no match.
+    if (ip == end) {
+      return op == dst_end;
+    }
+
+    if (end - ip < 2) {
+      return false;
+    }
+    const size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > static_cast<size_t>(op - dst)) {
+      return false;
+    }
+    size_t length = token & 15;
+    if (length == 15 && !ReadLength(&ip, end, &length)) {
+      return false;
+    }
+    length += kMinMatch;
+    if (length > static_cast<size_t>(dst_end - op)) {
+      return false;
+    }
+
+    const auto* match = op - offset;
+    if (offset >= length) {
+      memcpy(op, match, length);
+    } else {
+      // Overlapping matches repeat the last |offset| bytes.
+      for (size_t i = 0; i < length; i++) {
+        op[i] = match[i];
+      }
+    }
+    op += length;
+  }
+}
+
+}  // namespace lz4
+}  // namespace foxglove
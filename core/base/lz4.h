@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Compressor and decompressor for the LZ4 block format, compatible with the
+// reference implementation. Favors speed over ratio like LZ4's default mode.
+
+namespace foxglove {
+namespace lz4 {
+
+// Returns the largest possible compressed size of |size| bytes.
+constexpr size_t CompressBound(size_t size) { return size + size / 255 + 16; }
+
+// Compresses |size| bytes of |src| into |dst|, which has to hold at least
+// CompressBound(size) bytes. Returns the compressed size, or 0 if |dst| is
+// too small.
+size_t Compress(const uint8_t* src, size_t size, uint8_t* dst,
+                size_t dst_capacity);
+
+// Returns false if |src| is malformed or doesn't decompress to exactly
+// |dst_size| bytes. Never reads or writes out of bounds.
+bool Decompress(const uint8_t* src, size_t size, uint8_t* dst,
+                size_t dst_size);
+
+}  // namespace lz4
+}  // namespace foxglove
@@ -0,0 +1,206 @@
+#include "base/sequential_file_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <optional>
+
+#ifdef _WIN32
+#include <Windows.h>
+
+#include "base/string_utils.h"
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace foxglove {
+
+namespace {
+
+#ifdef _WIN32
+ErrorDetails LastError(std::string_view message) {
+  return ErrorDetails::FromHResult(HRESULT_FROM_WIN32(GetLastError()),
+                                   message);
+}
+#else
+ErrorDetails LastError(std::string_view message) {
+  const auto error = errno;
+  return ErrorDetails(message, strerror(error), error);
+}
+#endif
+
+}  // namespace
+
+SequentialFileWriter::~SequentialFileWriter() { Close().IgnoreError(); }
+
+bool SequentialFileWriter::is_open() const {
+#ifdef _WIN32
+  return handle_ != nullptr;
+#else
+  return fd_ >= 0;
+#endif
+}
+
+Status<ErrorDetails> SequentialFileWriter::Open(const std::string& path,
+                                                bool unbuffered_io,
+                                                size_t chunk_size) {
+  if (is_open()) {
+    return ErrorDetails("File is already open");
+  }
+
+  chunk_size = std::max(kBlockSize, chunk_size / kBlockSize * kBlockSize);
+  chunk_ = AlignedMemory(chunk_size, false, kBlockSize);
+  if (!chunk_) {
+    return ErrorDetails("Allocating write buffer failed");
+  }
+  chunk_used_ = 0;
+  position_ = 0;
+
+#ifdef _WIN32
+  DWORD flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN;
+  if (unbuffered_io) {
+    flags |= FILE_FLAG_NO_BUFFERING;
+  }
+  auto handle = CreateFileW(util::Utf16FromUtf8(path).c_str(), GENERIC_WRITE,
+                            FILE_SHARE_READ, nullptr, CREATE_ALWAYS, flags,
+                            nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return LastError("Opening file failed");
+  }
+  handle_ = handle;
+  unbuffered_io_ = unbuffered_io;
+#else
+  const auto flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+  unbuffered_io_ = false;
+#ifdef O_DIRECT
+  if (unbuffered_io) {
+    // Fails with EINVAL on file systems without direct I/O, e.g. tmpfs.
+    fd_ = open(path.c_str(), flags | O_DIRECT, 0644);
+    unbuffered_io_ = fd_ >= 0;
+  }
+#endif
+  if (fd_ < 0) {
+    fd_ = open(path.c_str(), flags, 0644);
+  }
+  if (fd_ < 0) {
+    return LastError("Opening file failed");
+  }
+#endif
+
+  return OkStatus();
+}
+
+Status<ErrorDetails> SequentialFileWriter::Write(const void* data,
+                                                 size_t size) {
+  if (!is_open()) {
+    return ErrorDetails("File is not open");
+  }
+
+  auto bytes = static_cast<const uint8_t*>(data);
+  // Large writes don't need to go through the chunk unless it has to keep
+  // them aligned.
+  if (!unbuffered_io_ && chunk_used_ == 0 && size >= chunk_.size()) {
+    auto status = WriteFully(bytes, size);
+    if (status.ok()) {
+      position_ += size;
+    }
+    return status;
+  }
+
+  while (size > 0) {
+    const auto count = std::min(size, chunk_.size() - chunk_used_);
+    memcpy(chunk_.data() + chunk_used_, bytes, count);
+    chunk_used_ += count;
+    position_ += count;
+    bytes += count;
+    size -= count;
+
+    if (chunk_used_ == chunk_.size()) {
+      auto status = WriteFully(chunk_.data(), chunk_used_);
+      if (!status.ok()) {
+        return status;
+      }
+      chunk_used_ = 0;
+    }
+  }
+  return OkStatus();
+}
+
+Status<ErrorDetails> SequentialFileWriter::WriteFully(const uint8_t* data,
+                                                      size_t size) {
+  while (size > 0) {
+#ifdef _WIN32
+    DWORD written = 0;
+    const auto count = static_cast<DWORD>(
+        std::min<size_t>(size, std::numeric_limits<DWORD>::max() &
+                                   ~static_cast<DWORD>(kBlockSize - 1)));
+    if (!WriteFile(handle_, data, count, &written, nullptr)) {
+      return LastError("Writing file failed");
+    }
+#else
+    const auto written = write(fd_, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return LastError("Writing file failed");
+    }
+#endif
+    data += written;
+    size -= written;
+  }
+  return OkStatus();
+}
+
+Status<ErrorDetails> SequentialFileWriter::Close() {
+  if (!is_open()) {
+    return OkStatus();
+  }
+
+  std::optional<ErrorDetails> error;
+  if (chunk_used_ > 0) {
+    // Unbuffered writes have to cover whole blocks, the padding gets cut
+    // off again below.
+    const auto size =
+        unbuffered_io_
+            ? (chunk_used_ + kBlockSize - 1) / kBlockSize * kBlockSize
+            : chunk_used_;
+    memset(chunk_.data() + chunk_used_, 0, size - chunk_used_);
+    auto status = WriteFully(chunk_.data(), size);
+    if (!status.ok()) {
+      error.emplace(status.error());
+    }
+    chunk_used_ = 0;
+  }
+
+#ifdef _WIN32
+  if (unbuffered_io_) {
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(position_);
+    if ((!SetFilePointerEx(handle_, end, nullptr, FILE_BEGIN) ||
+         !SetEndOfFile(handle_)) &&
+        !error) {
+      error.emplace(LastError("Truncating file failed"));
+    }
+  }
+  CloseHandle(handle_);
+  handle_ = nullptr;
+#else
+  if (unbuffered_io_ && ftruncate(fd_, static_cast<off_t>(position_)) != 0 &&
+      !error) {
+    error.emplace(LastError("Truncating file failed"));
+  }
+  close(fd_);
+  fd_ = -1;
+#endif
+  chunk_ = AlignedMemory();
+
+  if (error) {
+    return error.value();
+  }
+  return OkStatus();
+}
+
+}  // namespace foxglove
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "base/aligned_memory.h"
+#include "base/error_details.h"
+#include "base/status.h"
+
+namespace foxglove {
+
+// Append-only file writer that issues large, aligned writes. With
+// |unbuffered_io| the OS page cache is bypassed (O_DIRECT,
+// FILE_FLAG_NO_BUFFERING) where the file system supports it.
+class SequentialFileWriter final {
+ public:
+  static constexpr size_t kDefaultChunkSize = 4 * 1024 * 1024;
+
+  SequentialFileWriter() = default;
+  ~SequentialFileWriter();
+
+  SequentialFileWriter(const SequentialFileWriter&) = delete;
+  SequentialFileWriter& operator=(const SequentialFileWriter&) = delete;
+
+  // Creates or truncates |path|.
+  Status<ErrorDetails> Open(const std::string& path, bool unbuffered_io = false,
+                            size_t chunk_size = kDefaultChunkSize);
+  Status<ErrorDetails> Write(const void* data, size_t size);
+  // Writes out any buffered data.
+  Status<ErrorDetails> Close();
+
+  bool is_open() const;
+  // Number of bytes written so far.
+  uint64_t position() const { return position_; }
+
+ private:
+  // O_DIRECT requires the buffer, size and file offset to be aligned to the
+  // logical block size, which never exceeds this.
+  static constexpr size_t kBlockSize = 4096;
+
+#ifdef _WIN32
+  void* handle_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+  bool unbuffered_io_ = false;
+  AlignedMemory chunk_;
+  size_t chunk_used_ = 0;
+  uint64_t position_ = 0;
+
+  Status<ErrorDetails> WriteFully(const uint8_t* data, size_t size);
+};
+
+}  // namespace foxglove
@@ -54,15 +54,14 @@ void TaskQueue::Run() {
       return;
     }
 
-    std::deque<Closure> tasks;
-    pending_tasks_.swap(tasks);
+    // Take one task at a time so that other workers can pick up the rest.
+    auto task = std::move(pending_tasks_.front());
+    pending_tasks_.pop_front();
     lock.unlock();
 
-    LOG(TRACE) << "Attempting to run tasks" << std::endl;
-    for (const auto& task : tasks) {
-      task();
-    }
-    LOG(TRACE) << "Ran tasks" << std::endl;
+    LOG(TRACE) << "Attempting to run task" << std::endl;
+    task();
+    LOG(TRACE) << "Ran task" << std::endl;
   }
 }
 }  // namespace foxglove
@@ -48,7 +48,7 @@ class TaskQueue {
   }
 
  private:
-  std::atomic<bool> terminated_;
+  std::atomic<bool> terminated_ = false;
   std::optional<std::string> thread_name_;
   std::vector<std::thread> workers_;
   std::mutex task_pending_mutex_;
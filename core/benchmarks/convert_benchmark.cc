@@ -0,0 +1,350 @@
+// Measures the throughput of every conversion kernel set on a synthetic
+// 1080p picture. Given a media file, also compares converting I420 or NV12
+// ourselves with letting VLC convert to RGBA in its vout (swscale).
+//
+//   convert_benchmark [media_path]
+//
+// Built with -DFOXGLOVE_BUILD_BENCHMARKS=ON.
+
+#include <vlc/vlc.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "base/cpu_features.h"
+#include "video/convert/convert.h"
+#include "video/convert/convert_kernels.h"
+#include "video/frame_buffer.h"
+#include "vlc/vlc_chroma.h"
+
+namespace foxglove {
+namespace {
+
+constexpr uint32_t kWidth = 1920;
+constexpr uint32_t kHeight = 1080;
+constexpr int kIterations = 50;
+constexpr uint64_t kVlcFrames = 500;
+
+// Limited range BT.709, the same values convert.cc uses.
+constexpr convert::YuvCoefficients kBt709 = {9539, 14688, -1745, -4365,
+                                             17302};
+
+template <typename Function>
+void Measure(const char* kernels, const char* name, Function&& function) {
+  // Warms up caches and page mappings.
+  function();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; i++) {
+    function();
+  }
+  const auto elapsed = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start);
+  const auto ms = elapsed.count() / kIterations;
+  printf("%-8s %-18s %7.2f ms %8.0f Mpixel/s\n", kernels, name, ms,
+         kWidth * kHeight / ms / 1000);
+}
+
+void BenchmarkKernels(const convert::ConvertKernels& kernels) {
+  std::vector<uint8_t> y(kWidth * kHeight);
+  std::vector<uint8_t> u(kWidth * kHeight / 4);
+  std::vector<uint8_t> v(kWidth * kHeight / 4);
+  std::vector<uint8_t> uv(kWidth * kHeight / 2);
+  std::vector<uint8_t> rgba(kWidth * kHeight * 4);
+  std::vector<uint8_t> dst(kWidth * kHeight * 4);
+  std::vector<float> dst_float(kWidth * kHeight * 3);
+  std::mt19937 random(1);
+  for (auto* buffer : {&y, &u, &v, &uv, &rgba}) {
+    for (auto& value : *buffer) {
+      value = static_cast<uint8_t>(random());
+    }
+  }
+
+  const auto pitch = kWidth * 4;
+  const auto name = kernels.name;
+  Measure(name, "i420 -> rgba", [&] {
+    for (uint32_t row = 0; row < kHeight; row++) {
+      const auto chroma = (row / 2) * (kWidth / 2);
+      kernels.i420_row(&y[row * kWidth], &u[chroma], &v[chroma],
+                       &dst[row * pitch], kWidth, kBt709, false);
+    }
+  });
+  Measure(name, "nv12 -> rgba", [&] {
+    for (uint32_t row = 0; row < kHeight; row++) {
+      kernels.nv12_row(&y[row * kWidth], &uv[(row / 2) * kWidth],
+                       &dst[row * pitch], kWidth, kBt709, false);
+    }
+  });
+  Measure(name, "rgba <-> bgra", [&] {
+    for (uint32_t row = 0; row < kHeight; row++) {
+      kernels.swizzle_row(&rgba[row * pitch], &dst[row * pitch], kWidth);
+    }
+  });
+  Measure(name, "rgba -> gray", [&] {
+    for (uint32_t row = 0; row < kHeight; row++) {
+      kernels.gray_row(&rgba[row * pitch], &dst[row * kWidth], kWidth,
+                       false);
+    }
+  });
+  Measure(name, "blend rows", [&] {
+    for (uint32_t row = 0; row + 1 < kHeight; row++) {
+      kernels.blend_row(&rgba[row * pitch], &rgba[(row + 1) * pitch],
+                        &dst[row * pitch], pitch, convert::kScaleOne / 3);
+    }
+  });
+  std::vector<convert::ScaleTap> taps(kWidth);
+  for (uint32_t x = 0; x < kWidth; x++) {
+    taps[x] = {x * 2 / 3, (x * 85) % convert::kScaleOne};
+  }
+  Measure(name, "scale rows", [&] {
+    for (uint32_t row = 0; row < kHeight; row++) {
+      kernels.scale_row(&rgba[row * pitch], &dst[row * pitch], kWidth,
+                        taps.data());
+    }
+  });
+  Measure(name, "halve", [&] {
+    for (uint32_t row = 0; row < kHeight / 2; row++) {
+      kernels.halve_row(&rgba[row * 2 * pitch], &rgba[(row * 2 + 1) * pitch],
+                        &dst[row * pitch], kWidth / 2);
+    }
+  });
+  Measure(name, "planarize", [&] {
+    for (uint32_t row = 0; row < kHeight; row++) {
+      uint8_t* planes[3];
+      for (uint32_t c = 0; c < 3; c++) {
+        planes[c] = &dst[(c * kHeight + row) * kWidth];
+      }
+      kernels.planar_row(&rgba[row * pitch], planes, kWidth);
+    }
+  });
+  const float scale[3] = {1 / 255.f, 1 / 255.f, 1 / 255.f};
+  const float bias[3] = {-0.5f, -0.5f, -0.5f};
+  Measure(name, "planarize float", [&] {
+    for (uint32_t row = 0; row < kHeight; row++) {
+      float* planes[3];
+      for (uint32_t c = 0; c < 3; c++) {
+        planes[c] = &dst_float[(c * kHeight + row) * kWidth];
+      }
+      kernels.planar_float_row(&rgba[row * pitch], planes, kWidth, scale,
+                               bias);
+    }
+  });
+}
+
+// CPU time of the calling thread in microseconds.
+int64_t ThreadCpuTimeUs() {
+#if defined(_WIN32)
+  FILETIME creation, exit, kernel, user;
+  GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+  const auto to_us = [](const FILETIME& time) {
+    return ((static_cast<int64_t>(time.dwHighDateTime) << 32) |
+            time.dwLowDateTime) /
+           10;
+  };
+  return to_us(kernel) + to_us(user);
+#else
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return static_cast<int64_t>(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+#endif
+}
+
+// Plays |path| without audio and measures the vout thread's CPU time per
+// picture, which covers VLC's chroma conversion and ours.
+class VoutRun {
+ public:
+  // Requests RGBA from VLC if |convert_ourselves| is false, the decoder's
+  // chroma otherwise.
+  explicit VoutRun(bool convert_ourselves)
+      : convert_ourselves_(convert_ourselves) {}
+
+  bool Run(libvlc_instance_t* instance, const char* path) {
+    auto* media = libvlc_media_new_path(path);
+    if (!media) {
+      return false;
+    }
+    libvlc_media_add_option(media, ":no-audio");
+    auto* player = libvlc_media_player_new_from_media(instance, media);
+    libvlc_media_release(media);
+    if (!player) {
+      return false;
+    }
+
+    libvlc_video_set_callbacks(
+        player,
+        [](void* opaque, void** planes) -> void* {
+          return static_cast<VoutRun*>(opaque)->Lock(planes);
+        },
+        nullptr,
+        [](void* opaque, void*) { static_cast<VoutRun*>(opaque)->Display(); },
+        this);
+    libvlc_video_set_format_callbacks(
+        player,
+        [](void** opaque, char* chroma, unsigned* width, unsigned* height,
+           unsigned* pitches, unsigned* lines) -> unsigned {
+          return static_cast<VoutRun*>(*opaque)->Setup(chroma, width, height,
+                                                       pitches, lines);
+        },
+        nullptr);
+
+    // Short media ends before kVlcFrames pictures were shown.
+    auto* event_manager = libvlc_media_player_event_manager(player);
+    for (auto event :
+         {libvlc_MediaPlayerStopping, libvlc_MediaPlayerEncounteredError}) {
+      libvlc_event_attach(
+          event_manager, event,
+          [](const libvlc_event_t*, void* opaque) {
+            static_cast<VoutRun*>(opaque)->Finish();
+          },
+          this);
+    }
+
+    if (libvlc_media_player_play(player) == 0) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return is_done_; });
+    }
+    libvlc_media_player_stop_async(player);
+    // Joins the vout thread, so the counters are stable afterwards.
+    libvlc_media_player_release(player);
+    return frames_ > 1;
+  }
+
+  const char* chroma() const { return ToVlcChroma(vlc_format_); }
+  double cpu_us_per_frame() const {
+    return static_cast<double>(cpu_us_) / (frames_ - 1);
+  }
+
+ private:
+  bool convert_ourselves_;
+  PixelFormat vlc_format_ = PixelFormat::kNone;
+  std::unique_ptr<FrameBuffer> picture_;
+  std::unique_ptr<FrameBuffer> rgba_;
+  uint64_t frames_ = 0;
+  int64_t first_cpu_us_ = 0;
+  int64_t cpu_us_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool is_done_ = false;
+
+  unsigned Setup(char* chroma, unsigned* width, unsigned* height,
+                 unsigned* pitches, unsigned* lines) {
+    vlc_format_ = PixelFormat::kFormatRGBA;
+    const auto native_format = FromVlcChroma(chroma);
+    if (convert_ourselves_ && IsPlanarFormat(native_format)) {
+      vlc_format_ = native_format;
+    }
+    memcpy(chroma, ToVlcChroma(vlc_format_), 4);
+
+    const auto layout = ComputeFrameLayout(vlc_format_, *width, *height);
+    picture_ = std::make_unique<FrameBuffer>(
+        vlc_format_, VideoDimensions(*width, *height, layout.pitches[0]),
+        layout);
+    const auto rgba_layout =
+        ComputeFrameLayout(PixelFormat::kFormatRGBA, *width, *height);
+    rgba_ = std::make_unique<FrameBuffer>(
+        PixelFormat::kFormatRGBA,
+        VideoDimensions(*width, *height, rgba_layout.pitches[0]),
+        rgba_layout);
+    for (uint32_t i = 0; i < layout.plane_count; i++) {
+      pitches[i] = layout.pitches[i];
+      lines[i] = layout.lines[i];
+    }
+    return 1;
+  }
+
+  void* Lock(void** planes) {
+    picture_->GetPlanes(planes);
+    return nullptr;
+  }
+
+  void Display() {
+    if (vlc_format_ != PixelFormat::kFormatRGBA) {
+      const uint8_t* src_planes[kMaxPlanes] = {};
+      uint8_t* dst_planes[kMaxPlanes] = {rgba_->plane(0)};
+      for (uint32_t i = 0; i < picture_->plane_count(); i++) {
+        src_planes[i] = picture_->plane(i);
+      }
+      const auto& dimensions = picture_->dimensions();
+      convert::ConvertPicture(vlc_format_, src_planes, picture_->layout(),
+                              PixelFormat::kFormatRGBA, dst_planes,
+                              rgba_->layout(), dimensions.width,
+                              dimensions.height,
+                              DefaultYuvMatrix(dimensions.height));
+    }
+
+    // The first picture also pays for setting up the vout.
+    const auto now = ThreadCpuTimeUs();
+    if (frames_++ == 0) {
+      first_cpu_us_ = now;
+      return;
+    }
+    cpu_us_ = now - first_cpu_us_;
+    if (frames_ == kVlcFrames) {
+      Finish();
+    }
+  }
+
+  void Finish() {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    is_done_ = true;
+    cv_.notify_one();
+  }
+};
+
+void CompareWithVlc(const char* path) {
+  const char* const arguments[] = {"--no-audio"};
+  auto* instance = libvlc_new(1, arguments);
+  if (!instance) {
+    fprintf(stderr, "Creating libvlc instance failed\n");
+    return;
+  }
+
+  VoutRun vlc_run(false);
+  VoutRun our_run(true);
+  if (vlc_run.Run(instance, path) && our_run.Run(instance, path)) {
+    printf("\nvout thread CPU time per picture of %s:\n", path);
+    printf("  VLC converting to RGBA      %8.0f us\n",
+           vlc_run.cpu_us_per_frame());
+    printf("  %s converted by %-8s %8.0f us\n", our_run.chroma(),
+           convert::ActiveKernelName(), our_run.cpu_us_per_frame());
+  } else {
+    fprintf(stderr, "Playing %s failed\n", path);
+  }
+  libvlc_release(instance);
+}
+
+}  // namespace
+}  // namespace foxglove
+
+int main(int argc, char** argv) {
+  using namespace foxglove;
+
+  printf("%ux%u, %d iterations, active kernels: %s\n", kWidth, kHeight,
+         kIterations, convert::ActiveKernelName());
+  BenchmarkKernels(convert::GetScalarKernels());
+  // Kernels the CPU can't run are skipped.
+  const auto& features = GetCpuFeatures();
+  if (features.sse2 && convert::GetSse2Kernels()) {
+    BenchmarkKernels(*convert::GetSse2Kernels());
+  }
+  if (features.avx2 && convert::GetAvx2Kernels()) {
+    BenchmarkKernels(*convert::GetAvx2Kernels());
+  }
+
+  if (argc > 1) {
+    CompareWithVlc(argv[1]);
+  }
+  return 0;
+}
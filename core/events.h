@@ -1,7 +1,12 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
+#include "video/video_dimensions.h"
+
 namespace foxglove {
 
 enum class PlaybackState {
@@ -17,4 +22,39 @@ enum class PlaybackState {
 
 std::string PlaybackStateToString(PlaybackState state);
 
+struct MotionEvent {
+  // Share of the picture that changed since the previous frame, 0 to 1.
+  double level = 0;
+  // Whether |level| exceeds the detector's threshold. Events get raised when
+  // motion starts and stops, and periodically while it lasts.
+  bool is_motion = false;
+  // Bounding box of the changed areas in picture coordinates, empty if
+  // there's no motion.
+  VideoRect region;
+  // Media time of the frame in microseconds, -1 if unknown.
+  int64_t pts_us = -1;
+};
+
+enum class VideoSignalCondition { kBlack, kFrozen };
+
+struct VideoSignalEvent {
+  VideoSignalCondition condition = VideoSignalCondition::kBlack;
+  // True once the condition lasted for its configured duration, false on
+  // the first analyzed frame it no longer holds for.
+  bool is_active = false;
+  // Media time of the frame in microseconds, -1 if unknown.
+  int64_t pts_us = -1;
+};
+
+// Channels beyond this aren't metered.
+constexpr size_t kMaxMeteredChannels = 8;
+
+struct AudioLevelEvent {
+  uint32_t channels = 0;
+  // Smoothed linear levels of each channel relative to full scale, 0 to 1
+  // (20 * log10(level) gives dBFS).
+  std::array<float, kMaxMeteredChannels> peak{};
+  std::array<float, kMaxMeteredChannels> rms{};
+};
+
 }  // namespace foxglove
@@ -30,6 +30,12 @@ class PlayerEventDelegate {
   virtual void OnVolumeChanged(double volume) {}
   virtual void OnMute(bool is_muted) {}
   virtual void OnVideoDimensionsChanged(int32_t width, int32_t height) {}
+  // Only raised while motion detection is enabled, on the vout thread.
+  virtual void OnMotion(const MotionEvent& /*event*/) {}
+  // Only raised while video signal detection is enabled, on the vout thread.
+  virtual void OnVideoSignal(const VideoSignalEvent& /*event*/) {}
+  // Only raised while audio level metering is enabled, on the audio thread.
+  virtual void OnAudioLevel(const AudioLevelEvent& /*event*/) {}
 };
 
 template <typename TVideoOutput>
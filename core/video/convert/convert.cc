@@ -0,0 +1,245 @@
+#include "video/convert/convert.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/cpu_features.h"
+#include "video/convert/convert_kernels.h"
+
+namespace foxglove {
+namespace convert {
+
+namespace {
+
+// Limited range coefficients scaled by 1 << kYuvShift.
+constexpr YuvCoefficients kBt601 = {9539, 13075, -3209, -6660, 16525};
+constexpr YuvCoefficients kBt709 = {9539, 14688, -1745, -4365, 17302};
+
+const ConvertKernels& SelectKernels() {
+  const auto& features = GetCpuFeatures();
+  if (features.avx2) {
+    if (auto kernels = GetAvx2Kernels()) {
+      return *kernels;
+    }
+  }
+  if (features.sse2) {
+    if (auto kernels = GetSse2Kernels()) {
+      return *kernels;
+    }
+  }
+  return GetScalarKernels();
+}
+
+const ConvertKernels& Kernels() {
+  static const ConvertKernels& kernels = SelectKernels();
+  return kernels;
+}
+
+const YuvCoefficients& CoefficientsFor(YuvMatrix matrix) {
+  return matrix == YuvMatrix::kBt709 ? kBt709 : kBt601;
+}
+
+// Maps destination pixels to source pixels with aligned centers.
+std::vector<ScaleTap> ComputeTaps(uint32_t src_size, uint32_t dst_size) {
+  std::vector<ScaleTap> taps(dst_size);
+  const int64_t step = (static_cast<int64_t>(src_size) << 16) / dst_size;
+  for (uint32_t i = 0; i < dst_size; i++) {
+    auto position = std::max<int64_t>(i * step + step / 2 - (1 << 15), 0);
+    auto& tap = taps[i];
+    tap.x = static_cast<uint32_t>(position >> 16);
+    tap.weight =
+        static_cast<uint32_t>((position & 0xffff) >> (16 - kScaleShift));
+    // The right neighbor has to exist, so sample the edge with full weight.
+    if (src_size < 2) {
+      tap = {0, 0};
+    } else if (tap.x >= src_size - 1) {
+      tap = {src_size - 2, kScaleOne};
+    }
+  }
+  return taps;
+}
+
+bool IsRgb(PixelFormat format) {
+  return format == PixelFormat::kFormatRGBA ||
+         format == PixelFormat::kFormatBGRA;
+}
+
+// Copies every plane row by row, so the pitches may differ.
+void CopyPicture(PixelFormat format, const uint8_t* const* src_planes,
+                 const FrameLayout& src_layout, uint8_t* const* dst_planes,
+                 const FrameLayout& dst_layout, uint32_t width,
+                 uint32_t height) {
+  const uint32_t chroma_width = (width + 1) / 2;
+  const uint32_t chroma_height = (height + 1) / 2;
+  for (uint32_t plane = 0; plane < src_layout.plane_count; plane++) {
+    uint32_t row_size = IsPlanarFormat(format) ? width : width * 4;
+    uint32_t rows = height;
+    if (plane > 0) {
+      row_size = format == PixelFormat::kFormatNV12 ? chroma_width * 2
+                                                    : chroma_width;
+      rows = chroma_height;
+    }
+    for (uint32_t y = 0; y < rows; y++) {
+      memcpy(dst_planes[plane] + y * dst_layout.pitches[plane],
+             src_planes[plane] + y * src_layout.pitches[plane], row_size);
+    }
+  }
+}
+
+}  // namespace
+
+const char* ActiveKernelName() { return Kernels().name; }
+
+void SwizzleRgbaBgra(const uint8_t* src, uint32_t src_pitch, uint8_t* dst,
+                     uint32_t dst_pitch, uint32_t width, uint32_t height) {
+  const auto swizzle_row = Kernels().swizzle_row;
+  for (uint32_t y = 0; y < height; y++) {
+    swizzle_row(src + y * src_pitch, dst + y * dst_pitch, width);
+  }
+}
+
+void I420ToRgba(const uint8_t* src_y, uint32_t src_pitch_y,
+                const uint8_t* src_u, uint32_t src_pitch_u,
+                const uint8_t* src_v, uint32_t src_pitch_v, uint8_t* dst,
+                uint32_t dst_pitch, uint32_t width, uint32_t height,
+                bool bgra, YuvMatrix matrix) {
+  const auto i420_row = Kernels().i420_row;
+  const auto& coefficients = CoefficientsFor(matrix);
+  for (uint32_t y = 0; y < height; y++) {
+    i420_row(src_y + y * src_pitch_y, src_u + (y / 2) * src_pitch_u,
+             src_v + (y / 2) * src_pitch_v, dst + y * dst_pitch, width,
+             coefficients, bgra);
+  }
+}
+
+void Nv12ToRgba(const uint8_t* src_y, uint32_t src_pitch_y,
+                const uint8_t* src_uv, uint32_t src_pitch_uv, uint8_t* dst,
+                uint32_t dst_pitch, uint32_t width, uint32_t height,
+                bool bgra, YuvMatrix matrix) {
+  const auto nv12_row = Kernels().nv12_row;
+  const auto& coefficients = CoefficientsFor(matrix);
+  for (uint32_t y = 0; y < height; y++) {
+    nv12_row(src_y + y * src_pitch_y, src_uv + (y / 2) * src_pitch_uv,
+             dst + y * dst_pitch, width, coefficients, bgra);
+  }
+}
+
+void HalveRgba(const uint8_t* src, uint32_t src_pitch, uint8_t* dst,
+               uint32_t dst_pitch, uint32_t dst_width, uint32_t dst_height) {
+  const auto halve_row = Kernels().halve_row;
+  for (uint32_t y = 0; y < dst_height; y++) {
+    const auto* row = src + static_cast<size_t>(y) * 2 * src_pitch;
+    halve_row(row, row + src_pitch, dst + static_cast<size_t>(y) * dst_pitch,
+              dst_width);
+  }
+}
+
+void RgbaToGray(const uint8_t* src, uint32_t src_pitch, uint8_t* dst,
+                uint32_t dst_pitch, uint32_t width, uint32_t height,
+                bool bgra) {
+  const auto gray_row = Kernels().gray_row;
+  for (uint32_t y = 0; y < height; y++) {
+    gray_row(src + y * src_pitch, dst + y * dst_pitch, width, bgra);
+  }
+}
+
+void PlanarizeRow(const uint8_t* src, uint8_t* const* dst, uint32_t width) {
+  Kernels().planar_row(src, dst, width);
+}
+
+void PlanarizeRowFloat(const uint8_t* src, float* const* dst, uint32_t width,
+                       const float* scale, const float* bias) {
+  Kernels().planar_float_row(src, dst, width, scale, bias);
+}
+
+RgbaScaler::RgbaScaler(uint32_t src_width, uint32_t src_height,
+                       uint32_t dst_width, uint32_t dst_height)
+    : src_width_(src_width),
+      src_height_(src_height),
+      dst_width_(dst_width),
+      dst_height_(dst_height),
+      column_taps_(ComputeTaps(src_width, dst_width)),
+      row_taps_(ComputeTaps(src_height, dst_height)),
+      row_buffer_((static_cast<size_t>(src_width) + 1) * 4) {}
+
+void RgbaScaler::Scale(const uint8_t* src, uint32_t src_pitch, uint8_t* dst,
+                       uint32_t dst_pitch) {
+  for (uint32_t y = 0; y < dst_height_; y++) {
+    ScaleRow(src, src_pitch, y, dst + static_cast<size_t>(y) * dst_pitch);
+  }
+}
+
+void RgbaScaler::ScaleRow(const uint8_t* src, uint32_t src_pitch, uint32_t y,
+                          uint8_t* dst) {
+  const auto& kernels = Kernels();
+  const auto row_size = src_width_ * 4;
+  const bool same_width = src_width_ == dst_width_;
+  const auto& row_tap = row_taps_[y];
+  const auto* row = src + static_cast<size_t>(row_tap.x) * src_pitch;
+  if (row_tap.weight == 0 && same_width) {
+    memcpy(dst, row, row_size);
+    return;
+  }
+  // Single pixel rows go through the padded buffer as well, so the
+  // horizontal pass never reads past the picture.
+  if (row_tap.weight != 0 || src_width_ < 2) {
+    const auto* next_row = row_tap.weight != 0 ? row + src_pitch : row;
+    kernels.blend_row(row, next_row, row_buffer_.data(), row_size,
+                      row_tap.weight);
+    row = row_buffer_.data();
+  }
+  if (same_width) {
+    memcpy(dst, row, row_size);
+  } else {
+    kernels.scale_row(row, dst, dst_width_, column_taps_.data());
+  }
+}
+
+bool CanConvert(PixelFormat src, PixelFormat dst) {
+  if (src == dst) {
+    return src != PixelFormat::kNone;
+  }
+  if (!IsRgb(dst)) {
+    return false;
+  }
+  return IsRgb(src) || src == PixelFormat::kFormatI420 ||
+         src == PixelFormat::kFormatNV12;
+}
+
+bool ConvertPicture(PixelFormat src_format, const uint8_t* const* src_planes,
+                    const FrameLayout& src_layout, PixelFormat dst_format,
+                    uint8_t* const* dst_planes, const FrameLayout& dst_layout,
+                    uint32_t width, uint32_t height, YuvMatrix matrix) {
+  if (!CanConvert(src_format, dst_format)) {
+    return false;
+  }
+
+  if (src_format == dst_format) {
+    CopyPicture(src_format, src_planes, src_layout, dst_planes, dst_layout,
+                width, height);
+    return true;
+  }
+
+  const bool bgra = dst_format == PixelFormat::kFormatBGRA;
+  const auto& src_pitches = src_layout.pitches;
+  const auto dst_pitch = dst_layout.pitches[0];
+
+  switch (src_format) {
+    case PixelFormat::kFormatI420:
+      I420ToRgba(src_planes[0], src_pitches[0], src_planes[1], src_pitches[1],
+                 src_planes[2], src_pitches[2], dst_planes[0], dst_pitch,
+                 width, height, bgra, matrix);
+      return true;
+    case PixelFormat::kFormatNV12:
+      Nv12ToRgba(src_planes[0], src_pitches[0], src_planes[1], src_pitches[1],
+                 dst_planes[0], dst_pitch, width, height, bgra, matrix);
+      return true;
+    default:
+      SwizzleRgbaBgra(src_planes[0], src_pitches[0], dst_planes[0],
+                      dst_pitch, width, height);
+      return true;
+  }
+}
+
+}  // namespace convert
+}  // namespace foxglove
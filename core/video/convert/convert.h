@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "video/convert/convert_kernels.h"
+#include "video/frame_descriptor.h"
+#include "video/frame_layout.h"
+
+namespace foxglove {
+namespace convert {
+
+// Name of the kernel set selected for this CPU ("avx2", "sse2" or "scalar").
+const char* ActiveKernelName();
+
+// Swaps the R and B channels. |src| and |dst| may be the same buffer.
+void SwizzleRgbaBgra(const uint8_t* src, uint32_t src_pitch, uint8_t* dst,
+                     uint32_t dst_pitch, uint32_t width, uint32_t height);
+
+void I420ToRgba(const uint8_t* src_y, uint32_t src_pitch_y,
+                const uint8_t* src_u, uint32_t src_pitch_u,
+                const uint8_t* src_v, uint32_t src_pitch_v, uint8_t* dst,
+                uint32_t dst_pitch, uint32_t width, uint32_t height,
+                bool bgra, YuvMatrix matrix);
+
+void Nv12ToRgba(const uint8_t* src_y, uint32_t src_pitch_y,
+                const uint8_t* src_uv, uint32_t src_pitch_uv, uint8_t* dst,
+                uint32_t dst_pitch, uint32_t width, uint32_t height,
+                bool bgra, YuvMatrix matrix);
+
+// Computes full range BT.601 luma from RGBA (or BGRA if |bgra| is set).
+void RgbaToGray(const uint8_t* src, uint32_t src_pitch, uint8_t* dst,
+                uint32_t dst_pitch, uint32_t width, uint32_t height,
+                bool bgra);
+
+// Returns whether ConvertPicture() supports converting |src| to |dst|. Any
+// format can be copied to itself.
+bool CanConvert(PixelFormat src, PixelFormat dst);
+
+// Converts a |width| x |height| picture between two layouts. Only the
+// pitches of |src_layout| are used, so |src_planes| may point into a larger
+// picture. YUV pictures are converted with |matrix|, which has to describe
+// the source video rather than the possibly cropped or scaled picture.
+// Returns false if the conversion isn't supported.
+bool ConvertPicture(PixelFormat src_format, const uint8_t* const* src_planes,
+                    const FrameLayout& src_layout, PixelFormat dst_format,
+                    uint8_t* const* dst_planes, const FrameLayout& dst_layout,
+                    uint32_t width, uint32_t height, YuvMatrix matrix);
+
+// Averages 2x2 blocks of four byte pixels (RGBA or BGRA), producing a
+// |dst_width| x |dst_height| picture from twice as many source pixels in
+// each direction. May run in place.
+void HalveRgba(const uint8_t* src, uint32_t src_pitch, uint8_t* dst,
+               uint32_t dst_pitch, uint32_t dst_width, uint32_t dst_height);
+
+// Splits a row of |width| four byte pixels into three planes holding bytes
+// 0 to 2 of every pixel.
+void PlanarizeRow(const uint8_t* src, uint8_t* const* dst, uint32_t width);
+
+// Same as PlanarizeRow(), but stores scale[c] * value + bias[c] as floats.
+void PlanarizeRowFloat(const uint8_t* src, float* const* dst, uint32_t width,
+                       const float* scale, const float* bias);
+
+// Bilinear scaler for four byte pixels (RGBA or BGRA). The sampling
+// positions are computed once, so keep an instance per pair of sizes.
+// Downscaling by more than 2x skips source pixels and aliases.
+class RgbaScaler final {
+ public:
+  RgbaScaler(uint32_t src_width, uint32_t src_height, uint32_t dst_width,
+             uint32_t dst_height);
+
+  bool Matches(uint32_t src_width, uint32_t src_height, uint32_t dst_width,
+               uint32_t dst_height) const {
+    return src_width == src_width_ && src_height == src_height_ &&
+           dst_width == dst_width_ && dst_height == dst_height_;
+  }
+
+  // |src| and |dst| must not overlap.
+  void Scale(const uint8_t* src, uint32_t src_pitch, uint8_t* dst,
+             uint32_t dst_pitch);
+  // Produces row |y| of the scaled picture only, for callers that process
+  // the output row by row while it's in cache.
+  void ScaleRow(const uint8_t* src, uint32_t src_pitch, uint32_t y,
+                uint8_t* dst);
+
+ private:
+  uint32_t src_width_;
+  uint32_t src_height_;
+  uint32_t dst_width_;
+  uint32_t dst_height_;
+  std::vector<ScaleTap> column_taps_;
+  std::vector<ScaleTap> row_taps_;
+  // Vertically blended source row plus one pixel of padding.
+  std::vector<uint8_t> row_buffer_;
+};
+
+}  // namespace convert
+}  // namespace foxglove
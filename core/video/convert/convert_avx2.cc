@@ -0,0 +1,373 @@
+#include <cstring>
+
+#include "video/convert/convert_kernels.h"
+
+// This file is built with AVX2 code generation enabled and must only be
+// entered after checking GetCpuFeatures().avx2.
+#if defined(__AVX2__)
+#define FOXGLOVE_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace foxglove {
+namespace convert {
+
+#ifdef FOXGLOVE_HAS_AVX2
+
+namespace {
+
+struct YuvConstants {
+  __m256i y_r_v;
+  __m256i y_g_u;
+  __m256i g_v_0;
+  __m256i y_b_u;
+  __m256i round;
+  __m256i y_offset;
+  __m256i uv_offset;
+};
+
+inline __m256i PairOf(int16_t a, int16_t b) {
+  // Shifting a negative int32_t is undefined, so build the bits unsigned.
+  const uint32_t bits = static_cast<uint32_t>(static_cast<uint16_t>(a)) |
+                        (static_cast<uint32_t>(static_cast<uint16_t>(b)) << 16);
+  int32_t pair;
+  memcpy(&pair, &bits, sizeof(pair));
+  return _mm256_set1_epi32(pair);
+}
+
+inline YuvConstants LoadConstants(const YuvCoefficients& c) {
+  return {PairOf(c.y, c.r_v),
+          PairOf(c.y, c.g_u),
+          PairOf(c.g_v, 0),
+          PairOf(c.y, c.b_u),
+          _mm256_set1_epi32(1 << (kYuvShift - 1)),
+          _mm256_set1_epi16(16),
+          _mm256_set1_epi16(128)};
+}
+
+// The unpack instructions work within 128-bit lanes, which the final pack
+// reverts, so the result holds sixteen int16 values in pixel order.
+inline __m256i Dot(__m256i a, __m256i b, __m256i coefficients,
+                   __m256i extra_lo, __m256i extra_hi,
+                   const YuvConstants& k) {
+  auto lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), coefficients);
+  auto hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), coefficients);
+  lo = _mm256_srai_epi32(
+      _mm256_add_epi32(_mm256_add_epi32(lo, extra_lo), k.round), kYuvShift);
+  hi = _mm256_srai_epi32(
+      _mm256_add_epi32(_mm256_add_epi32(hi, extra_hi), k.round), kYuvShift);
+  return _mm256_packs_epi32(lo, hi);
+}
+
+// Interleaves the low and high eight bytes of each 128-bit lane.
+inline __m256i InterleaveHalves(__m256i value) {
+  return _mm256_unpacklo_epi8(value, _mm256_srli_si256(value, 8));
+}
+
+// Converts sixteen pixels given as int16 Y, U and V (already upsampled) and
+// stores them as 64 bytes of RGBA.
+inline void StoreYuvAsRgba(__m256i y, __m256i u, __m256i v, uint8_t* dst,
+                           const YuvConstants& k, bool bgra) {
+  y = _mm256_sub_epi16(y, k.y_offset);
+  u = _mm256_sub_epi16(u, k.uv_offset);
+  v = _mm256_sub_epi16(v, k.uv_offset);
+
+  const auto zero = _mm256_setzero_si256();
+  const auto r = Dot(y, v, k.y_r_v, zero, zero, k);
+  const auto g_v_lo =
+      _mm256_madd_epi16(_mm256_unpacklo_epi16(v, zero), k.g_v_0);
+  const auto g_v_hi =
+      _mm256_madd_epi16(_mm256_unpackhi_epi16(v, zero), k.g_v_0);
+  const auto g = Dot(y, u, k.y_g_u, g_v_lo, g_v_hi, k);
+  const auto b = Dot(y, u, k.y_b_u, zero, zero, k);
+  const auto a = _mm256_set1_epi16(0xff);
+
+  const auto rg = InterleaveHalves(_mm256_packus_epi16(bgra ? b : r, g));
+  const auto ba = InterleaveHalves(_mm256_packus_epi16(bgra ? r : b, a));
+  const auto lo = _mm256_unpacklo_epi16(rg, ba);
+  const auto hi = _mm256_unpackhi_epi16(rg, ba);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                      _mm256_permute2x128_si256(lo, hi, 0x20));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 32),
+                      _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+void SwizzleRow(const uint8_t* src, uint8_t* dst, uint32_t width) {
+  const auto mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14,
+                                     13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10,
+                                     9, 8, 11, 14, 13, 12, 15);
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    const auto pixels =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4),
+                        _mm256_shuffle_epi8(pixels, mask));
+  }
+  SwizzleRowScalar(src, dst, x, width);
+}
+
+void I420Row(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+             uint8_t* dst, uint32_t width, const YuvCoefficients& c,
+             bool bgra) {
+  const auto k = LoadConstants(c);
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    const auto y16 = _mm256_cvtepu8_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x)));
+    auto u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2));
+    auto v8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2));
+    u8 = _mm_unpacklo_epi8(u8, u8);
+    v8 = _mm_unpacklo_epi8(v8, v8);
+    StoreYuvAsRgba(y16, _mm256_cvtepu8_epi16(u8), _mm256_cvtepu8_epi16(v8),
+                   dst + x * 4, k, bgra);
+  }
+  I420RowScalar(y, u, v, dst, x, width, c, bgra);
+}
+
+void Nv12Row(const uint8_t* y, const uint8_t* uv, uint8_t* dst,
+             uint32_t width, const YuvCoefficients& c, bool bgra) {
+  const auto k = LoadConstants(c);
+  const auto mask_low = _mm256_set1_epi32(0xffff);
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    const auto y16 = _mm256_cvtepu8_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x)));
+    const auto uv16 = _mm256_cvtepu8_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + x)));
+    // Duplicate every U and V value to cover two pixels.
+    const auto u = _mm256_and_si256(uv16, mask_low);
+    const auto v = _mm256_srli_epi32(uv16, 16);
+    StoreYuvAsRgba(y16, _mm256_or_si256(u, _mm256_slli_epi32(u, 16)),
+                   _mm256_or_si256(v, _mm256_slli_epi32(v, 16)), dst + x * 4,
+                   k, bgra);
+  }
+  Nv12RowScalar(y, uv, dst, x, width, c, bgra);
+}
+
+// Returns the luma sums of eight pixels as int32 in pixel order.
+inline __m256i GraySums(__m256i pixels, __m256i weights) {
+  const auto zero = _mm256_setzero_si256();
+  const auto lo =
+      _mm256_madd_epi16(_mm256_unpacklo_epi8(pixels, zero), weights);
+  const auto hi =
+      _mm256_madd_epi16(_mm256_unpackhi_epi8(pixels, zero), weights);
+  const auto even = _mm256_castps_si256(
+      _mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi),
+                        _MM_SHUFFLE(2, 0, 2, 0)));
+  const auto odd = _mm256_castps_si256(
+      _mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi),
+                        _MM_SHUFFLE(3, 1, 3, 1)));
+  return _mm256_srli_epi32(
+      _mm256_add_epi32(_mm256_add_epi32(even, odd), _mm256_set1_epi32(128)),
+      8);
+}
+
+// Packs two vectors of eight int32 into sixteen int16 in pixel order.
+inline __m256i PackOrdered(__m256i a, __m256i b) {
+  return _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b),
+                                  _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+void GrayRow(const uint8_t* src, uint8_t* dst, uint32_t width, bool bgra) {
+  const int16_t w0 = bgra ? kGrayB : kGrayR;
+  const int16_t w2 = bgra ? kGrayR : kGrayB;
+  const auto weights = _mm256_setr_epi16(w0, kGrayG, w2, 0, w0, kGrayG, w2, 0,
+                                         w0, kGrayG, w2, 0, w0, kGrayG, w2, 0);
+  uint32_t x = 0;
+  for (; x + 32 <= width; x += 32) {
+    const auto* s = reinterpret_cast<const __m256i*>(src + x * 4);
+    const auto a = GraySums(_mm256_loadu_si256(s), weights);
+    const auto b = GraySums(_mm256_loadu_si256(s + 1), weights);
+    const auto c = GraySums(_mm256_loadu_si256(s + 2), weights);
+    const auto d = GraySums(_mm256_loadu_si256(s + 3), weights);
+    const auto gray = _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(PackOrdered(a, b), PackOrdered(c, d)),
+        _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), gray);
+  }
+  GrayRowScalar(src, dst, x, width, bgra);
+}
+
+// Computes (a * weight_a + b * weight_b + round) >> kScaleShift on int16
+// lanes. The sum stays below 1 << 16, so unsigned wraparound is harmless.
+inline __m256i Lerp(__m256i a, __m256i b, __m256i weight_a,
+                    __m256i weight_b) {
+  const auto sum = _mm256_add_epi16(_mm256_mullo_epi16(a, weight_a),
+                                    _mm256_mullo_epi16(b, weight_b));
+  return _mm256_srli_epi16(
+      _mm256_add_epi16(sum, _mm256_set1_epi16(kScaleOne / 2)), kScaleShift);
+}
+
+void BlendRow(const uint8_t* a, const uint8_t* b, uint8_t* dst,
+              uint32_t size, uint32_t weight) {
+  const auto weight_a =
+      _mm256_set1_epi16(static_cast<int16_t>(kScaleOne - weight));
+  const auto weight_b = _mm256_set1_epi16(static_cast<int16_t>(weight));
+  const auto zero = _mm256_setzero_si256();
+  uint32_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const auto va =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    const auto vb =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    // Unpacking and packing within lanes keeps the byte order.
+    const auto lo = Lerp(_mm256_unpacklo_epi8(va, zero),
+                         _mm256_unpacklo_epi8(vb, zero), weight_a, weight_b);
+    const auto hi = Lerp(_mm256_unpackhi_epi8(va, zero),
+                         _mm256_unpackhi_epi8(vb, zero), weight_a, weight_b);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm256_packus_epi16(lo, hi));
+  }
+  BlendRowScalar(a, b, dst, i, size, weight);
+}
+
+// Replicates a weight into four int16 lanes.
+inline int64_t Replicate4(uint32_t weight) {
+  return static_cast<int64_t>(weight * 0x0001000100010001ull);
+}
+
+// Loads the left and right neighbors of two taps into a 128-bit lane.
+inline __m128i LoadPair(const uint8_t* src, const ScaleTap& tap_0,
+                        const ScaleTap& tap_1) {
+  return _mm_unpacklo_epi64(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + tap_0.x * 4)),
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + tap_1.x * 4)));
+}
+
+// Interpolates the pixels of four taps into sixteen int16 lanes, holding
+// taps 0 and 1 in the low lane and taps 2 and 3 in the high lane.
+inline __m256i ScaleQuad(const uint8_t* src, const ScaleTap* taps) {
+  const auto zero = _mm256_setzero_si256();
+  const auto pixels = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(LoadPair(src, taps[0], taps[1])),
+      LoadPair(src, taps[2], taps[3]), 1);
+  const auto lo = _mm256_unpacklo_epi8(pixels, zero);
+  const auto hi = _mm256_unpackhi_epi8(pixels, zero);
+  const auto weight_right = _mm256_setr_epi64x(
+      Replicate4(taps[0].weight), Replicate4(taps[1].weight),
+      Replicate4(taps[2].weight), Replicate4(taps[3].weight));
+  const auto weight_left =
+      _mm256_sub_epi16(_mm256_set1_epi16(kScaleOne), weight_right);
+  return Lerp(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi),
+              weight_left, weight_right);
+}
+
+void ScaleRow(const uint8_t* src, uint8_t* dst, uint32_t width,
+              const ScaleTap* taps) {
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    const auto a = ScaleQuad(src, taps + x);
+    const auto b = ScaleQuad(src, taps + x + 4);
+    // Restore pixel order after packing within lanes.
+    const auto pixels = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b),
+                                                 _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), pixels);
+  }
+  ScaleRowScalar(src, dst, x, width, taps);
+}
+
+// Averages eight source pixels from each row into four int16 pixels,
+// holding output pixels 0 and 1 in the low lane and 2 and 3 in the high
+// lane.
+inline __m256i HalveOctet(const uint8_t* row_0, const uint8_t* row_1) {
+  const auto zero = _mm256_setzero_si256();
+  const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_0));
+  const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_1));
+  const auto lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero),
+                                   _mm256_unpacklo_epi8(b, zero));
+  const auto hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero),
+                                   _mm256_unpackhi_epi8(b, zero));
+  const auto sum = _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi),
+                                    _mm256_unpackhi_epi64(lo, hi));
+  return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(2)), 2);
+}
+
+void HalveRow(const uint8_t* row_0, const uint8_t* row_1, uint8_t* dst,
+              uint32_t width) {
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    const auto a = HalveOctet(row_0 + x * 8, row_1 + x * 8);
+    const auto b = HalveOctet(row_0 + x * 8 + 32, row_1 + x * 8 + 32);
+    // Restore pixel order after packing within lanes.
+    const auto pixels = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b),
+                                                 _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), pixels);
+  }
+  HalveRowScalar(row_0, row_1, dst, x, width);
+}
+
+// Moves byte |c| of every pixel into the low byte of its 32-bit lane.
+inline __m256i Channel(__m256i pixels, int c) {
+  const auto mask = _mm256_set1_epi32(0xff);
+  switch (c) {
+    case 0:
+      return _mm256_and_si256(pixels, mask);
+    case 1:
+      return _mm256_and_si256(_mm256_srli_epi32(pixels, 8), mask);
+    default:
+      return _mm256_and_si256(_mm256_srli_epi32(pixels, 16), mask);
+  }
+}
+
+void PlanarRow(const uint8_t* src, uint8_t* const* dst, uint32_t width) {
+  // Undoes the interleaving of lanes by the two packs.
+  const auto order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  uint32_t x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m256i pixels[4];
+    for (int i = 0; i < 4; i++) {
+      pixels[i] = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(src + (x + i * 8) * 4));
+    }
+    for (int c = 0; c < 3; c++) {
+      const auto lo = _mm256_packs_epi32(Channel(pixels[0], c),
+                                         Channel(pixels[1], c));
+      const auto hi = _mm256_packs_epi32(Channel(pixels[2], c),
+                                         Channel(pixels[3], c));
+      const auto bytes = _mm256_permutevar8x32_epi32(
+          _mm256_packus_epi16(lo, hi), order);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst[c] + x), bytes);
+    }
+  }
+  PlanarRowScalar(src, dst, x, width);
+}
+
+void PlanarFloatRow(const uint8_t* src, float* const* dst, uint32_t width,
+                    const float* scale, const float* bias) {
+  __m256 scales[3];
+  __m256 biases[3];
+  for (int c = 0; c < 3; c++) {
+    scales[c] = _mm256_set1_ps(scale[c]);
+    biases[c] = _mm256_set1_ps(bias[c]);
+  }
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    const auto pixels =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+    for (int c = 0; c < 3; c++) {
+      const auto values = _mm256_cvtepi32_ps(Channel(pixels, c));
+      _mm256_storeu_ps(
+          dst[c] + x,
+          _mm256_add_ps(_mm256_mul_ps(values, scales[c]), biases[c]));
+    }
+  }
+  PlanarFloatRowScalar(src, dst, x, width, scale, bias);
+}
+
+}  // namespace
+
+const ConvertKernels* GetAvx2Kernels() {
+  static const ConvertKernels kernels = {
+      "avx2",   SwizzleRow, I420Row,  Nv12Row,   GrayRow,
+      BlendRow, ScaleRow,   HalveRow, PlanarRow, PlanarFloatRow};
+  return &kernels;
+}
+
+#else
+
+const ConvertKernels* GetAvx2Kernels() { return nullptr; }
+
+#endif
+
+}  // namespace convert
+}  // namespace foxglove
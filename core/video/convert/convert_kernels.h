@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+
+// Per-row kernels shared by the scalar and SIMD implementations. SIMD
+// kernels process as many pixels as possible and hand the remainder to the
+// scalar kernels, so all implementations produce identical output.
+
+namespace foxglove {
+namespace convert {
+
+// Fixed point YUV to RGB coefficients with kYuvShift fractional bits.
+struct YuvCoefficients {
+  int16_t y;
+  int16_t r_v;
+  int16_t g_u;
+  int16_t g_v;
+  int16_t b_u;
+};
+
+constexpr int kYuvShift = 13;
+
+// Full range BT.601 luma weights with 8 fractional bits.
+constexpr int kGrayR = 77;
+constexpr int kGrayG = 150;
+constexpr int kGrayB = 29;
+
+// Bilinear weights have kScaleShift fractional bits.
+constexpr int kScaleShift = 8;
+constexpr uint32_t kScaleOne = 1 << kScaleShift;
+
+// Samples a four byte pixel between src[x] and src[x + 1], |weight| being
+// the share of the latter. Also used for rows in the vertical pass.
+struct ScaleTap {
+  uint32_t x;
+  uint32_t weight;
+};
+
+struct ConvertKernels {
+  const char* name;
+  void (*swizzle_row)(const uint8_t* src, uint8_t* dst, uint32_t width);
+  void (*i420_row)(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                   uint8_t* dst, uint32_t width, const YuvCoefficients& c,
+                   bool bgra);
+  void (*nv12_row)(const uint8_t* y, const uint8_t* uv, uint8_t* dst,
+                   uint32_t width, const YuvCoefficients& c, bool bgra);
+  void (*gray_row)(const uint8_t* src, uint8_t* dst, uint32_t width,
+                   bool bgra);
+  // Interpolates |size| bytes between |a| and |b|.
+  void (*blend_row)(const uint8_t* a, const uint8_t* b, uint8_t* dst,
+                    uint32_t size, uint32_t weight);
+  // Produces |width| four byte pixels, one per tap.
+  void (*scale_row)(const uint8_t* src, uint8_t* dst, uint32_t width,
+                    const ScaleTap* taps);
+  // Averages 2x2 blocks of four byte pixels from two rows into |width|
+  // pixels.
+  void (*halve_row)(const uint8_t* row_0, const uint8_t* row_1, uint8_t* dst,
+                    uint32_t width);
+  // Splits |width| four byte pixels into three planes holding bytes 0 to 2.
+  void (*planar_row)(const uint8_t* src, uint8_t* const* dst, uint32_t width);
+  // Same as planar_row, but stores byte c as scale[c] * value + bias[c].
+  void (*planar_float_row)(const uint8_t* src, float* const* dst,
+                           uint32_t width, const float* scale,
+                           const float* bias);
+};
+
+const ConvertKernels& GetScalarKernels();
+// Return nullptr if the kernels weren't compiled in.
+const ConvertKernels* GetSse2Kernels();
+const ConvertKernels* GetAvx2Kernels();
+
+// Scalar row kernels starting at pixel |x|, used for the SIMD tails.
+void SwizzleRowScalar(const uint8_t* src, uint8_t* dst, uint32_t x,
+                      uint32_t width);
+void I420RowScalar(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                   uint8_t* dst, uint32_t x, uint32_t width,
+                   const YuvCoefficients& c, bool bgra);
+void Nv12RowScalar(const uint8_t* y, const uint8_t* uv, uint8_t* dst,
+                   uint32_t x, uint32_t width, const YuvCoefficients& c,
+                   bool bgra);
+void GrayRowScalar(const uint8_t* src, uint8_t* dst, uint32_t x,
+                   uint32_t width, bool bgra);
+// Starts at byte |offset| rather than at a pixel.
+void BlendRowScalar(const uint8_t* a, const uint8_t* b, uint8_t* dst,
+                    uint32_t offset, uint32_t size, uint32_t weight);
+void ScaleRowScalar(const uint8_t* src, uint8_t* dst, uint32_t x,
+                    uint32_t width, const ScaleTap* taps);
+void HalveRowScalar(const uint8_t* row_0, const uint8_t* row_1, uint8_t* dst,
+                    uint32_t x, uint32_t width);
+void PlanarRowScalar(const uint8_t* src, uint8_t* const* dst, uint32_t x,
+                     uint32_t width);
+void PlanarFloatRowScalar(const uint8_t* src, float* const* dst, uint32_t x,
+                          uint32_t width, const float* scale,
+                          const float* bias);
+
+}  // namespace convert
+}  // namespace foxglove
@@ -0,0 +1,187 @@
+#include <algorithm>
+
+#include "video/convert/convert_kernels.h"
+
+namespace foxglove {
+namespace convert {
+
+namespace {
+
+inline uint8_t Clamp(int32_t value) {
+  return static_cast<uint8_t>(std::clamp(value, 0, 255));
+}
+
+inline void YuvToRgba(int32_t y, int32_t u, int32_t v, uint8_t* dst,
+                      const YuvCoefficients& c, bool bgra) {
+  constexpr int32_t kRound = 1 << (kYuvShift - 1);
+  y = (y - 16) * c.y + kRound;
+  u -= 128;
+  v -= 128;
+  const auto r = Clamp((y + c.r_v * v) >> kYuvShift);
+  const auto g = Clamp((y + c.g_u * u + c.g_v * v) >> kYuvShift);
+  const auto b = Clamp((y + c.b_u * u) >> kYuvShift);
+  dst[0] = bgra ? b : r;
+  dst[1] = g;
+  dst[2] = bgra ? r : b;
+  dst[3] = 0xff;
+}
+
+void SwizzleRow(const uint8_t* src, uint8_t* dst, uint32_t width) {
+  SwizzleRowScalar(src, dst, 0, width);
+}
+
+void I420Row(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+             uint8_t* dst, uint32_t width, const YuvCoefficients& c,
+             bool bgra) {
+  I420RowScalar(y, u, v, dst, 0, width, c, bgra);
+}
+
+void Nv12Row(const uint8_t* y, const uint8_t* uv, uint8_t* dst,
+             uint32_t width, const YuvCoefficients& c, bool bgra) {
+  Nv12RowScalar(y, uv, dst, 0, width, c, bgra);
+}
+
+void GrayRow(const uint8_t* src, uint8_t* dst, uint32_t width, bool bgra) {
+  GrayRowScalar(src, dst, 0, width, bgra);
+}
+
+void BlendRow(const uint8_t* a, const uint8_t* b, uint8_t* dst,
+              uint32_t size, uint32_t weight) {
+  BlendRowScalar(a, b, dst, 0, size, weight);
+}
+
+void ScaleRow(const uint8_t* src, uint8_t* dst, uint32_t width,
+              const ScaleTap* taps) {
+  ScaleRowScalar(src, dst, 0, width, taps);
+}
+
+void HalveRow(const uint8_t* row_0, const uint8_t* row_1, uint8_t* dst,
+              uint32_t width) {
+  HalveRowScalar(row_0, row_1, dst, 0, width);
+}
+
+void PlanarRow(const uint8_t* src, uint8_t* const* dst, uint32_t width) {
+  PlanarRowScalar(src, dst, 0, width);
+}
+
+void PlanarFloatRow(const uint8_t* src, float* const* dst, uint32_t width,
+                    const float* scale, const float* bias) {
+  PlanarFloatRowScalar(src, dst, 0, width, scale, bias);
+}
+
+}  // namespace
+
+void SwizzleRowScalar(const uint8_t* src, uint8_t* dst, uint32_t x,
+                      uint32_t width) {
+  for (; x < width; x++) {
+    const auto* s = src + x * 4;
+    auto* d = dst + x * 4;
+    const auto r = s[0];
+    const auto g = s[1];
+    const auto b = s[2];
+    const auto a = s[3];
+    d[0] = b;
+    d[1] = g;
+    d[2] = r;
+    d[3] = a;
+  }
+}
+
+void I420RowScalar(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                   uint8_t* dst, uint32_t x, uint32_t width,
+                   const YuvCoefficients& c, bool bgra) {
+  for (; x < width; x++) {
+    YuvToRgba(y[x], u[x / 2], v[x / 2], dst + x * 4, c, bgra);
+  }
+}
+
+void Nv12RowScalar(const uint8_t* y, const uint8_t* uv, uint8_t* dst,
+                   uint32_t x, uint32_t width, const YuvCoefficients& c,
+                   bool bgra) {
+  for (; x < width; x++) {
+    const auto chroma = uv + (x / 2) * 2;
+    YuvToRgba(y[x], chroma[0], chroma[1], dst + x * 4, c, bgra);
+  }
+}
+
+void GrayRowScalar(const uint8_t* src, uint8_t* dst, uint32_t x,
+                   uint32_t width, bool bgra) {
+  const int32_t weight_0 = bgra ? kGrayB : kGrayR;
+  const int32_t weight_2 = bgra ? kGrayR : kGrayB;
+  for (; x < width; x++) {
+    const auto* s = src + x * 4;
+    dst[x] = static_cast<uint8_t>(
+        (s[0] * weight_0 + s[1] * kGrayG + s[2] * weight_2 + 128) >> 8);
+  }
+}
+
+void BlendRowScalar(const uint8_t* a, const uint8_t* b, uint8_t* dst,
+                    uint32_t offset, uint32_t size, uint32_t weight) {
+  const uint32_t weight_a = kScaleOne - weight;
+  for (; offset < size; offset++) {
+    dst[offset] = static_cast<uint8_t>(
+        (a[offset] * weight_a + b[offset] * weight + kScaleOne / 2) >>
+        kScaleShift);
+  }
+}
+
+void ScaleRowScalar(const uint8_t* src, uint8_t* dst, uint32_t x,
+                    uint32_t width, const ScaleTap* taps) {
+  for (; x < width; x++) {
+    const auto& tap = taps[x];
+    const auto* left = src + tap.x * 4;
+    const auto* right = left + 4;
+    const uint32_t weight_left = kScaleOne - tap.weight;
+    auto* d = dst + x * 4;
+    for (int c = 0; c < 4; c++) {
+      d[c] = static_cast<uint8_t>((left[c] * weight_left +
+                                   right[c] * tap.weight + kScaleOne / 2) >>
+                                  kScaleShift);
+    }
+  }
+}
+
+void HalveRowScalar(const uint8_t* row_0, const uint8_t* row_1, uint8_t* dst,
+                    uint32_t x, uint32_t width) {
+  for (; x < width; x++) {
+    const auto* a = row_0 + x * 8;
+    const auto* b = row_1 + x * 8;
+    auto* d = dst + x * 4;
+    for (int c = 0; c < 4; c++) {
+      d[c] = static_cast<uint8_t>((a[c] + a[c + 4] + b[c] + b[c + 4] + 2) >> 2);
+    }
+  }
+}
+
+void PlanarRowScalar(const uint8_t* src, uint8_t* const* dst, uint32_t x,
+                     uint32_t width) {
+  for (; x < width; x++) {
+    const auto* s = src + x * 4;
+    dst[0][x] = s[0];
+    dst[1][x] = s[1];
+    dst[2][x] = s[2];
+  }
+}
+
+void PlanarFloatRowScalar(const uint8_t* src, float* const* dst, uint32_t x,
+                          uint32_t width, const float* scale,
+                          const float* bias) {
+  for (; x < width; x++) {
+    const auto* s = src + x * 4;
+    for (int c = 0; c < 3; c++) {
+      // Kept as separate operations, so the SIMD kernels match exactly.
+      const float scaled = static_cast<float>(s[c]) * scale[c];
+      dst[c][x] = scaled + bias[c];
+    }
+  }
+}
+
+const ConvertKernels& GetScalarKernels() {
+  static const ConvertKernels kernels = {
+      "scalar", SwizzleRow, I420Row,  Nv12Row,  GrayRow,
+      BlendRow, ScaleRow,   HalveRow, PlanarRow, PlanarFloatRow};
+  return kernels;
+}
+
+}  // namespace convert
+}  // namespace foxglove
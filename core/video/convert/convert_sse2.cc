@@ -0,0 +1,341 @@
+#include <cstring>
+
+#include "base/cpu_features.h"
+#include "video/convert/convert_kernels.h"
+
+namespace foxglove {
+namespace convert {
+
+#ifdef FOXGLOVE_HAS_SSE2
+
+namespace {
+
+struct YuvConstants {
+  __m128i y_r_v;  // (y, r_v) pairs
+  __m128i y_g_u;  // (y, g_u) pairs
+  __m128i g_v_0;  // (g_v, 0) pairs
+  __m128i y_b_u;  // (y, b_u) pairs
+  __m128i round;
+  __m128i y_offset;
+  __m128i uv_offset;
+};
+
+inline __m128i PairOf(int16_t a, int16_t b) {
+  // Shifting a negative int32_t is undefined, so build the bits unsigned.
+  const uint32_t bits = static_cast<uint32_t>(static_cast<uint16_t>(a)) |
+                        (static_cast<uint32_t>(static_cast<uint16_t>(b)) << 16);
+  int32_t pair;
+  memcpy(&pair, &bits, sizeof(pair));
+  return _mm_set1_epi32(pair);
+}
+
+inline YuvConstants LoadConstants(const YuvCoefficients& c) {
+  return {PairOf(c.y, c.r_v),
+          PairOf(c.y, c.g_u),
+          PairOf(c.g_v, 0),
+          PairOf(c.y, c.b_u),
+          _mm_set1_epi32(1 << (kYuvShift - 1)),
+          _mm_set1_epi16(16),
+          _mm_set1_epi16(128)};
+}
+
+// Dot product of interleaved (a, b) int16 pairs with |coefficients|, rounded
+// and scaled back to eight int16 values.
+inline __m128i Dot(__m128i a, __m128i b, __m128i coefficients,
+                   __m128i extra_lo, __m128i extra_hi,
+                   const YuvConstants& k) {
+  auto lo = _mm_madd_epi16(_mm_unpacklo_epi16(a, b), coefficients);
+  auto hi = _mm_madd_epi16(_mm_unpackhi_epi16(a, b), coefficients);
+  lo = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(lo, extra_lo), k.round),
+                      kYuvShift);
+  hi = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(hi, extra_hi), k.round),
+                      kYuvShift);
+  return _mm_packs_epi32(lo, hi);
+}
+
+// Converts eight pixels given as int16 Y, U and V (already upsampled) and
+// stores them as 32 bytes of RGBA.
+inline void StoreYuvAsRgba(__m128i y, __m128i u, __m128i v, uint8_t* dst,
+                           const YuvConstants& k, bool bgra) {
+  y = _mm_sub_epi16(y, k.y_offset);
+  u = _mm_sub_epi16(u, k.uv_offset);
+  v = _mm_sub_epi16(v, k.uv_offset);
+
+  const auto zero = _mm_setzero_si128();
+  const auto r = Dot(y, v, k.y_r_v, zero, zero, k);
+  const auto g_v_lo = _mm_madd_epi16(_mm_unpacklo_epi16(v, zero), k.g_v_0);
+  const auto g_v_hi = _mm_madd_epi16(_mm_unpackhi_epi16(v, zero), k.g_v_0);
+  const auto g = Dot(y, u, k.y_g_u, g_v_lo, g_v_hi, k);
+  const auto b = Dot(y, u, k.y_b_u, zero, zero, k);
+
+  const auto r8 = _mm_packus_epi16(bgra ? b : r, zero);
+  const auto g8 = _mm_packus_epi16(g, zero);
+  const auto b8 = _mm_packus_epi16(bgra ? r : b, zero);
+  const auto a8 = _mm_set1_epi8(static_cast<char>(0xff));
+
+  const auto rg = _mm_unpacklo_epi8(r8, g8);
+  const auto ba = _mm_unpacklo_epi8(b8, a8);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                   _mm_unpacklo_epi16(rg, ba));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16),
+                   _mm_unpackhi_epi16(rg, ba));
+}
+
+void SwizzleRow(const uint8_t* src, uint8_t* dst, uint32_t width) {
+  const auto mask_ag = _mm_set1_epi32(0xff00ff00);
+  const auto mask_low = _mm_set1_epi32(0x000000ff);
+  uint32_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    const auto pixels =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+    const auto ag = _mm_and_si128(pixels, mask_ag);
+    const auto r = _mm_and_si128(pixels, mask_low);
+    const auto b = _mm_and_si128(_mm_srli_epi32(pixels, 16), mask_low);
+    const auto swapped =
+        _mm_or_si128(ag, _mm_or_si128(b, _mm_slli_epi32(r, 16)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), swapped);
+  }
+  SwizzleRowScalar(src, dst, x, width);
+}
+
+void I420Row(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+             uint8_t* dst, uint32_t width, const YuvCoefficients& c,
+             bool bgra) {
+  const auto k = LoadConstants(c);
+  const auto zero = _mm_setzero_si128();
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    const auto y8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + x));
+    int32_t u4;
+    int32_t v4;
+    memcpy(&u4, u + x / 2, sizeof(u4));
+    memcpy(&v4, v + x / 2, sizeof(v4));
+    auto u8 = _mm_cvtsi32_si128(u4);
+    auto v8 = _mm_cvtsi32_si128(v4);
+    u8 = _mm_unpacklo_epi8(u8, u8);
+    v8 = _mm_unpacklo_epi8(v8, v8);
+    StoreYuvAsRgba(_mm_unpacklo_epi8(y8, zero), _mm_unpacklo_epi8(u8, zero),
+                   _mm_unpacklo_epi8(v8, zero), dst + x * 4, k, bgra);
+  }
+  I420RowScalar(y, u, v, dst, x, width, c, bgra);
+}
+
+void Nv12Row(const uint8_t* y, const uint8_t* uv, uint8_t* dst,
+             uint32_t width, const YuvCoefficients& c, bool bgra) {
+  const auto k = LoadConstants(c);
+  const auto zero = _mm_setzero_si128();
+  const auto mask_low = _mm_set1_epi32(0xffff);
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    const auto y8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + x));
+    const auto uv16 = _mm_unpacklo_epi8(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(uv + x)), zero);
+    // Duplicate every U and V value to cover two pixels.
+    const auto u = _mm_and_si128(uv16, mask_low);
+    const auto v = _mm_srli_epi32(uv16, 16);
+    StoreYuvAsRgba(_mm_unpacklo_epi8(y8, zero),
+                   _mm_or_si128(u, _mm_slli_epi32(u, 16)),
+                   _mm_or_si128(v, _mm_slli_epi32(v, 16)), dst + x * 4, k,
+                   bgra);
+  }
+  Nv12RowScalar(y, uv, dst, x, width, c, bgra);
+}
+
+// Returns the luma sums of four pixels as int32.
+inline __m128i GraySums(__m128i pixels, __m128i weights) {
+  const auto zero = _mm_setzero_si128();
+  const auto lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights);
+  const auto hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights);
+  // Each pixel produced two partial sums, add them up.
+  const auto even = _mm_castps_si128(_mm_shuffle_ps(
+      _mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+  const auto odd = _mm_castps_si128(_mm_shuffle_ps(
+      _mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1)));
+  return _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(even, odd),
+                                      _mm_set1_epi32(128)),
+                        8);
+}
+
+void GrayRow(const uint8_t* src, uint8_t* dst, uint32_t width, bool bgra) {
+  const auto weights = _mm_set_epi16(0, bgra ? kGrayR : kGrayB, kGrayG,
+                                     bgra ? kGrayB : kGrayR, 0,
+                                     bgra ? kGrayR : kGrayB, kGrayG,
+                                     bgra ? kGrayB : kGrayR);
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    const auto* s = reinterpret_cast<const __m128i*>(src + x * 4);
+    const auto a = GraySums(_mm_loadu_si128(s), weights);
+    const auto b = GraySums(_mm_loadu_si128(s + 1), weights);
+    const auto c = GraySums(_mm_loadu_si128(s + 2), weights);
+    const auto d = GraySums(_mm_loadu_si128(s + 3), weights);
+    const auto gray = _mm_packus_epi16(_mm_packs_epi32(a, b),
+                                       _mm_packs_epi32(c, d));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), gray);
+  }
+  GrayRowScalar(src, dst, x, width, bgra);
+}
+
+// Computes (a * weight_a + b * weight_b + round) >> kScaleShift on int16
+// lanes. The sum stays below 1 << 16, so unsigned wraparound is harmless.
+inline __m128i Lerp(__m128i a, __m128i b, __m128i weight_a,
+                    __m128i weight_b) {
+  const auto sum = _mm_add_epi16(_mm_mullo_epi16(a, weight_a),
+                                 _mm_mullo_epi16(b, weight_b));
+  return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(kScaleOne / 2)),
+                        kScaleShift);
+}
+
+void BlendRow(const uint8_t* a, const uint8_t* b, uint8_t* dst,
+              uint32_t size, uint32_t weight) {
+  const auto weight_a =
+      _mm_set1_epi16(static_cast<int16_t>(kScaleOne - weight));
+  const auto weight_b = _mm_set1_epi16(static_cast<int16_t>(weight));
+  const auto zero = _mm_setzero_si128();
+  uint32_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const auto va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    const auto lo = Lerp(_mm_unpacklo_epi8(va, zero),
+                         _mm_unpacklo_epi8(vb, zero), weight_a, weight_b);
+    const auto hi = Lerp(_mm_unpackhi_epi8(va, zero),
+                         _mm_unpackhi_epi8(vb, zero), weight_a, weight_b);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(lo, hi));
+  }
+  BlendRowScalar(a, b, dst, i, size, weight);
+}
+
+// Replicates a weight into four int16 lanes.
+inline int64_t Replicate4(uint32_t weight) {
+  return static_cast<int64_t>(weight * 0x0001000100010001ull);
+}
+
+// Interpolates the pixels of two taps into eight int16 lanes.
+inline __m128i ScalePair(const uint8_t* src, const ScaleTap& tap_0,
+                         const ScaleTap& tap_1) {
+  const auto zero = _mm_setzero_si128();
+  // Each load covers the left and the right neighbor.
+  const auto p0 = _mm_unpacklo_epi8(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + tap_0.x * 4)),
+      zero);
+  const auto p1 = _mm_unpacklo_epi8(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + tap_1.x * 4)),
+      zero);
+  const auto weight_right =
+      _mm_set_epi64x(Replicate4(tap_1.weight), Replicate4(tap_0.weight));
+  const auto weight_left =
+      _mm_sub_epi16(_mm_set1_epi16(kScaleOne), weight_right);
+  return Lerp(_mm_unpacklo_epi64(p0, p1), _mm_unpackhi_epi64(p0, p1),
+              weight_left, weight_right);
+}
+
+void ScaleRow(const uint8_t* src, uint8_t* dst, uint32_t width,
+              const ScaleTap* taps) {
+  uint32_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    const auto lo = ScalePair(src, taps[x], taps[x + 1]);
+    const auto hi = ScalePair(src, taps[x + 2], taps[x + 3]);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4),
+                     _mm_packus_epi16(lo, hi));
+  }
+  ScaleRowScalar(src, dst, x, width, taps);
+}
+
+// Averages four source pixels from each row into two int16 pixels.
+inline __m128i HalveQuad(const uint8_t* row_0, const uint8_t* row_1) {
+  const auto zero = _mm_setzero_si128();
+  const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_0));
+  const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_1));
+  // Vertical sums of pixels 0 and 1, and of pixels 2 and 3.
+  const auto lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                _mm_unpacklo_epi8(b, zero));
+  const auto hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                _mm_unpackhi_epi8(b, zero));
+  const auto sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi),
+                                 _mm_unpackhi_epi64(lo, hi));
+  return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+}
+
+void HalveRow(const uint8_t* row_0, const uint8_t* row_1, uint8_t* dst,
+              uint32_t width) {
+  uint32_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    const auto lo = HalveQuad(row_0 + x * 8, row_1 + x * 8);
+    const auto hi = HalveQuad(row_0 + x * 8 + 16, row_1 + x * 8 + 16);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4),
+                     _mm_packus_epi16(lo, hi));
+  }
+  HalveRowScalar(row_0, row_1, dst, x, width);
+}
+
+// Moves byte |c| of every pixel into the low byte of its 32-bit lane.
+inline __m128i Channel(__m128i pixels, int c) {
+  const auto mask = _mm_set1_epi32(0xff);
+  switch (c) {
+    case 0:
+      return _mm_and_si128(pixels, mask);
+    case 1:
+      return _mm_and_si128(_mm_srli_epi32(pixels, 8), mask);
+    default:
+      return _mm_and_si128(_mm_srli_epi32(pixels, 16), mask);
+  }
+}
+
+void PlanarRow(const uint8_t* src, uint8_t* const* dst, uint32_t width) {
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i pixels[4];
+    for (int i = 0; i < 4; i++) {
+      pixels[i] = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(src + (x + i * 4) * 4));
+    }
+    for (int c = 0; c < 3; c++) {
+      const auto lo = _mm_packs_epi32(Channel(pixels[0], c),
+                                      Channel(pixels[1], c));
+      const auto hi = _mm_packs_epi32(Channel(pixels[2], c),
+                                      Channel(pixels[3], c));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst[c] + x),
+                       _mm_packus_epi16(lo, hi));
+    }
+  }
+  PlanarRowScalar(src, dst, x, width);
+}
+
+void PlanarFloatRow(const uint8_t* src, float* const* dst, uint32_t width,
+                    const float* scale, const float* bias) {
+  __m128 scales[3];
+  __m128 biases[3];
+  for (int c = 0; c < 3; c++) {
+    scales[c] = _mm_set1_ps(scale[c]);
+    biases[c] = _mm_set1_ps(bias[c]);
+  }
+  uint32_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    const auto pixels =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+    for (int c = 0; c < 3; c++) {
+      const auto values = _mm_cvtepi32_ps(Channel(pixels, c));
+      _mm_storeu_ps(dst[c] + x,
+                    _mm_add_ps(_mm_mul_ps(values, scales[c]), biases[c]));
+    }
+  }
+  PlanarFloatRowScalar(src, dst, x, width, scale, bias);
+}
+
+}  // namespace
+
+const ConvertKernels* GetSse2Kernels() {
+  static const ConvertKernels kernels = {
+      "sse2",   SwizzleRow, I420Row,  Nv12Row,   GrayRow,
+      BlendRow, ScaleRow,   HalveRow, PlanarRow, PlanarFloatRow};
+  return &kernels;
+}
+
+#else
+
+const ConvertKernels* GetSse2Kernels() { return nullptr; }
+
+#endif
+
+}  // namespace convert
+}  // namespace foxglove
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+#include "video/frame_descriptor.h"
+
+namespace foxglove {
+
+// Inspects decoded pictures on the vout thread before they're presented.
+// Analyzers see the whole picture VLC rendered, before cropping, conversion
+// and duplicate skipping, so they have to be cheap.
+class FrameAnalyzer {
+ public:
+  virtual ~FrameAnalyzer() = default;
+
+  // |planes| hold a picture described by |frame| and are only valid for the
+  // duration of the call.
+  virtual void Analyze(const FrameDescriptor& frame,
+                       const uint8_t* const* planes) = 0;
+};
+
+}  // namespace foxglove
@@ -0,0 +1,45 @@
+#include "video/frame_buffer.h"
+
+#include <cassert>
+
+namespace foxglove {
+
+namespace {
+
+constexpr size_t AlignPlaneSize(size_t size) {
+  constexpr auto alignment = AlignedMemory::kDefaultAlignment;
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+FrameBuffer::FrameBuffer(PixelFormat pixel_format,
+                         const VideoDimensions& dimensions,
+                         const FrameLayout& layout, bool use_huge_pages)
+    : pixel_format_(pixel_format), dimensions_(dimensions), layout_(layout) {
+  assert(layout.plane_count <= kMaxPlanes);
+
+  size_t total_size = 0;
+  for (uint32_t i = 0; i < layout_.plane_count; i++) {
+    total_size += AlignPlaneSize(layout_.plane_size(i));
+  }
+
+  memory_ = AlignedMemory(total_size, use_huge_pages);
+  if (!memory_) {
+    return;
+  }
+
+  size_t offset = 0;
+  for (uint32_t i = 0; i < layout_.plane_count; i++) {
+    planes_[i] = memory_.data() + offset;
+    offset += AlignPlaneSize(layout_.plane_size(i));
+  }
+}
+
+void FrameBuffer::GetPlanes(void** planes) const {
+  for (uint32_t i = 0; i < layout_.plane_count; i++) {
+    planes[i] = planes_[i];
+  }
+}
+
+}  // namespace foxglove
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "base/aligned_memory.h"
+#include "video/frame_descriptor.h"
+#include "video/frame_layout.h"
+#include "video/video_dimensions.h"
+
+namespace foxglove {
+
+// A single picture's worth of memory. Every plane starts at a
+// AlignedMemory::kDefaultAlignment boundary.
+class FrameBuffer final {
+ public:
+  FrameBuffer(PixelFormat pixel_format, const VideoDimensions& dimensions,
+              const FrameLayout& layout, bool use_huge_pages = false);
+
+  FrameBuffer(const FrameBuffer&) = delete;
+  FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+  bool is_valid() const { return static_cast<bool>(memory_); }
+
+  PixelFormat pixel_format() const { return pixel_format_; }
+  const VideoDimensions& dimensions() const { return dimensions_; }
+  const FrameLayout& layout() const { return layout_; }
+  uint32_t plane_count() const { return layout_.plane_count; }
+  uint8_t* plane(size_t index) const { return planes_[index]; }
+  uint32_t pitch(size_t index) const { return layout_.pitches[index]; }
+  bool is_huge_page_backed() const { return memory_.is_huge_page_backed(); }
+
+  // Timing of the picture currently held by the buffer.
+  const FrameTiming& timing() const { return timing_; }
+  void set_timing(const FrameTiming& timing) { timing_ = timing; }
+  YuvMatrix yuv_matrix() const { return yuv_matrix_; }
+  void set_yuv_matrix(YuvMatrix yuv_matrix) { yuv_matrix_ = yuv_matrix; }
+  FrameDescriptor descriptor() const {
+    return {pixel_format_, dimensions_, layout_, timing_, yuv_matrix_};
+  }
+
+  // Fills |planes| with the start addresses of all planes.
+  void GetPlanes(void** planes) const;
+
+ private:
+  PixelFormat pixel_format_;
+  VideoDimensions dimensions_;
+  FrameLayout layout_;
+  AlignedMemory memory_;
+  std::array<uint8_t*, kMaxPlanes> planes_{};
+  FrameTiming timing_;
+  YuvMatrix yuv_matrix_ = YuvMatrix::kBt601;
+};
+
+}  // namespace foxglove
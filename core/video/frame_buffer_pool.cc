@@ -0,0 +1,61 @@
+#include "video/frame_buffer_pool.h"
+
+#include <atomic>
+#include <cassert>
+
+namespace foxglove {
+
+FrameBufferPool::FrameBufferPool(const FrameBufferPoolOptions& options)
+    : options_(options) {
+  assert(options_.capacity > 0);
+  buffers_.reserve(options_.capacity);
+}
+
+bool FrameBufferPool::Configure(PixelFormat pixel_format,
+                                const VideoDimensions& dimensions,
+                                const FrameLayout& layout) {
+  if (pixel_format == pixel_format_ && dimensions == dimensions_ &&
+      layout == layout_) {
+    return false;
+  }
+
+  pixel_format_ = pixel_format;
+  dimensions_ = dimensions;
+  layout_ = layout;
+  buffers_.clear();
+  next_index_ = 0;
+  return true;
+}
+
+std::shared_ptr<FrameBuffer> FrameBufferPool::Acquire() {
+  const auto count = buffers_.size();
+  for (size_t i = 0; i < count; i++) {
+    const auto index = (next_index_ + i) % count;
+    const auto& buffer = buffers_[index];
+    // Only this thread can add references, so once the count has dropped to
+    // our own reference it can't increase behind our back.
+    if (buffer.use_count() == 1) {
+      // Pairs with the release performed by the consumer dropping its
+      // reference so that its reads happen before we hand out the buffer
+      // for writing again.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      next_index_ = (index + 1) % count;
+      return buffer;
+    }
+  }
+
+  if (count >= options_.capacity || layout_.plane_count == 0) {
+    return nullptr;
+  }
+
+  auto buffer = std::make_shared<FrameBuffer>(
+      pixel_format_, dimensions_, layout_, options_.use_huge_pages);
+  if (!buffer->is_valid()) {
+    return nullptr;
+  }
+  buffers_.push_back(buffer);
+  next_index_ = 0;
+  return buffer;
+}
+
+}  // namespace foxglove
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "video/frame_buffer.h"
+
+namespace foxglove {
+
+struct FrameBufferPoolOptions {
+  // Maximum number of buffers that are allocated for a given format.
+  size_t capacity = 3;
+  bool use_huge_pages = false;
+};
+
+// Keeps up to |capacity| frame buffers alive across frames.
+//
+// A buffer is considered free once all references handed out by Acquire()
+// have been dropped, so consumers may hold on to a frame (on any thread) for
+// as long as they need it. Configure() and Acquire() must be called from the
+// same thread.
+class FrameBufferPool final {
+ public:
+  explicit FrameBufferPool(const FrameBufferPoolOptions& options);
+
+  // Discards all pooled buffers if |pixel_format|, |dimensions| or |layout|
+  // differ from the current configuration. Buffers that are still referenced
+  // elsewhere are released once their last reference goes away.
+  // Returns true if the configuration changed.
+  bool Configure(PixelFormat pixel_format, const VideoDimensions& dimensions,
+                 const FrameLayout& layout);
+
+  // Returns an unreferenced buffer, or nullptr if all |capacity| buffers
+  // are in use.
+  std::shared_ptr<FrameBuffer> Acquire();
+
+  PixelFormat pixel_format() const { return pixel_format_; }
+  const VideoDimensions& dimensions() const { return dimensions_; }
+  const FrameLayout& layout() const { return layout_; }
+  const FrameBufferPoolOptions& options() const { return options_; }
+  size_t allocated_count() const { return buffers_.size(); }
+
+ private:
+  FrameBufferPoolOptions options_;
+  PixelFormat pixel_format_ = PixelFormat::kNone;
+  VideoDimensions dimensions_;
+  FrameLayout layout_;
+  std::vector<std::shared_ptr<FrameBuffer>> buffers_;
+  size_t next_index_ = 0;
+};
+
+}  // namespace foxglove
@@ -0,0 +1,87 @@
+#include "video/frame_c_api.h"
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "video/frame_layout.h"
+#include "video/frame_source.h"
+#include "video/pixel_format.h"
+
+static_assert(FOXGLOVE_FRAME_MAX_PLANES == foxglove::kMaxPlanes);
+static_assert(FOXGLOVE_PIXEL_FORMAT_NONE ==
+              static_cast<int>(foxglove::PixelFormat::kNone));
+static_assert(FOXGLOVE_PIXEL_FORMAT_RGBA ==
+              static_cast<int>(foxglove::PixelFormat::kFormatRGBA));
+static_assert(FOXGLOVE_PIXEL_FORMAT_BGRA ==
+              static_cast<int>(foxglove::PixelFormat::kFormatBGRA));
+static_assert(FOXGLOVE_PIXEL_FORMAT_I420 ==
+              static_cast<int>(foxglove::PixelFormat::kFormatI420));
+static_assert(FOXGLOVE_PIXEL_FORMAT_NV12 ==
+              static_cast<int>(foxglove::PixelFormat::kFormatNV12));
+
+struct foxglove_frame {
+  std::atomic<uint32_t> ref_count{1};
+  std::shared_ptr<const foxglove::FrameBuffer> buffer;
+  foxglove_frame_info info{};
+};
+
+namespace {
+
+void FillInfo(const foxglove::FrameBuffer& buffer, foxglove_frame_info* info) {
+  const auto& layout = buffer.layout();
+  info->pixel_format = static_cast<int32_t>(buffer.pixel_format());
+  info->width = buffer.dimensions().width;
+  info->height = buffer.dimensions().height;
+  info->plane_count = layout.plane_count;
+  for (uint32_t i = 0; i < layout.plane_count; i++) {
+    info->planes[i] = buffer.plane(i);
+    info->pitches[i] = layout.pitches[i];
+    info->lines[i] = layout.lines[i];
+  }
+  info->pts_us = buffer.timing().pts_us;
+  info->sequence = buffer.timing().sequence;
+}
+
+}  // namespace
+
+uint32_t foxglove_frame_api_version(void) {
+  return FOXGLOVE_FRAME_API_VERSION;
+}
+
+foxglove_frame* foxglove_frame_acquire(foxglove_frame_source* source,
+                                       uint64_t after_sequence) {
+  if (!source) {
+    return nullptr;
+  }
+  auto buffer = foxglove::FrameSource::FromCHandle(source)->AcquireLatest(
+      after_sequence);
+  if (!buffer) {
+    return nullptr;
+  }
+  auto* frame = new (std::nothrow) foxglove_frame();
+  if (!frame) {
+    return nullptr;
+  }
+  FillInfo(*buffer, &frame->info);
+  frame->buffer = std::move(buffer);
+  return frame;
+}
+
+void foxglove_frame_retain(foxglove_frame* frame) {
+  if (frame) {
+    frame->ref_count.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void foxglove_frame_release(foxglove_frame* frame) {
+  if (frame && frame->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete frame;
+  }
+}
+
+const foxglove_frame_info* foxglove_frame_get_info(
+    const foxglove_frame* frame) {
+  return frame ? &frame->info : nullptr;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+
+// C interface for reading decoded frames in place, e.g. through Dart FFI or
+// ctypes. Frames come from a FrameSource (video/frame_source.h) whose
+// handle the embedder passes to the consumer. Only append to the
+// structures below, and bump FOXGLOVE_FRAME_API_VERSION when doing so.
+//
+// frame_c_api.cc isn't part of foxglove_core. The linker would drop it from
+// the static library since nothing references it, so the module exporting
+// the API compiles it and defines FOXGLOVE_BUILDING_C_API.
+
+#if defined(_WIN32)
+#if defined(FOXGLOVE_BUILDING_C_API)
+#define FOXGLOVE_C_API __declspec(dllexport)
+#else
+#define FOXGLOVE_C_API __declspec(dllimport)
+#endif
+#else
+#define FOXGLOVE_C_API __attribute__((visibility("default")))
+#endif
+
+#define FOXGLOVE_FRAME_API_VERSION 1
+#define FOXGLOVE_FRAME_MAX_PLANES 3
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Same values as foxglove::PixelFormat.
+enum {
+  FOXGLOVE_PIXEL_FORMAT_NONE = 0,
+  FOXGLOVE_PIXEL_FORMAT_RGBA = 1,
+  FOXGLOVE_PIXEL_FORMAT_BGRA = 2,
+  FOXGLOVE_PIXEL_FORMAT_I420 = 3,
+  FOXGLOVE_PIXEL_FORMAT_NV12 = 4
+};
+
+typedef struct foxglove_frame_source foxglove_frame_source;
+typedef struct foxglove_frame foxglove_frame;
+
+typedef struct foxglove_frame_info {
+  int32_t pixel_format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t plane_count;
+  // Read-only, valid until the frame is released.
+  const uint8_t* planes[FOXGLOVE_FRAME_MAX_PLANES];
+  uint32_t pitches[FOXGLOVE_FRAME_MAX_PLANES];
+  uint32_t lines[FOXGLOVE_FRAME_MAX_PLANES];
+  // Media time in microseconds, -1 if unknown.
+  int64_t pts_us;
+  // Increases by one for every decoded picture.
+  uint64_t sequence;
+} foxglove_frame_info;
+
+FOXGLOVE_C_API uint32_t foxglove_frame_api_version(void);
+
+// Returns a reference to the newest frame of |source| if its sequence is
+// greater than |after_sequence| (0 accepts any frame), NULL otherwise. Any
+// thread may acquire and release frames.
+FOXGLOVE_C_API foxglove_frame* foxglove_frame_acquire(
+    foxglove_frame_source* source, uint64_t after_sequence);
+// Adds a reference, every reference needs its own release.
+FOXGLOVE_C_API void foxglove_frame_retain(foxglove_frame* frame);
+FOXGLOVE_C_API void foxglove_frame_release(foxglove_frame* frame);
+
+// Valid until the frame is released.
+FOXGLOVE_C_API const foxglove_frame_info* foxglove_frame_get_info(
+    const foxglove_frame* frame);
+
+#if defined(__cplusplus)
+}  // extern "C"
+#endif
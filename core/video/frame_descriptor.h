@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "video/frame_layout.h"
+#include "video/video_dimensions.h"
+
+namespace foxglove {
+
+// Returns the monotonic clock all frame timestamps are based on, in
+// microseconds.
+inline int64_t MonotonicTimeUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct FrameTiming {
+  // Increases by one for every picture the decoder delivers to the output,
+  // so gaps indicate dropped or skipped frames.
+  uint64_t sequence = 0;
+  // Media time of the picture in microseconds, -1 if unknown.
+  int64_t pts_us = -1;
+  // When the decoder started writing the picture into the output buffer.
+  int64_t decoded_at_us = 0;
+  // When the picture was handed to the delegate.
+  int64_t presented_at_us = 0;
+};
+
+// Coefficients used to convert limited range YUV to RGB.
+enum class YuvMatrix { kBt601, kBt709 };
+
+// Returns the matrix that's conventionally used for content of the given
+// height when the stream doesn't signal one. Pass the height of the decoded
+// picture, not of a cropped or scaled copy.
+inline YuvMatrix DefaultYuvMatrix(uint32_t height) {
+  return height >= 720 ? YuvMatrix::kBt709 : YuvMatrix::kBt601;
+}
+
+struct FrameDescriptor {
+  PixelFormat pixel_format = PixelFormat::kNone;
+  VideoDimensions dimensions;
+  FrameLayout layout;
+  FrameTiming timing;
+  // Matrix of the source video, kept for YUV pictures that get cropped or
+  // scaled before they're converted to RGB.
+  YuvMatrix yuv_matrix = YuvMatrix::kBt601;
+};
+
+}  // namespace foxglove
@@ -0,0 +1,182 @@
+#include "video/frame_fan_out.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace foxglove {
+
+struct FrameFanOutDelegate::Sink {
+  SinkId id;
+  std::unique_ptr<PixelBufferOutputDelegate> delegate;
+  // Set if the delegate wants pooled frames. Only accessed by the sink's
+  // thread.
+  std::unique_ptr<FrameBufferPool> pool;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::shared_ptr<FrameBuffer> pending_frame;
+  bool stopped = false;
+  std::thread thread;
+
+  // Only accessed by the sink's thread.
+  std::optional<FrameDescriptor> format;
+
+  std::atomic<uint64_t> frames_presented = 0;
+  std::atomic<uint64_t> frames_dropped = 0;
+};
+
+FrameFanOutDelegate::FrameFanOutDelegate(const FrameFanOutOptions& options)
+    : options_(options) {}
+
+FrameFanOutDelegate::~FrameFanOutDelegate() {
+  std::vector<std::shared_ptr<Sink>> sinks;
+  {
+    const std::lock_guard<std::mutex> lock(sinks_mutex_);
+    sinks.swap(sinks_);
+  }
+  for (auto& sink : sinks) {
+    StopSink(sink.get());
+  }
+}
+
+FrameFanOutDelegate::SinkId FrameFanOutDelegate::AddSink(
+    std::unique_ptr<PixelBufferOutputDelegate> delegate) {
+  auto sink = std::make_shared<Sink>();
+  sink->delegate = std::move(delegate);
+  if (auto pool_options = sink->delegate->frame_buffer_pool_options()) {
+    sink->pool = std::make_unique<FrameBufferPool>(pool_options.value());
+  }
+  sink->thread = std::thread(&FrameFanOutDelegate::RunSink, sink.get());
+
+  const std::lock_guard<std::mutex> lock(sinks_mutex_);
+  sink->id = next_sink_id_++;
+  sinks_.push_back(sink);
+  return sink->id;
+}
+
+bool FrameFanOutDelegate::RemoveSink(SinkId id) {
+  std::shared_ptr<Sink> sink;
+  {
+    const std::lock_guard<std::mutex> lock(sinks_mutex_);
+    auto it = std::find_if(sinks_.begin(), sinks_.end(),
+                           [id](const auto& sink) { return sink->id == id; });
+    if (it == sinks_.end()) {
+      return false;
+    }
+    sink = std::move(*it);
+    sinks_.erase(it);
+  }
+  StopSink(sink.get());
+  return true;
+}
+
+std::optional<FrameFanOutSinkStats> FrameFanOutDelegate::sink_stats(
+    SinkId id) const {
+  const std::lock_guard<std::mutex> lock(sinks_mutex_);
+  for (const auto& sink : sinks_) {
+    if (sink->id == id) {
+      FrameFanOutSinkStats stats;
+      stats.frames_presented = sink->frames_presented;
+      stats.frames_dropped = sink->frames_dropped;
+      return stats;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<FrameBufferPoolOptions>
+FrameFanOutDelegate::frame_buffer_pool_options() const {
+  FrameBufferPoolOptions pool_options;
+  // Plus one for the frame being decoded.
+  pool_options.capacity = options_.expected_sinks * 2 + 1;
+  return pool_options;
+}
+
+void FrameFanOutDelegate::PresentFrame(std::shared_ptr<FrameBuffer> frame) {
+  const std::lock_guard<std::mutex> lock(sinks_mutex_);
+  for (const auto& sink : sinks_) {
+    std::shared_ptr<FrameBuffer> replaced;
+    {
+      const std::lock_guard<std::mutex> sink_lock(sink->mutex);
+      replaced = std::exchange(sink->pending_frame, frame);
+    }
+    if (replaced) {
+      sink->frames_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    sink->cv.notify_one();
+  }
+}
+
+void FrameFanOutDelegate::StopSink(Sink* sink) {
+  {
+    const std::lock_guard<std::mutex> lock(sink->mutex);
+    sink->stopped = true;
+  }
+  sink->cv.notify_one();
+  sink->thread.join();
+}
+
+void FrameFanOutDelegate::RunSink(Sink* sink) {
+  while (true) {
+    std::shared_ptr<FrameBuffer> frame;
+    {
+      std::unique_lock<std::mutex> lock(sink->mutex);
+      sink->cv.wait(lock,
+                    [sink] { return sink->stopped || sink->pending_frame; });
+      if (sink->stopped) {
+        return;
+      }
+      frame = std::move(sink->pending_frame);
+    }
+    PresentToSink(sink, std::move(frame));
+  }
+}
+
+void FrameFanOutDelegate::PresentToSink(Sink* sink,
+                                        std::shared_ptr<FrameBuffer> frame) {
+  const auto descriptor = frame->descriptor();
+  if (!sink->format || sink->format->pixel_format != descriptor.pixel_format ||
+      sink->format->dimensions != descriptor.dimensions ||
+      sink->format->layout != descriptor.layout) {
+    sink->delegate->OnFormatChanged(descriptor.pixel_format,
+                                    descriptor.dimensions, descriptor.layout);
+    sink->format = descriptor;
+  }
+
+  if (sink->pool) {
+    PresentPooledCopy(sink, std::move(frame));
+    return;
+  }
+
+  if (PresentFrameTo(sink->delegate.get(), std::move(frame))) {
+    sink->frames_presented.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    // The sink has no buffer available, treat it like a dropped frame.
+    sink->frames_dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void FrameFanOutDelegate::PresentPooledCopy(
+    Sink* sink, std::shared_ptr<FrameBuffer> frame) {
+  const auto& layout = frame->layout();
+  sink->pool->Configure(frame->pixel_format(), frame->dimensions(), layout);
+  auto copy = sink->pool->Acquire();
+  if (!copy) {
+    // The sink still holds all of its buffers.
+    sink->frames_dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  for (uint32_t i = 0; i < layout.plane_count; i++) {
+    memcpy(copy->plane(i), frame->plane(i), layout.plane_size(i));
+  }
+  copy->set_timing(frame->timing());
+  copy->set_yuv_matrix(frame->yuv_matrix());
+  // Hand the frame back to the shared pool as early as possible.
+  frame.reset();
+  sink->delegate->PresentFrame(std::move(copy));
+  sink->frames_presented.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace foxglove
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "video/pixel_buffer_output.h"
+
+namespace foxglove {
+
+struct FrameFanOutOptions {
+  // Sizes the shared frame pool. Every sink holds up to two shared frames
+  // (one queued, one being copied), more sinks work but may see extra drops.
+  size_t expected_sinks = 4;
+};
+
+struct FrameFanOutSinkStats {
+  uint64_t frames_presented = 0;
+  // Frames replaced by a newer one before the sink got to them, or that the
+  // sink had no buffer for.
+  uint64_t frames_dropped = 0;
+};
+
+// Presents every decoded frame to any number of sinks, so a stream shown in
+// several places gets decoded once. Each sink runs on its own thread and
+// always picks up the newest frame, so a slow sink only drops its own
+// frames. Sinks that provide pool options get the frame copied into a pool
+// of their own sized by those options, so a sink holding on to frames can't
+// starve the others. All other sinks get it copied into the buffer returned
+// by their LockBuffer().
+class FrameFanOutDelegate : public PooledPixelBufferOutputDelegate {
+ public:
+  typedef uint64_t SinkId;
+
+  explicit FrameFanOutDelegate(const FrameFanOutOptions& options = {});
+  ~FrameFanOutDelegate() override;
+
+  // May be called from any thread.
+  SinkId AddSink(std::unique_ptr<PixelBufferOutputDelegate> sink);
+  // Waits for the sink to finish presenting. Returns false if there's no
+  // such sink.
+  bool RemoveSink(SinkId id);
+  std::optional<FrameFanOutSinkStats> sink_stats(SinkId id) const;
+
+  std::optional<FrameBufferPoolOptions> frame_buffer_pool_options()
+      const override;
+  void PresentFrame(std::shared_ptr<FrameBuffer> frame) override;
+
+ private:
+  struct Sink;
+
+  FrameFanOutOptions options_;
+  mutable std::mutex sinks_mutex_;
+  std::vector<std::shared_ptr<Sink>> sinks_;
+  SinkId next_sink_id_ = 1;
+
+  static void RunSink(Sink* sink);
+  static void PresentToSink(Sink* sink, std::shared_ptr<FrameBuffer> frame);
+  static void PresentPooledCopy(Sink* sink,
+                                std::shared_ptr<FrameBuffer> frame);
+  static void StopSink(Sink* sink);
+};
+
+}  // namespace foxglove
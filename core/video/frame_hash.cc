@@ -0,0 +1,152 @@
+#include "video/frame_hash.h"
+
+#include <cstring>
+
+#include "base/cpu_features.h"
+
+namespace foxglove {
+
+namespace {
+
+constexpr size_t kStripeSize = 64;
+// Accumulators get scrambled after every block of stripes.
+constexpr size_t kStripesPerBlock = 16;
+
+constexpr uint32_t kPrime32 = 0x9e3779b1u;
+constexpr uint64_t kPrime64_1 = 0x9e3779b185ebca87ull;
+constexpr uint64_t kPrime64_2 = 0xc2b2ae3d27d4eb4full;
+constexpr uint64_t kPrime64_3 = 0x165667b19e3779f9ull;
+
+alignas(16) constexpr uint64_t kSecret[8] = {
+    0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull,
+    0x1f67b3b7a4a44072ull, 0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull,
+    0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull};
+
+inline uint64_t Load64(const uint8_t* p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint64_t RotateLeft(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+void AccumulateStripeScalar(uint64_t* acc, const uint8_t* stripe) {
+  for (size_t i = 0; i < 8; i++) {
+    const auto value = Load64(stripe + i * 8);
+    const auto keyed = value ^ kSecret[i];
+    acc[i ^ 1] += value;
+    acc[i] += (keyed & 0xffffffff) * (keyed >> 32);
+  }
+}
+
+#ifdef FOXGLOVE_HAS_SSE2
+
+size_t AccumulateSse2(uint64_t* acc, const uint8_t* data, size_t size) {
+  const auto* secret = reinterpret_cast<const __m128i*>(kSecret);
+  const auto prime = _mm_set1_epi32(static_cast<int>(kPrime32));
+  __m128i acc_v[4];
+  for (size_t j = 0; j < 4; j++) {
+    acc_v[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc) + j);
+  }
+
+  size_t offset = 0;
+  size_t stripes = 0;
+  for (; offset + kStripeSize <= size; offset += kStripeSize) {
+    const auto* stripe = reinterpret_cast<const __m128i*>(data + offset);
+    for (size_t j = 0; j < 4; j++) {
+      const auto value = _mm_loadu_si128(stripe + j);
+      const auto keyed = _mm_xor_si128(value, _mm_load_si128(secret + j));
+      const auto product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+      const auto swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+      acc_v[j] = _mm_add_epi64(acc_v[j], _mm_add_epi64(product, swapped));
+    }
+
+    if (++stripes == kStripesPerBlock) {
+      for (size_t j = 0; j < 4; j++) {
+        auto value = _mm_xor_si128(acc_v[j], _mm_srli_epi64(acc_v[j], 47));
+        value = _mm_xor_si128(value, _mm_load_si128(secret + j));
+        // 64 x 32 bit multiplication from two 32 x 32 bit halves.
+        const auto lo = _mm_mul_epu32(value, prime);
+        const auto hi = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+        acc_v[j] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+      }
+      stripes = 0;
+    }
+  }
+
+  for (size_t j = 0; j < 4; j++) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(acc) + j, acc_v[j]);
+  }
+  return offset;
+}
+
+#else
+
+void ScrambleScalar(uint64_t* acc) {
+  for (size_t i = 0; i < 8; i++) {
+    auto value = acc[i];
+    value ^= value >> 47;
+    value ^= kSecret[i];
+    acc[i] = value * kPrime32;
+  }
+}
+
+// Accumulates all whole blocks and stripes, returns the bytes consumed.
+size_t AccumulateScalar(uint64_t* acc, const uint8_t* data, size_t size) {
+  size_t offset = 0;
+  size_t stripes = 0;
+  for (; offset + kStripeSize <= size; offset += kStripeSize) {
+    AccumulateStripeScalar(acc, data + offset);
+    if (++stripes == kStripesPerBlock) {
+      ScrambleScalar(acc);
+      stripes = 0;
+    }
+  }
+  return offset;
+}
+
+#endif
+
+}  // namespace
+
+uint64_t HashBytes(const uint8_t* data, size_t size, uint64_t seed) {
+  uint64_t acc[8] = {seed,       kPrime64_1, kPrime64_2, kPrime64_3,
+                     ~seed,      kPrime32,   kPrime64_1, kPrime64_2};
+
+#ifdef FOXGLOVE_HAS_SSE2
+  auto offset = AccumulateSse2(acc, data, size);
+#else
+  auto offset = AccumulateScalar(acc, data, size);
+#endif
+
+  if (offset < size) {
+    uint8_t stripe[kStripeSize] = {};
+    memcpy(stripe, data + offset, size - offset);
+    AccumulateStripeScalar(acc, stripe);
+  }
+
+  auto hash = seed + size * kPrime64_1;
+  for (size_t i = 0; i < 8; i++) {
+    hash ^= acc[i] * kPrime64_2;
+    hash = RotateLeft(hash, 31) * kPrime64_1;
+  }
+
+  hash ^= hash >> 33;
+  hash *= kPrime64_2;
+  hash ^= hash >> 29;
+  hash *= kPrime64_3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+uint64_t HashPicture(const uint8_t* const* planes, const FrameLayout& layout) {
+  uint64_t hash = layout.plane_count;
+  for (uint32_t i = 0; i < layout.plane_count; i++) {
+    hash = HashBytes(planes[i], layout.plane_size(i), hash);
+  }
+  return hash;
+}
+
+}  // namespace foxglove
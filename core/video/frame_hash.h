@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "video/frame_layout.h"
+
+namespace foxglove {
+
+// Fast non-cryptographic 64-bit hash used to detect identical pictures.
+// Processes 64 byte stripes with SSE2 where available; all implementations
+// return the same value.
+uint64_t HashBytes(const uint8_t* data, size_t size, uint64_t seed = 0);
+
+// Hashes all planes of a picture.
+uint64_t HashPicture(const uint8_t* const* planes, const FrameLayout& layout);
+
+}  // namespace foxglove
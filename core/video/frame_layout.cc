@@ -0,0 +1,33 @@
+#include "video/frame_layout.h"
+
+namespace foxglove {
+
+FrameLayout ComputeFrameLayout(PixelFormat format, uint32_t width,
+                               uint32_t height) {
+  const auto chroma_width = (width + 1) / 2;
+  const auto chroma_height = (height + 1) / 2;
+
+  FrameLayout layout;
+  switch (format) {
+    case PixelFormat::kFormatI420:
+      layout.plane_count = 3;
+      layout.pitches = {width, chroma_width, chroma_width};
+      layout.lines = {height, chroma_height, chroma_height};
+      break;
+    case PixelFormat::kFormatNV12:
+      layout.plane_count = 2;
+      layout.pitches = {width, chroma_width * 2, 0};
+      layout.lines = {height, chroma_height, 0};
+      break;
+    case PixelFormat::kFormatRGBA:
+    case PixelFormat::kFormatBGRA:
+    default:
+      layout.plane_count = 1;
+      layout.pitches = {width * 4, 0, 0};
+      layout.lines = {height, 0, 0};
+      break;
+  }
+  return layout;
+}
+
+}  // namespace foxglove
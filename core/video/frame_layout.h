@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "video/pixel_format.h"
+
+namespace foxglove {
+
+constexpr size_t kMaxPlanes = 3;
+
+// Describes the memory layout of a (possibly planar) picture as negotiated
+// with the decoder.
+struct FrameLayout {
+  uint32_t plane_count = 0;
+  std::array<uint32_t, kMaxPlanes> pitches{};
+  std::array<uint32_t, kMaxPlanes> lines{};
+
+  size_t plane_size(size_t plane) const {
+    return static_cast<size_t>(pitches[plane]) * lines[plane];
+  }
+
+  bool operator==(const FrameLayout& other) const {
+    return plane_count == other.plane_count && pitches == other.pitches &&
+           lines == other.lines;
+  }
+  bool operator!=(const FrameLayout& other) const {
+    return !operator==(other);
+  }
+};
+
+// Returns the tightly packed layout of a |width| x |height| picture.
+// Chroma planes of 4:2:0 formats are rounded up for odd dimensions.
+FrameLayout ComputeFrameLayout(PixelFormat format, uint32_t width,
+                               uint32_t height);
+
+}  // namespace foxglove
@@ -0,0 +1,107 @@
+#include "video/frame_mailbox.h"
+
+#include <cassert>
+
+namespace foxglove {
+
+void FrameMailbox::Configure(PixelFormat pixel_format,
+                             const VideoDimensions& dimensions,
+                             const FrameLayout& layout) {
+  pixel_format_ = pixel_format;
+  dimensions_ = dimensions;
+  layout_ = layout;
+}
+
+FrameBuffer* FrameMailbox::BeginWrite() {
+  auto& slot = slots_[back_];
+  // The back slot is exclusively owned by the producer, so stale slots can
+  // be replaced here without synchronizing with the consumer.
+  if (!slot || slot->pixel_format() != pixel_format_ ||
+      slot->dimensions() != dimensions_ || slot->layout() != layout_) {
+    slot = std::make_unique<FrameBuffer>(pixel_format_, dimensions_, layout_);
+    if (!slot->is_valid()) {
+      slot.reset();
+      return nullptr;
+    }
+  }
+  return slot.get();
+}
+
+void FrameMailbox::Publish(const FrameTiming& timing, YuvMatrix yuv_matrix) {
+  assert(slots_[back_]);
+  slots_[back_]->set_timing(timing);
+  slots_[back_]->set_yuv_matrix(yuv_matrix);
+  const auto previous =
+      middle_.exchange(back_ | kFreshBit, std::memory_order_acq_rel);
+  back_ = previous & kIndexMask;
+
+  frames_produced_.fetch_add(1, std::memory_order_relaxed);
+  if (previous & kFreshBit) {
+    frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+const FrameBuffer* FrameMailbox::AcquireLatest(bool* is_new) {
+  const bool has_fresh_frame =
+      (middle_.load(std::memory_order_relaxed) & kFreshBit) != 0;
+  if (has_fresh_frame) {
+    const auto previous = middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = previous & kIndexMask;
+    has_front_ = true;
+    frames_consumed_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (is_new) {
+    *is_new = has_fresh_frame;
+  }
+  return has_front_ ? slots_[front_].get() : nullptr;
+}
+
+FrameMailboxStats FrameMailbox::stats() const {
+  FrameMailboxStats stats;
+  stats.frames_produced = frames_produced_.load(std::memory_order_relaxed);
+  stats.frames_consumed = frames_consumed_.load(std::memory_order_relaxed);
+  stats.frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+FrameMailboxOutputDelegate::FrameMailboxOutputDelegate(
+    std::shared_ptr<FrameMailbox> mailbox, Closure frame_available)
+    : mailbox_(std::move(mailbox)),
+      frame_available_(std::move(frame_available)) {}
+
+void FrameMailboxOutputDelegate::OnFormatChanged(
+    PixelFormat pixel_format, const VideoDimensions& dimensions,
+    const FrameLayout& layout) {
+  mailbox_->Configure(pixel_format, dimensions, layout);
+}
+
+void* FrameMailboxOutputDelegate::LockBuffer(
+    void** buffer, const VideoDimensions& /*dimensions*/) {
+  auto slot = mailbox_->BeginWrite();
+  if (slot) {
+    slot->GetPlanes(buffer);
+  }
+  return slot;
+}
+
+void FrameMailboxOutputDelegate::PresentBuffer(
+    const VideoDimensions& dimensions, void* user_data) {
+  FrameDescriptor frame;
+  frame.dimensions = dimensions;
+  PresentBuffer(frame, user_data);
+}
+
+void FrameMailboxOutputDelegate::PresentBuffer(const FrameDescriptor& frame,
+                                               void* user_data) {
+  if (!user_data) {
+    return;
+  }
+
+  mailbox_->Publish(frame.timing, frame.yuv_matrix);
+  if (frame_available_) {
+    frame_available_();
+  }
+}
+
+}  // namespace foxglove
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+#include "base/closure.h"
+#include "video/frame_buffer.h"
+#include "video/pixel_buffer_output.h"
+
+namespace foxglove {
+
+struct FrameMailboxStats {
+  uint64_t frames_produced = 0;
+  uint64_t frames_consumed = 0;
+  // Frames that got replaced by a newer one before the consumer saw them.
+  uint64_t frames_dropped = 0;
+};
+
+// Lock-free triple buffer that always hands the newest completed frame to
+// a single consumer while a single producer keeps writing into a free slot,
+// so neither side ever waits for the other.
+class FrameMailbox final {
+ public:
+  FrameMailbox() = default;
+
+  FrameMailbox(const FrameMailbox&) = delete;
+  FrameMailbox& operator=(const FrameMailbox&) = delete;
+
+  // Producer side. Must be called from a single thread.
+  void Configure(PixelFormat pixel_format, const VideoDimensions& dimensions,
+                 const FrameLayout& layout);
+  // Returns the slot to decode into, or nullptr if allocating it failed.
+  FrameBuffer* BeginWrite();
+  // Makes the slot returned by BeginWrite() the newest frame.
+  void Publish(const FrameTiming& timing = {},
+               YuvMatrix yuv_matrix = YuvMatrix::kBt601);
+
+  // Consumer side. Must be called from a single thread.
+  // Returns the newest published frame, or nullptr if there's none yet.
+  // The frame stays valid until the next call. |is_new| is set to whether
+  // the frame wasn't returned before.
+  const FrameBuffer* AcquireLatest(bool* is_new = nullptr);
+
+  FrameMailboxStats stats() const;
+
+ private:
+  static constexpr uint8_t kIndexMask = 0x3;
+  static constexpr uint8_t kFreshBit = 0x4;
+
+  std::array<std::unique_ptr<FrameBuffer>, 3> slots_;
+  // Index of the slot in transit between producer and consumer, plus
+  // kFreshBit if it holds a frame the consumer hasn't picked up.
+  std::atomic<uint8_t> middle_{1};
+  uint8_t back_ = 0;
+  uint8_t front_ = 2;
+  bool has_front_ = false;
+
+  PixelFormat pixel_format_ = PixelFormat::kNone;
+  VideoDimensions dimensions_;
+  FrameLayout layout_;
+
+  std::atomic<uint64_t> frames_produced_ = 0;
+  std::atomic<uint64_t> frames_consumed_ = 0;
+  std::atomic<uint64_t> frames_dropped_ = 0;
+};
+
+// Decodes into a FrameMailbox instead of presenting frames synchronously on
+// the vout thread, so a slow consumer never stalls decoding.
+class FrameMailboxOutputDelegate : public PixelBufferOutputDelegate {
+ public:
+  // |frame_available| is invoked on the vout thread after every published
+  // frame and must not block.
+  FrameMailboxOutputDelegate(std::shared_ptr<FrameMailbox> mailbox,
+                             Closure frame_available = nullptr);
+
+  void OnFormatChanged(PixelFormat pixel_format,
+                       const VideoDimensions& dimensions,
+                       const FrameLayout& layout) override;
+  void* LockBuffer(void** buffer, const VideoDimensions& dimensions) override;
+  void PresentBuffer(const VideoDimensions& dimensions,
+                     void* user_data) override;
+  void PresentBuffer(const FrameDescriptor& frame, void* user_data) override;
+
+  FrameMailbox* mailbox() const { return mailbox_.get(); }
+
+ private:
+  std::shared_ptr<FrameMailbox> mailbox_;
+  Closure frame_available_;
+};
+
+}  // namespace foxglove
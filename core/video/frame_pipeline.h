@@ -0,0 +1,304 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+#include "video/convert/convert.h"
+#include "video/frame_analyzer.h"
+#include "video/frame_buffer.h"
+#include "video/pixel_buffer_output.h"
+
+namespace foxglove {
+namespace pipeline {
+
+// A picture travelling through a pipeline. The planes point into the
+// decoded frame or into a stage's buffer and are only valid until the stage
+// that passed it on returns.
+struct FrameView {
+  FrameDescriptor descriptor;
+  std::array<const uint8_t*, kMaxPlanes> planes{};
+};
+
+// Chains stages at compile time. Every stage implements
+//
+//   template <typename Next>
+//   void Process(const FrameView& frame, Next&& next);
+//
+// and calls |next| with its result, or not at all to drop the frame. The
+// calls get inlined into a single function per pipeline, so there are no
+// virtual calls and no copies between stages that don't need one.
+//
+//   pipeline::FramePipeline pipeline(
+//       pipeline::Crop({0, 0, 640, 360}),
+//       pipeline::Convert<PixelFormat::kFormatRGBA>(),
+//       pipeline::Scale<224, 224>(),
+//       pipeline::Sink([](const pipeline::FrameView& frame) { ... }));
+//
+// Pipelines aren't thread safe, run each on a single thread.
+template <typename... Stages>
+class FramePipeline final {
+ public:
+  explicit FramePipeline(Stages... stages) : stages_(std::move(stages)...) {}
+
+  void Process(const FrameView& frame) { Run<0>(frame); }
+
+  template <size_t I>
+  auto& stage() {
+    return std::get<I>(stages_);
+  }
+
+ private:
+  std::tuple<Stages...> stages_;
+
+  template <size_t I>
+  void Run(const FrameView& frame) {
+    if constexpr (I < sizeof...(Stages)) {
+      std::get<I>(stages_).Process(
+          frame, [this](const FrameView& result) { Run<I + 1>(result); });
+    }
+  }
+};
+
+// Passes on part of the frame by offsetting its planes, without copying.
+// Clipped to the frame, and aligned to even pixels for 4:2:0 formats.
+class Crop final {
+ public:
+  explicit Crop(const VideoRect& rect) : rect_(rect) {}
+
+  void set_rect(const VideoRect& rect) { rect_ = rect; }
+
+  template <typename Next>
+  void Process(const FrameView& frame, Next&& next) {
+    const auto format = frame.descriptor.pixel_format;
+    auto rect = rect_.ClippedTo(frame.descriptor.dimensions.width,
+                                frame.descriptor.dimensions.height);
+    if (IsPlanarFormat(format)) {
+      rect.x &= ~1u;
+      rect.y &= ~1u;
+    }
+    if (rect.is_empty()) {
+      return;
+    }
+
+    FrameView cropped = frame;
+    cropped.descriptor.dimensions.width = rect.width;
+    cropped.descriptor.dimensions.height = rect.height;
+    auto& layout = cropped.descriptor.layout;
+    for (uint32_t i = 0; i < layout.plane_count; i++) {
+      const size_t pitch = layout.pitches[i];
+      size_t offset;
+      if (!IsPlanarFormat(format)) {
+        offset = rect.y * pitch + static_cast<size_t>(rect.x) * 4;
+      } else if (i == 0) {
+        offset = rect.y * pitch + rect.x;
+      } else {
+        // NV12 interleaves U and V, so its chroma rows are as wide as luma
+        // rows.
+        const size_t chroma_x =
+            format == PixelFormat::kFormatNV12 ? rect.x : rect.x / 2;
+        offset = (rect.y / 2) * pitch + chroma_x;
+      }
+      cropped.planes[i] = frame.planes[i] + offset;
+      layout.lines[i] = i == 0 || !IsPlanarFormat(format)
+                            ? rect.height
+                            : (rect.height + 1) / 2;
+    }
+    next(cropped);
+  }
+
+ private:
+  VideoRect rect_;
+};
+
+// Converts frames to |kFormat|. Frames already in that format are passed on
+// as is. Place it after a Crop to only convert the visible part.
+template <PixelFormat kFormat>
+class Convert final {
+ public:
+  static_assert(kFormat != PixelFormat::kNone);
+
+  template <typename Next>
+  void Process(const FrameView& frame, Next&& next) {
+    const auto& descriptor = frame.descriptor;
+    if (descriptor.pixel_format == kFormat) {
+      next(frame);
+      return;
+    }
+    const auto width = descriptor.dimensions.width;
+    const auto height = descriptor.dimensions.height;
+    if (!buffer_ || buffer_->dimensions().width != width ||
+        buffer_->dimensions().height != height) {
+      const auto layout = ComputeFrameLayout(kFormat, width, height);
+      buffer_ = std::make_unique<FrameBuffer>(
+          kFormat, VideoDimensions(width, height, layout.pitches[0]), layout);
+    }
+
+    uint8_t* dst_planes[kMaxPlanes] = {};
+    FrameView converted;
+    for (uint32_t i = 0; i < buffer_->layout().plane_count; i++) {
+      dst_planes[i] = buffer_->plane(i);
+      converted.planes[i] = dst_planes[i];
+    }
+    if (!convert::ConvertPicture(descriptor.pixel_format, frame.planes.data(),
+                                 descriptor.layout, kFormat, dst_planes,
+                                 buffer_->layout(), width, height,
+                                 descriptor.yuv_matrix)) {
+      return;
+    }
+    converted.descriptor = buffer_->descriptor();
+    converted.descriptor.timing = descriptor.timing;
+    converted.descriptor.yuv_matrix = descriptor.yuv_matrix;
+    next(converted);
+  }
+
+ private:
+  std::unique_ptr<FrameBuffer> buffer_;
+};
+
+// Scales RGBA or BGRA frames to |kWidth| x |kHeight| (bilinear) into a
+// buffer allocated once. Frames of that size are passed on as is, other
+// formats are dropped.
+template <uint32_t kWidth, uint32_t kHeight>
+class Scale final {
+ public:
+  static_assert(kWidth > 0 && kHeight > 0);
+
+  Scale()
+      : layout_(ComputeFrameLayout(PixelFormat::kFormatRGBA, kWidth,
+                                   kHeight)),
+        buffer_(std::make_unique<FrameBuffer>(
+            PixelFormat::kFormatRGBA,
+            VideoDimensions(kWidth, kHeight, layout_.pitches[0]), layout_)) {}
+
+  template <typename Next>
+  void Process(const FrameView& frame, Next&& next) {
+    const auto& descriptor = frame.descriptor;
+    if (descriptor.pixel_format != PixelFormat::kFormatRGBA &&
+        descriptor.pixel_format != PixelFormat::kFormatBGRA) {
+      return;
+    }
+    const auto width = descriptor.dimensions.width;
+    const auto height = descriptor.dimensions.height;
+    if (width == kWidth && height == kHeight) {
+      next(frame);
+      return;
+    }
+    if (!scaler_ || !scaler_->Matches(width, height, kWidth, kHeight)) {
+      scaler_.emplace(width, height, kWidth, kHeight);
+    }
+    scaler_->Scale(frame.planes[0], descriptor.layout.pitches[0],
+                   buffer_->plane(0), layout_.pitches[0]);
+
+    FrameView scaled;
+    scaled.descriptor = FrameDescriptor{
+        descriptor.pixel_format,
+        VideoDimensions(kWidth, kHeight, layout_.pitches[0]), layout_,
+        descriptor.timing, descriptor.yuv_matrix};
+    scaled.planes[0] = buffer_->plane(0);
+    next(scaled);
+  }
+
+ private:
+  FrameLayout layout_;
+  std::unique_ptr<FrameBuffer> buffer_;
+  std::optional<convert::RgbaScaler> scaler_;
+};
+
+// Calls |analyzer| with every frame and passes it on unchanged.
+template <typename Analyzer>
+class Analyze final {
+ public:
+  explicit Analyze(Analyzer analyzer) : analyzer_(std::move(analyzer)) {}
+
+  Analyzer& analyzer() { return analyzer_; }
+
+  template <typename Next>
+  void Process(const FrameView& frame, Next&& next) {
+    analyzer_(frame);
+    next(frame);
+  }
+
+ private:
+  Analyzer analyzer_;
+};
+
+// Ends a pipeline by handing every frame to |consumer|.
+template <typename Consumer>
+class Sink final {
+ public:
+  explicit Sink(Consumer consumer) : consumer_(std::move(consumer)) {}
+
+  Consumer& consumer() { return consumer_; }
+
+  template <typename Next>
+  void Process(const FrameView& frame, Next&&) {
+    consumer_(frame);
+  }
+
+ private:
+  Consumer consumer_;
+};
+
+// Runs a pipeline on the frames of a pixel buffer output. The output makes
+// one virtual call per frame into the pipeline, none between stages.
+template <typename Pipeline>
+class PipelineOutputDelegate final : public PooledPixelBufferOutputDelegate {
+ public:
+  explicit PipelineOutputDelegate(Pipeline pipeline)
+      : pipeline_(std::move(pipeline)) {}
+
+  Pipeline& pipeline() { return pipeline_; }
+
+  std::optional<FrameBufferPoolOptions> frame_buffer_pool_options()
+      const override {
+    // Frames are processed right away, one being decoded and one going
+    // through the pipeline is enough.
+    FrameBufferPoolOptions pool_options;
+    pool_options.capacity = 2;
+    return pool_options;
+  }
+
+  void PresentFrame(std::shared_ptr<FrameBuffer> frame) override {
+    FrameView view;
+    view.descriptor = frame->descriptor();
+    for (uint32_t i = 0; i < view.descriptor.layout.plane_count; i++) {
+      view.planes[i] = frame->plane(i);
+    }
+    pipeline_.Process(view);
+  }
+
+ private:
+  Pipeline pipeline_;
+};
+
+// Runs a pipeline as a FrameAnalyzer, directly on the picture VLC rendered
+// and before the output copies or converts it.
+template <typename Pipeline>
+class PipelineFrameAnalyzer final : public FrameAnalyzer {
+ public:
+  explicit PipelineFrameAnalyzer(Pipeline pipeline)
+      : pipeline_(std::move(pipeline)) {}
+
+  Pipeline& pipeline() { return pipeline_; }
+
+  void Analyze(const FrameDescriptor& frame,
+               const uint8_t* const* planes) override {
+    FrameView view;
+    view.descriptor = frame;
+    for (uint32_t i = 0; i < frame.layout.plane_count; i++) {
+      view.planes[i] = planes[i];
+    }
+    pipeline_.Process(view);
+  }
+
+ private:
+  Pipeline pipeline_;
+};
+
+}  // namespace pipeline
+}  // namespace foxglove
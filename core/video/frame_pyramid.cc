@@ -0,0 +1,137 @@
+#include "video/frame_pyramid.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "video/convert/convert.h"
+
+namespace foxglove {
+
+FramePyramidDelegate::FramePyramidDelegate(const FramePyramidOptions& options)
+    : options_(options), level_frames_(options.levels) {
+  FrameBufferPoolOptions pool_options;
+  pool_options.capacity = options_.pool_capacity;
+  for (uint32_t i = 0; i < options_.levels; i++) {
+    pools_.push_back(std::make_unique<FrameBufferPool>(pool_options));
+  }
+}
+
+FramePyramidDelegate::ConsumerId FramePyramidDelegate::AddConsumer(
+    uint32_t level, std::unique_ptr<PixelBufferOutputDelegate> consumer) {
+  if (level > options_.levels) {
+    return 0;
+  }
+  auto entry = std::make_unique<Consumer>();
+  entry->level = level;
+  entry->delegate = std::move(consumer);
+
+  const std::lock_guard<std::mutex> lock(consumers_mutex_);
+  entry->id = next_consumer_id_++;
+  consumers_.push_back(std::move(entry));
+  return consumers_.back()->id;
+}
+
+bool FramePyramidDelegate::RemoveConsumer(ConsumerId id) {
+  std::unique_ptr<Consumer> consumer;
+  {
+    const std::lock_guard<std::mutex> lock(consumers_mutex_);
+    auto it = std::find_if(
+        consumers_.begin(), consumers_.end(),
+        [id](const auto& consumer) { return consumer->id == id; });
+    if (it == consumers_.end()) {
+      return false;
+    }
+    consumer = std::move(*it);
+    consumers_.erase(it);
+  }
+  return true;
+}
+
+FramePyramidStats FramePyramidDelegate::stats() const {
+  FramePyramidStats stats;
+  stats.frames_received = frames_received_;
+  stats.levels_computed = levels_computed_;
+  stats.levels_dropped = levels_dropped_;
+  return stats;
+}
+
+std::optional<FrameBufferPoolOptions>
+FramePyramidDelegate::frame_buffer_pool_options() const {
+  FrameBufferPoolOptions pool_options;
+  pool_options.capacity = options_.pool_capacity;
+  return pool_options;
+}
+
+void FramePyramidDelegate::PresentFrame(std::shared_ptr<FrameBuffer> frame) {
+  frames_received_.fetch_add(1, std::memory_order_relaxed);
+
+  const std::lock_guard<std::mutex> lock(consumers_mutex_);
+  uint32_t deepest_level = 0;
+  for (const auto& consumer : consumers_) {
+    deepest_level = std::max(deepest_level, consumer->level);
+  }
+  ComputeLevels(*frame, deepest_level);
+
+  for (const auto& consumer : consumers_) {
+    if (consumer->level == 0) {
+      PresentToConsumer(consumer.get(), frame);
+    } else if (auto& level_frame = level_frames_[consumer->level - 1]) {
+      PresentToConsumer(consumer.get(), level_frame);
+    }
+  }
+
+  // Return the levels to their pools right away.
+  std::fill(level_frames_.begin(), level_frames_.end(), nullptr);
+}
+
+void FramePyramidDelegate::ComputeLevels(const FrameBuffer& frame,
+                                         uint32_t deepest_level) {
+  const auto pixel_format = frame.pixel_format();
+  if (pixel_format != PixelFormat::kFormatRGBA &&
+      pixel_format != PixelFormat::kFormatBGRA) {
+    return;
+  }
+
+  const FrameBuffer* parent = &frame;
+  for (uint32_t level = 1; level <= deepest_level; level++) {
+    const auto width = parent->dimensions().width / 2;
+    const auto height = parent->dimensions().height / 2;
+    if (width == 0 || height == 0) {
+      return;
+    }
+
+    const auto layout = ComputeFrameLayout(pixel_format, width, height);
+    auto& pool = pools_[level - 1];
+    pool->Configure(pixel_format,
+                    VideoDimensions(width, height, layout.pitches[0]), layout);
+    auto level_frame = pool->Acquire();
+    if (!level_frame) {
+      levels_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    convert::HalveRgba(parent->plane(0), parent->pitch(0),
+                       level_frame->plane(0), level_frame->pitch(0), width,
+                       height);
+    level_frame->set_timing(frame.timing());
+    levels_computed_.fetch_add(1, std::memory_order_relaxed);
+    parent = level_frame.get();
+    level_frames_[level - 1] = std::move(level_frame);
+  }
+}
+
+void FramePyramidDelegate::PresentToConsumer(
+    Consumer* consumer, std::shared_ptr<FrameBuffer> frame) {
+  const auto descriptor = frame->descriptor();
+  if (!consumer->format ||
+      consumer->format->pixel_format != descriptor.pixel_format ||
+      consumer->format->dimensions != descriptor.dimensions ||
+      consumer->format->layout != descriptor.layout) {
+    consumer->delegate->OnFormatChanged(
+        descriptor.pixel_format, descriptor.dimensions, descriptor.layout);
+    consumer->format = descriptor;
+  }
+  PresentFrameTo(consumer->delegate.get(), std::move(frame));
+}
+
+}  // namespace foxglove
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "video/pixel_buffer_output.h"
+
+namespace foxglove {
+
+struct FramePyramidOptions {
+  // Number of levels below the decoded frame, level n being 1/2^n of its
+  // size.
+  uint32_t levels = 3;
+  // Buffers per level, which bounds how many frames of a level consumers
+  // may hold on to.
+  size_t pool_capacity = 3;
+};
+
+struct FramePyramidStats {
+  uint64_t frames_received = 0;
+  // Downscaled frames computed across all levels.
+  uint64_t levels_computed = 0;
+  // Levels skipped because consumers held all of the level's buffers.
+  uint64_t levels_dropped = 0;
+};
+
+// Turns every decoded frame into a mip pyramid by averaging 2x2 blocks and
+// presents each level to its own consumers, so a stream shown at several
+// sizes gets decoded and scaled once. Only levels that have consumers are
+// computed, each from the one above it. Downscaled levels are produced for
+// RGBA and BGRA frames only, other formats just reach level 0.
+//
+// Consumers run on the vout thread; wrap slow ones in a FrameFanOutDelegate.
+class FramePyramidDelegate : public PooledPixelBufferOutputDelegate {
+ public:
+  typedef uint64_t ConsumerId;
+
+  explicit FramePyramidDelegate(const FramePyramidOptions& options = {});
+
+  // Level 0 receives the decoded frames as is. Returns 0 if |level| exceeds
+  // the configured number of levels. May be called from any thread.
+  ConsumerId AddConsumer(uint32_t level,
+                         std::unique_ptr<PixelBufferOutputDelegate> consumer);
+  // Waits for the consumer to finish presenting. Returns false if there's
+  // no such consumer.
+  bool RemoveConsumer(ConsumerId id);
+
+  FramePyramidStats stats() const;
+
+  std::optional<FrameBufferPoolOptions> frame_buffer_pool_options()
+      const override;
+  void PresentFrame(std::shared_ptr<FrameBuffer> frame) override;
+
+ private:
+  struct Consumer {
+    ConsumerId id;
+    uint32_t level;
+    std::unique_ptr<PixelBufferOutputDelegate> delegate;
+    // The format last announced to the consumer.
+    std::optional<FrameDescriptor> format;
+  };
+
+  FramePyramidOptions options_;
+  std::mutex consumers_mutex_;
+  std::vector<std::unique_ptr<Consumer>> consumers_;
+  ConsumerId next_consumer_id_ = 1;
+
+  // Only accessed by the vout thread. Index n holds the pool and the
+  // current frame of level n + 1.
+  std::vector<std::unique_ptr<FrameBufferPool>> pools_;
+  std::vector<std::shared_ptr<FrameBuffer>> level_frames_;
+
+  std::atomic<uint64_t> frames_received_ = 0;
+  std::atomic<uint64_t> levels_computed_ = 0;
+  std::atomic<uint64_t> levels_dropped_ = 0;
+
+  void ComputeLevels(const FrameBuffer& frame, uint32_t deepest_level);
+  static void PresentToConsumer(Consumer* consumer,
+                                std::shared_ptr<FrameBuffer> frame);
+};
+
+}  // namespace foxglove
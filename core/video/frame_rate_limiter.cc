@@ -0,0 +1,40 @@
+#include "video/frame_rate_limiter.h"
+
+#include <algorithm>
+
+namespace foxglove {
+
+void FrameRateLimiter::SetMaxFrameRate(double max_fps) {
+  max_frame_rate_ = std::max(max_fps, 0.0);
+}
+
+bool FrameRateLimiter::ShouldPresent(int64_t pts_us) {
+  const auto max_fps = max_frame_rate_.load(std::memory_order_relaxed);
+  if (max_fps <= 0 || pts_us < 0) {
+    next_pts_us_.reset();
+    return true;
+  }
+
+  const auto interval = static_cast<int64_t>(1000000 / max_fps);
+  // Start over after seeking backwards or far ahead.
+  if (pts_us < last_pts_us_ || pts_us - last_pts_us_ > 10 * interval) {
+    next_pts_us_.reset();
+  }
+  last_pts_us_ = pts_us;
+
+  // Timestamps jitter a little, which mustn't drop frames of a source that
+  // already runs at about the maximum rate.
+  if (next_pts_us_ && pts_us + interval / 8 < *next_pts_us_) {
+    return false;
+  }
+
+  // Stays on the grid unless frames came in too late to keep up with it.
+  if (next_pts_us_ && pts_us - *next_pts_us_ < interval) {
+    *next_pts_us_ += interval;
+  } else {
+    next_pts_us_ = pts_us + interval;
+  }
+  return true;
+}
+
+}  // namespace foxglove
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+namespace foxglove {
+
+// Thins out frames to a maximum rate. Works on presentation timestamps, so
+// pacing follows media time regardless of playback rate or stalls.
+class FrameRateLimiter final {
+ public:
+  // 0 removes the limit. May be called from any thread.
+  void SetMaxFrameRate(double max_fps);
+  double max_frame_rate() const { return max_frame_rate_; }
+  bool is_enabled() const { return max_frame_rate_ > 0; }
+
+  // Must be called from a single thread for every frame. Frames without a
+  // timestamp always pass.
+  bool ShouldPresent(int64_t pts_us);
+
+ private:
+  std::atomic<double> max_frame_rate_ = 0;
+  std::optional<int64_t> next_pts_us_;
+  int64_t last_pts_us_ = 0;
+};
+
+}  // namespace foxglove
@@ -0,0 +1,265 @@
+#include "video/frame_recorder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "base/logging.h"
+
+namespace foxglove {
+
+namespace {
+
+constexpr size_t kIndexChunkSize = 64 * 1024;
+constexpr char kY4mFrameHeader[] = "FRAME\n";
+
+// NV12 is stored as I420 since Y4M has no interleaved chroma.
+PixelFormat StoredFormat(PixelFormat format) {
+  return format == PixelFormat::kFormatNV12 ? PixelFormat::kFormatI420
+                                            : format;
+}
+
+}  // namespace
+
+FrameRecorderOutputDelegate::FrameRecorderOutputDelegate(
+    const FrameRecorderOptions& options)
+    : options_(options) {
+  options_.max_queued_frames = std::max<size_t>(options_.max_queued_frames, 1);
+  writer_thread_ = std::thread(&FrameRecorderOutputDelegate::Run, this);
+}
+
+FrameRecorderOutputDelegate::~FrameRecorderOutputDelegate() {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  queue_cv_.notify_one();
+  writer_thread_.join();
+}
+
+std::optional<FrameBufferPoolOptions>
+FrameRecorderOutputDelegate::frame_buffer_pool_options() const {
+  FrameBufferPoolOptions pool_options;
+  // One more for the frame being decoded and one for the frame being
+  // written.
+  pool_options.capacity = options_.max_queued_frames + 2;
+  return pool_options;
+}
+
+void FrameRecorderOutputDelegate::PresentFrame(
+    std::shared_ptr<FrameBuffer> frame) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (failed_ || queue_.size() >= options_.max_queued_frames) {
+      frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    queue_.push_back(std::move(frame));
+  }
+  queue_cv_.notify_one();
+}
+
+FrameRecorderStats FrameRecorderOutputDelegate::stats() const {
+  FrameRecorderStats stats;
+  stats.frames_written = frames_written_.load(std::memory_order_relaxed);
+  stats.frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+  stats.bytes_written = bytes_written_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+std::optional<ErrorDetails> FrameRecorderOutputDelegate::error() const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return error_;
+}
+
+void FrameRecorderOutputDelegate::Run() {
+  while (true) {
+    std::shared_ptr<FrameBuffer> frame;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queue_cv_.wait(lock, [this] { return stopped_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        break;
+      }
+      frame = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    if (!failed_) {
+      auto status = WriteFrame(*frame);
+      if (!status.ok()) {
+        SetError(status.error());
+      }
+    }
+  }
+
+  auto index_status = index_file_.Close();
+  auto data_status = data_file_.Close();
+  if (!data_status.ok()) {
+    SetError(data_status.error());
+  } else if (!index_status.ok()) {
+    SetError(index_status.error());
+  }
+}
+
+void FrameRecorderOutputDelegate::SetError(const ErrorDetails& error) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  if (error_) {
+    return;
+  }
+  LOG(ERROR) << "Recording to " << options_.path
+             << " failed: " << error.ToString() << std::endl;
+  error_.emplace(error);
+  failed_ = true;
+}
+
+Status<ErrorDetails> FrameRecorderOutputDelegate::WriteFrame(
+    const FrameBuffer& frame) {
+  if (!format_) {
+    auto status = StartRecording(frame);
+    if (!status.ok()) {
+      return status;
+    }
+  } else if (!MatchesFormat(frame)) {
+    frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+    return OkStatus();
+  }
+
+  if (is_y4m_) {
+    auto status =
+        data_file_.Write(kY4mFrameHeader, sizeof(kY4mFrameHeader) - 1);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  FrameIndexEntry entry;
+  entry.frame_number = frames_written_.load(std::memory_order_relaxed);
+  entry.sequence = frame.timing().sequence;
+  entry.pts_us = frame.timing().pts_us;
+  entry.offset = data_file_.position();
+
+  auto planes_status = WritePlanes(frame);
+  if (!planes_status.ok()) {
+    return planes_status;
+  }
+  entry.size = data_file_.position() - entry.offset;
+
+  auto index_status = index_file_.Write(&entry, sizeof(entry));
+  if (!index_status.ok()) {
+    return index_status;
+  }
+
+  frames_written_.fetch_add(1, std::memory_order_relaxed);
+  bytes_written_.store(data_file_.position(), std::memory_order_relaxed);
+  return OkStatus();
+}
+
+Status<ErrorDetails> FrameRecorderOutputDelegate::StartRecording(
+    const FrameBuffer& frame) {
+  const auto format = StoredFormat(frame.pixel_format());
+  const auto& dimensions = frame.dimensions();
+  const auto layout =
+      ComputeFrameLayout(format, dimensions.width, dimensions.height);
+
+  auto data_status = data_file_.Open(options_.path, options_.use_direct_io);
+  if (!data_status.ok()) {
+    return data_status;
+  }
+  auto index_status =
+      index_file_.Open(options_.path + ".idx", false, kIndexChunkSize);
+  if (!index_status.ok()) {
+    return index_status;
+  }
+
+  is_y4m_ = IsPlanarFormat(format);
+  if (is_y4m_) {
+    char header[128];
+    const auto length = snprintf(
+        header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:%u Ip A0:0 C420jpeg\n",
+        dimensions.width, dimensions.height, options_.frame_rate_numerator,
+        options_.frame_rate_denominator);
+    auto header_status =
+        data_file_.Write(header, static_cast<size_t>(length));
+    if (!header_status.ok()) {
+      return header_status;
+    }
+  }
+
+  FrameIndexHeader index_header = {};
+  memcpy(index_header.magic, FrameIndexHeader::kMagic,
+         sizeof(index_header.magic));
+  index_header.pixel_format = static_cast<uint32_t>(format);
+  index_header.width = dimensions.width;
+  index_header.height = dimensions.height;
+  index_header.plane_count = layout.plane_count;
+  for (size_t i = 0; i < kMaxPlanes; i++) {
+    index_header.pitches[i] = layout.pitches[i];
+    index_header.lines[i] = layout.lines[i];
+  }
+  format_ = index_header;
+  row_buffer_ = std::make_unique<uint8_t[]>(layout.pitches[0]);
+
+  return index_file_.Write(&index_header, sizeof(index_header));
+}
+
+bool FrameRecorderOutputDelegate::MatchesFormat(
+    const FrameBuffer& frame) const {
+  return StoredFormat(frame.pixel_format()) ==
+             static_cast<PixelFormat>(format_->pixel_format) &&
+         frame.dimensions().width == format_->width &&
+         frame.dimensions().height == format_->height;
+}
+
+Status<ErrorDetails> FrameRecorderOutputDelegate::WritePlanes(
+    const FrameBuffer& frame) {
+  // Copies whole planes unless rows are padded or chroma has to be
+  // deinterleaved.
+  auto write_plane = [this](const uint8_t* src, uint32_t src_pitch,
+                            uint32_t row_size,
+                            uint32_t rows) -> Status<ErrorDetails> {
+    if (src_pitch == row_size) {
+      return data_file_.Write(src, static_cast<size_t>(row_size) * rows);
+    }
+    for (uint32_t y = 0; y < rows; y++) {
+      auto status = data_file_.Write(src + y * src_pitch, row_size);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return OkStatus();
+  };
+
+  if (frame.pixel_format() != PixelFormat::kFormatNV12) {
+    for (uint32_t i = 0; i < format_->plane_count; i++) {
+      auto status = write_plane(frame.plane(i), frame.pitch(i),
+                                format_->pitches[i], format_->lines[i]);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return OkStatus();
+  }
+
+  auto luma_status = write_plane(frame.plane(0), frame.pitch(0),
+                                 format_->pitches[0], format_->lines[0]);
+  if (!luma_status.ok()) {
+    return luma_status;
+  }
+  const auto chroma_width = format_->pitches[1];
+  for (uint32_t component = 0; component < 2; component++) {
+    for (uint32_t y = 0; y < format_->lines[1]; y++) {
+      const auto src = frame.plane(1) + y * frame.pitch(1) + component;
+      for (uint32_t x = 0; x < chroma_width; x++) {
+        row_buffer_[x] = src[x * 2];
+      }
+      auto status = data_file_.Write(row_buffer_.get(), chroma_width);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace foxglove
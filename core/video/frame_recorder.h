@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "base/error_details.h"
+#include "base/sequential_file_writer.h"
+#include "video/pixel_buffer_output.h"
+
+namespace foxglove {
+
+struct FrameRecorderOptions {
+  // I420 and NV12 frames are written as Y4M (NV12 gets converted to I420),
+  // RGBA and BGRA frames as plain concatenated pictures. The index goes to
+  // |path| + ".idx".
+  std::string path;
+  // Frames that arrive while the queue is full get dropped.
+  size_t max_queued_frames = 8;
+  // Bypasses the page cache where supported.
+  bool use_direct_io = false;
+  // Only written to the Y4M header.
+  uint32_t frame_rate_numerator = 30;
+  uint32_t frame_rate_denominator = 1;
+};
+
+// The sidecar index starts with a FrameIndexHeader followed by one
+// FrameIndexEntry per recorded frame. All values are little endian.
+struct FrameIndexHeader {
+  static constexpr char kMagic[8] = {'F', 'G', 'F', 'R', 'I', 'D', 'X', '1'};
+
+  char magic[8];
+  uint32_t pixel_format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t plane_count;
+  // Layout of the planes as stored in the recording.
+  uint32_t pitches[kMaxPlanes];
+  uint32_t lines[kMaxPlanes];
+};
+
+struct FrameIndexEntry {
+  uint64_t frame_number;
+  // FrameTiming::sequence of the frame.
+  uint64_t sequence;
+  int64_t pts_us;
+  // Position of the first pixel of the frame in the recording.
+  uint64_t offset;
+  uint64_t size;
+};
+
+struct FrameRecorderStats {
+  uint64_t frames_written = 0;
+  // Frames dropped because the queue was full or their format differed
+  // from the first recorded frame.
+  uint64_t frames_dropped = 0;
+  uint64_t bytes_written = 0;
+};
+
+// Records every presented frame to disk on a background thread, so the vout
+// thread never waits for I/O. Recording stops at the first write error.
+class FrameRecorderOutputDelegate : public PooledPixelBufferOutputDelegate {
+ public:
+  explicit FrameRecorderOutputDelegate(const FrameRecorderOptions& options);
+  // Writes out all queued frames.
+  ~FrameRecorderOutputDelegate() override;
+
+  std::optional<FrameBufferPoolOptions> frame_buffer_pool_options()
+      const override;
+  void PresentFrame(std::shared_ptr<FrameBuffer> frame) override;
+
+  FrameRecorderStats stats() const;
+  std::optional<ErrorDetails> error() const;
+
+ private:
+  FrameRecorderOptions options_;
+  std::thread writer_thread_;
+  mutable std::mutex mutex_;
+  std::condition_variable queue_cv_;
+  std::deque<std::shared_ptr<FrameBuffer>> queue_;
+  bool stopped_ = false;
+  std::optional<ErrorDetails> error_;
+
+  std::atomic<uint64_t> frames_written_ = 0;
+  std::atomic<uint64_t> frames_dropped_ = 0;
+  std::atomic<uint64_t> bytes_written_ = 0;
+  std::atomic<bool> failed_ = false;
+
+  // Only accessed by the writer thread.
+  SequentialFileWriter data_file_;
+  SequentialFileWriter index_file_;
+  std::optional<FrameIndexHeader> format_;
+  bool is_y4m_ = false;
+  std::unique_ptr<uint8_t[]> row_buffer_;
+
+  void Run();
+  void SetError(const ErrorDetails& error);
+  Status<ErrorDetails> WriteFrame(const FrameBuffer& frame);
+  Status<ErrorDetails> StartRecording(const FrameBuffer& frame);
+  Status<ErrorDetails> WritePlanes(const FrameBuffer& frame);
+  bool MatchesFormat(const FrameBuffer& frame) const;
+};
+
+}  // namespace foxglove
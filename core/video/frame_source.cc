@@ -0,0 +1,54 @@
+#include "video/frame_source.h"
+
+#include <utility>
+
+namespace foxglove {
+
+void FrameSource::Publish(std::shared_ptr<const FrameBuffer> frame) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    // The replaced frame returns to its pool once consumers release it.
+    latest_.swap(frame);
+  }
+  frames_published_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::shared_ptr<const FrameBuffer> FrameSource::AcquireLatest(
+    uint64_t after_sequence) {
+  std::shared_ptr<const FrameBuffer> frame;
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (!latest_ || latest_->timing().sequence <= after_sequence) {
+      return nullptr;
+    }
+    frame = latest_;
+  }
+  frames_acquired_.fetch_add(1, std::memory_order_relaxed);
+  return frame;
+}
+
+FrameSourceStats FrameSource::stats() const {
+  FrameSourceStats stats;
+  stats.frames_published = frames_published_;
+  stats.frames_acquired = frames_acquired_;
+  return stats;
+}
+
+FrameSourceDelegate::FrameSourceDelegate(
+    std::shared_ptr<FrameSource> source,
+    const FrameSourceDelegateOptions& options)
+    : source_(std::move(source)), options_(options) {}
+
+std::optional<FrameBufferPoolOptions>
+FrameSourceDelegate::frame_buffer_pool_options() const {
+  // Plus one for the newest frame and one being decoded.
+  FrameBufferPoolOptions pool_options;
+  pool_options.capacity = options_.max_held_frames + 2;
+  return pool_options;
+}
+
+void FrameSourceDelegate::PresentFrame(std::shared_ptr<FrameBuffer> frame) {
+  source_->Publish(std::move(frame));
+}
+
+}  // namespace foxglove
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "video/frame_c_api.h"
+#include "video/pixel_buffer_output.h"
+
+namespace foxglove {
+
+struct FrameSourceStats {
+  uint64_t frames_published = 0;
+  uint64_t frames_acquired = 0;
+};
+
+// Holds the newest frame of a pixel buffer output for consumers on other
+// threads or behind the C API. Frames are handed out by reference, not
+// copied, and stay valid for as long as they're referenced.
+class FrameSource final {
+ public:
+  FrameSource() = default;
+
+  FrameSource(const FrameSource&) = delete;
+  FrameSource& operator=(const FrameSource&) = delete;
+
+  void Publish(std::shared_ptr<const FrameBuffer> frame);
+  // Returns nullptr if there's no frame with a sequence greater than
+  // |after_sequence|. May be called from any thread.
+  std::shared_ptr<const FrameBuffer> AcquireLatest(uint64_t after_sequence = 0);
+
+  FrameSourceStats stats() const;
+
+  // For foxglove_frame_acquire(). The source must outlive all calls.
+  foxglove_frame_source* c_handle() {
+    return reinterpret_cast<foxglove_frame_source*>(this);
+  }
+  static FrameSource* FromCHandle(foxglove_frame_source* handle) {
+    return reinterpret_cast<FrameSource*>(handle);
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::shared_ptr<const FrameBuffer> latest_;
+
+  std::atomic<uint64_t> frames_published_ = 0;
+  std::atomic<uint64_t> frames_acquired_ = 0;
+};
+
+struct FrameSourceDelegateOptions {
+  // Frames consumers may hold on to at once besides the newest one. Frames
+  // decoded while all buffers are held get dropped.
+  size_t max_held_frames = 2;
+};
+
+// Publishes the frames of a pixel buffer output to a FrameSource.
+class FrameSourceDelegate : public PooledPixelBufferOutputDelegate {
+ public:
+  explicit FrameSourceDelegate(std::shared_ptr<FrameSource> source,
+                               const FrameSourceDelegateOptions& options = {});
+
+  std::optional<FrameBufferPoolOptions> frame_buffer_pool_options()
+      const override;
+  void PresentFrame(std::shared_ptr<FrameBuffer> frame) override;
+
+ private:
+  std::shared_ptr<FrameSource> source_;
+  FrameSourceDelegateOptions options_;
+};
+
+}  // namespace foxglove
@@ -0,0 +1,123 @@
+#include "video/luma_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/cpu_features.h"
+#include "video/convert/convert.h"
+
+namespace foxglove {
+
+namespace {
+
+// RGB rows get converted in chunks of this many pixels.
+constexpr uint32_t kGrayChunk = 256;
+
+struct Accumulator {
+  // Interleaving four histograms avoids stalls on runs of equal pixels.
+  uint32_t bins[4][LumaStatistics::kBinCount] = {};
+  uint64_t sum = 0;
+  uint64_t sum_squares = 0;
+  uint64_t count = 0;
+};
+
+void AccumulateRow(const uint8_t* row, uint32_t width, Accumulator* acc) {
+  uint32_t x = 0;
+#ifdef FOXGLOVE_HAS_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sum = _mm_setzero_si128();
+  // 32-bit lanes hold at most width / 4 squares, enough for 64k wide rows.
+  __m128i sum_squares = _mm_setzero_si128();
+  for (; x + 16 <= width; x += 16) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+    sum = _mm_add_epi64(sum, _mm_sad_epu8(v, zero));
+    const __m128i lo = _mm_unpacklo_epi8(v, zero);
+    const __m128i hi = _mm_unpackhi_epi8(v, zero);
+    sum_squares = _mm_add_epi32(sum_squares, _mm_madd_epi16(lo, lo));
+    sum_squares = _mm_add_epi32(sum_squares, _mm_madd_epi16(hi, hi));
+  }
+  alignas(16) uint64_t sums[2];
+  alignas(16) uint32_t squares[4];
+  _mm_store_si128(reinterpret_cast<__m128i*>(sums), sum);
+  _mm_store_si128(reinterpret_cast<__m128i*>(squares), sum_squares);
+  acc->sum += sums[0] + sums[1];
+  acc->sum_squares += static_cast<uint64_t>(squares[0]) + squares[1] +
+                      squares[2] + squares[3];
+  for (uint32_t i = 0; i < x; i += 4) {
+    for (uint32_t j = 0; j < 4; j++) {
+      acc->bins[j][row[i + j] >> 2]++;
+    }
+  }
+#endif
+  for (; x < width; x++) {
+    const uint32_t value = row[x];
+    acc->sum += value;
+    acc->sum_squares += value * value;
+    acc->bins[x & 3][value >> 2]++;
+  }
+  acc->count += width;
+}
+
+}  // namespace
+
+bool ComputeLumaStatistics(const FrameDescriptor& frame,
+                           const uint8_t* const* planes, uint32_t row_step,
+                           LumaStatistics* statistics) {
+  const auto format = frame.pixel_format;
+  const bool is_rgb = format == PixelFormat::kFormatRGBA ||
+                      format == PixelFormat::kFormatBGRA;
+  if (!is_rgb && !IsPlanarFormat(format)) {
+    return false;
+  }
+
+  const auto width = frame.dimensions.width;
+  const auto height = frame.dimensions.height;
+  const auto pitch = frame.layout.pitches[0];
+  row_step = std::max<uint32_t>(row_step, 1);
+  Accumulator acc;
+  uint8_t gray[kGrayChunk];
+  for (uint32_t y = 0; y < height; y += row_step) {
+    const auto* row = planes[0] + static_cast<size_t>(y) * pitch;
+    if (!is_rgb) {
+      AccumulateRow(row, width, &acc);
+      continue;
+    }
+    for (uint32_t x = 0; x < width; x += kGrayChunk) {
+      const auto chunk = std::min(kGrayChunk, width - x);
+      convert::RgbaToGray(row + static_cast<size_t>(x) * 4, chunk * 4, gray,
+                          chunk, chunk, 1,
+                          format == PixelFormat::kFormatBGRA);
+      AccumulateRow(gray, chunk, &acc);
+    }
+  }
+
+  *statistics = LumaStatistics();
+  for (size_t i = 0; i < LumaStatistics::kBinCount; i++) {
+    statistics->histogram[i] =
+        acc.bins[0][i] + acc.bins[1][i] + acc.bins[2][i] + acc.bins[3][i];
+  }
+  statistics->pixel_count = acc.count;
+  if (acc.count > 0) {
+    const auto count = static_cast<double>(acc.count);
+    statistics->mean = acc.sum / count;
+    statistics->variance = std::max(
+        0.0, acc.sum_squares / count - statistics->mean * statistics->mean);
+  }
+  return true;
+}
+
+double HistogramDistance(const LumaStatistics& a, const LumaStatistics& b) {
+  if (a.pixel_count == 0 || b.pixel_count == 0) {
+    return a.pixel_count == b.pixel_count ? 0 : 2;
+  }
+  const auto scale_a = 1.0 / a.pixel_count;
+  const auto scale_b = 1.0 / b.pixel_count;
+  double distance = 0;
+  for (size_t i = 0; i < LumaStatistics::kBinCount; i++) {
+    distance += std::abs(a.histogram[i] * scale_a - b.histogram[i] * scale_b);
+  }
+  return distance;
+}
+
+}  // namespace foxglove
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "video/frame_descriptor.h"
+
+namespace foxglove {
+
+struct LumaStatistics {
+  static constexpr size_t kBinCount = 64;
+
+  // Pixel counts for every 4 consecutive luma levels.
+  std::array<uint32_t, kBinCount> histogram{};
+  uint64_t pixel_count = 0;
+  double mean = 0;
+  double variance = 0;
+};
+
+// Computes the luma histogram, mean and variance of every |row_step|th row
+// of an RGBA, BGRA, I420 or NV12 picture. RGB pixels are weighted as full
+// range BT.601, YUV pictures use their Y plane as is. Returns false for
+// other formats.
+bool ComputeLumaStatistics(const FrameDescriptor& frame,
+                           const uint8_t* const* planes, uint32_t row_step,
+                           LumaStatistics* statistics);
+
+// Returns the L1 distance of the normalized histograms of |a| and |b|,
+// from 0 for identical to 2 for disjoint distributions.
+double HistogramDistance(const LumaStatistics& a, const LumaStatistics& b);
+
+}  // namespace foxglove
@@ -0,0 +1,341 @@
+#include "video/mosaic_compositor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#include "video/convert/convert.h"
+
+namespace foxglove {
+
+namespace {
+
+// Beyond this many distinct changed areas, pooled canvases that fell
+// behind get copied in full.
+constexpr size_t kMaxDamageRects = 256;
+
+// Minimum delay before presenting a dropped canvas again, so an unlimited
+// frame rate doesn't spin while the delegate holds all buffers.
+constexpr auto kDroppedCanvasRetryDelay = std::chrono::milliseconds(5);
+
+bool IsRgb(PixelFormat format) {
+  return format == PixelFormat::kFormatRGBA ||
+         format == PixelFormat::kFormatBGRA;
+}
+
+}  // namespace
+
+struct MosaicCompositor::Tile {
+  TileId id;
+  VideoRect rect;
+  // Guarded by the compositor's mutex.
+  std::shared_ptr<FrameBuffer> pending_frame;
+  // Only accessed by the compositor thread.
+  std::unique_ptr<convert::RgbaScaler> scaler;
+};
+
+MosaicCompositor::MosaicCompositor(
+    const MosaicCompositorOptions& options,
+    std::unique_ptr<PixelBufferOutputDelegate> output_delegate)
+    : options_(options), output_delegate_(std::move(output_delegate)) {
+  if (!IsRgb(options_.pixel_format)) {
+    options_.pixel_format = PixelFormat::kFormatRGBA;
+  }
+  layout_ = ComputeFrameLayout(options_.pixel_format, options_.width,
+                               options_.height);
+  dimensions_ =
+      VideoDimensions(options_.width, options_.height, layout_.pitches[0]);
+  canvas_ = std::make_unique<FrameBuffer>(options_.pixel_format, dimensions_,
+                                          layout_);
+  FillRect({0, 0, options_.width, options_.height});
+
+  if (auto pool_options = output_delegate_->frame_buffer_pool_options()) {
+    output_pool_.emplace(*pool_options);
+  }
+  thread_ = std::thread(&MosaicCompositor::Run, this);
+}
+
+MosaicCompositor::~MosaicCompositor() {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  cv_.notify_one();
+  thread_.join();
+}
+
+MosaicCompositor::TileId MosaicCompositor::AddTile(const VideoRect& rect) {
+  auto tile = std::make_shared<Tile>();
+  tile->rect = rect.ClippedTo(options_.width, options_.height);
+
+  const std::lock_guard<std::mutex> lock(mutex_);
+  tile->id = next_tile_id_++;
+  tiles_.push_back(std::move(tile));
+  return tiles_.back()->id;
+}
+
+bool MosaicCompositor::RemoveTile(TileId id) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(tiles_.begin(), tiles_.end(),
+                           [id](const auto& tile) { return tile->id == id; });
+    if (it == tiles_.end()) {
+      return false;
+    }
+    cleared_rects_.push_back((*it)->rect);
+    tiles_.erase(it);
+    has_work_ = true;
+  }
+  cv_.notify_one();
+  return true;
+}
+
+void MosaicCompositor::SubmitFrame(TileId id,
+                                   std::shared_ptr<FrameBuffer> frame) {
+  if (!frame || !IsRgb(frame->pixel_format())) {
+    return;
+  }
+
+  std::shared_ptr<FrameBuffer> replaced;
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(tiles_.begin(), tiles_.end(),
+                           [id](const auto& tile) { return tile->id == id; });
+    if (it == tiles_.end()) {
+      return;
+    }
+    replaced = std::exchange((*it)->pending_frame, std::move(frame));
+    has_work_ = true;
+  }
+  if (replaced) {
+    tile_frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+  cv_.notify_one();
+}
+
+MosaicCompositorStats MosaicCompositor::stats() const {
+  MosaicCompositorStats stats;
+  stats.canvases_presented = canvases_presented_;
+  stats.canvases_dropped = canvases_dropped_;
+  stats.tiles_updated = tiles_updated_;
+  stats.tile_frames_dropped = tile_frames_dropped_;
+  return stats;
+}
+
+void MosaicCompositor::Run() {
+  using Clock = std::chrono::steady_clock;
+  const auto interval =
+      options_.max_frame_rate > 0
+          ? std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(1.0 / options_.max_frame_rate))
+          : Clock::duration::zero();
+  auto next_present = Clock::now();
+
+  std::vector<std::pair<std::shared_ptr<Tile>, std::shared_ptr<FrameBuffer>>>
+      updates;
+  std::vector<VideoRect> cleared;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stopped_ || has_work_; });
+      // Let frames of other tiles accumulate until the canvas is due.
+      cv_.wait_until(lock, next_present, [this] { return stopped_; });
+      if (stopped_) {
+        return;
+      }
+      has_work_ = false;
+      cleared.swap(cleared_rects_);
+      for (const auto& tile : tiles_) {
+        if (tile->pending_frame) {
+          updates.emplace_back(tile, std::move(tile->pending_frame));
+        }
+      }
+    }
+
+    const auto composited_at_us = MonotonicTimeUs();
+    for (const auto& rect : cleared) {
+      FillRect(rect);
+      AddDamage(rect);
+    }
+    for (auto& [tile, frame] : updates) {
+      DrawTile(tile.get(), *frame);
+      AddDamage(tile->rect);
+    }
+    tiles_updated_.fetch_add(updates.size(), std::memory_order_relaxed);
+    // Return the frames to the players' pools before presenting.
+    updates.clear();
+    cleared.clear();
+
+    const auto is_presented = Present(composited_at_us);
+    next_present = std::max(next_present + interval, Clock::now());
+    if (!is_presented) {
+      // Otherwise the canvas would only be presented with the next tile
+      // frame, which never comes for paused players.
+      next_present =
+          std::max(next_present, Clock::now() + kDroppedCanvasRetryDelay);
+      const std::lock_guard<std::mutex> lock(mutex_);
+      has_work_ = true;
+    }
+  }
+}
+
+void MosaicCompositor::DrawTile(Tile* tile, const FrameBuffer& frame) {
+  const auto& rect = tile->rect;
+  const auto& src = frame.dimensions();
+  if (rect.is_empty() || src.width == 0 || src.height == 0) {
+    return;
+  }
+
+  const auto dst_pitch = layout_.pitches[0];
+  auto* dst = canvas_->plane(0) + static_cast<size_t>(rect.y) * dst_pitch +
+              static_cast<size_t>(rect.x) * 4;
+  const bool needs_swizzle = frame.pixel_format() != options_.pixel_format;
+
+  if (src.width == rect.width && src.height == rect.height) {
+    tile->scaler.reset();
+    if (needs_swizzle) {
+      convert::SwizzleRgbaBgra(frame.plane(0), frame.pitch(0), dst, dst_pitch,
+                               rect.width, rect.height);
+    } else {
+      for (uint32_t y = 0; y < rect.height; y++) {
+        memcpy(dst + static_cast<size_t>(y) * dst_pitch,
+               frame.plane(0) + static_cast<size_t>(y) * frame.pitch(0),
+               static_cast<size_t>(rect.width) * 4);
+      }
+    }
+    return;
+  }
+
+  if (!tile->scaler ||
+      !tile->scaler->Matches(src.width, src.height, rect.width,
+                             rect.height)) {
+    tile->scaler = std::make_unique<convert::RgbaScaler>(
+        src.width, src.height, rect.width, rect.height);
+  }
+  tile->scaler->Scale(frame.plane(0), frame.pitch(0), dst, dst_pitch);
+  if (needs_swizzle) {
+    convert::SwizzleRgbaBgra(dst, dst_pitch, dst, dst_pitch, rect.width,
+                             rect.height);
+  }
+}
+
+void MosaicCompositor::FillRect(const VideoRect& rect) {
+  if (rect.is_empty()) {
+    return;
+  }
+  const auto pitch = layout_.pitches[0];
+  auto* first_row = canvas_->plane(0) + static_cast<size_t>(rect.y) * pitch +
+                    static_cast<size_t>(rect.x) * 4;
+  for (uint32_t x = 0; x < rect.width; x++) {
+    memcpy(first_row + x * 4, options_.background.data(), 4);
+  }
+  for (uint32_t y = 1; y < rect.height; y++) {
+    memcpy(first_row + static_cast<size_t>(y) * pitch, first_row,
+           static_cast<size_t>(rect.width) * 4);
+  }
+}
+
+void MosaicCompositor::AddDamage(const VideoRect& rect) {
+  version_++;
+  // A newer change to the same area supersedes the older one.
+  damage_.erase(std::remove_if(damage_.begin(), damage_.end(),
+                               [&rect](const auto& damage) {
+                                 return damage.rect == rect;
+                               }),
+                damage_.end());
+  damage_.push_back({version_, rect});
+  if (damage_.size() > kMaxDamageRects) {
+    damage_floor_ = damage_.front().version;
+    damage_.pop_front();
+  }
+}
+
+void MosaicCompositor::CopyRect(const VideoRect& rect,
+                                FrameBuffer* dst) const {
+  const auto pitch = layout_.pitches[0];
+  const auto offset = static_cast<size_t>(rect.y) * pitch +
+                      static_cast<size_t>(rect.x) * 4;
+  for (uint32_t y = 0; y < rect.height; y++) {
+    const auto row_offset = offset + static_cast<size_t>(y) * pitch;
+    memcpy(dst->plane(0) + row_offset, canvas_->plane(0) + row_offset,
+           static_cast<size_t>(rect.width) * 4);
+  }
+}
+
+bool MosaicCompositor::Present(int64_t composited_at_us) {
+  if (!is_format_announced_) {
+    output_delegate_->OnFormatChanged(options_.pixel_format, dimensions_,
+                                      layout_);
+    if (output_pool_) {
+      output_pool_->Configure(options_.pixel_format, dimensions_, layout_);
+    }
+    is_format_announced_ = true;
+  }
+
+  FrameTiming timing;
+  timing.sequence = canvases_presented_ + 1;
+  timing.decoded_at_us = composited_at_us;
+
+  if (output_pool_) {
+    auto frame = output_pool_->Acquire();
+    if (!frame) {
+      // The changes stay in the damage list for the next canvas.
+      canvases_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    auto it = synced_versions_.find(frame.get());
+    if (it == synced_versions_.end() || it->second < damage_floor_) {
+      memcpy(frame->plane(0), canvas_->plane(0), layout_.plane_size(0));
+    } else {
+      for (const auto& damage : damage_) {
+        if (damage.version > it->second) {
+          CopyRect(damage.rect, frame.get());
+        }
+      }
+    }
+    synced_versions_[frame.get()] = version_;
+
+    timing.presented_at_us = MonotonicTimeUs();
+    frame->set_timing(timing);
+    output_delegate_->PresentFrame(std::move(frame));
+    canvases_presented_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  void* planes[kMaxPlanes] = {};
+  auto user_data = output_delegate_->LockBuffer(planes, dimensions_);
+  if (!planes[0]) {
+    output_delegate_->UnlockBuffer(user_data);
+    canvases_dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  // The delegate's buffer may hold anything, so it gets the whole canvas.
+  memcpy(planes[0], canvas_->plane(0), layout_.plane_size(0));
+  output_delegate_->UnlockBuffer(user_data);
+  timing.presented_at_us = MonotonicTimeUs();
+  output_delegate_->PresentBuffer(
+      FrameDescriptor{options_.pixel_format, dimensions_, layout_, timing},
+      user_data);
+  canvases_presented_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+MosaicTileDelegate::MosaicTileDelegate(
+    std::shared_ptr<MosaicCompositor> compositor,
+    MosaicCompositor::TileId tile)
+    : compositor_(std::move(compositor)), tile_(tile) {}
+
+std::optional<FrameBufferPoolOptions>
+MosaicTileDelegate::frame_buffer_pool_options() const {
+  // One frame being decoded, one queued and one being drawn.
+  FrameBufferPoolOptions pool_options;
+  pool_options.capacity = 3;
+  return pool_options;
+}
+
+void MosaicTileDelegate::PresentFrame(std::shared_ptr<FrameBuffer> frame) {
+  compositor_->SubmitFrame(tile_, std::move(frame));
+}
+
+}  // namespace foxglove
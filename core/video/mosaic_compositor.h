@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "video/pixel_buffer_output.h"
+
+namespace foxglove {
+
+struct MosaicCompositorOptions {
+  uint32_t width = 1920;
+  uint32_t height = 1080;
+  // kFormatRGBA or kFormatBGRA.
+  PixelFormat pixel_format = PixelFormat::kFormatRGBA;
+  // Fills the area not covered by tiles, in canvas byte order.
+  std::array<uint8_t, 4> background = {0, 0, 0, 0xff};
+  // Caps how often the canvas gets presented, 0 presents as soon as any
+  // tile changed.
+  double max_frame_rate = 60;
+};
+
+struct MosaicCompositorStats {
+  uint64_t canvases_presented = 0;
+  // Canvases not presented because the delegate had no buffer available.
+  uint64_t canvases_dropped = 0;
+  uint64_t tiles_updated = 0;
+  // Tile frames replaced by a newer one before they got composited.
+  uint64_t tile_frames_dropped = 0;
+};
+
+// Composites the frames of many players into a single canvas that gets
+// presented to one delegate, so a video wall costs one texture upload and
+// one notification per canvas instead of one per stream. Every tile is
+// redrawn only when its player presented a new frame, and pooled canvases
+// only receive the areas that changed since they were last presented.
+//
+// Scaling is bilinear, so limit the players' output size to roughly the
+// tile size (VideoOutput::SetMaxOutputSize()) to avoid aliasing and save
+// conversion work.
+class MosaicCompositor final {
+ public:
+  typedef uint64_t TileId;
+
+  MosaicCompositor(const MosaicCompositorOptions& options,
+                   std::unique_ptr<PixelBufferOutputDelegate> output_delegate);
+  ~MosaicCompositor();
+
+  MosaicCompositor(const MosaicCompositor&) = delete;
+  MosaicCompositor& operator=(const MosaicCompositor&) = delete;
+
+  // Tiles get clipped to the canvas and shouldn't overlap. May be called
+  // from any thread.
+  TileId AddTile(const VideoRect& rect);
+  // Fills the tile's area with the background. Returns false if there's no
+  // such tile.
+  bool RemoveTile(TileId id);
+
+  // Queues an RGBA or BGRA frame to be drawn into the tile, replacing any
+  // frame that hasn't been drawn yet. Other formats are ignored.
+  void SubmitFrame(TileId id, std::shared_ptr<FrameBuffer> frame);
+
+  MosaicCompositorStats stats() const;
+
+ private:
+  struct Tile;
+  struct Damage {
+    uint64_t version;
+    VideoRect rect;
+  };
+
+  MosaicCompositorOptions options_;
+  std::unique_ptr<PixelBufferOutputDelegate> output_delegate_;
+  VideoDimensions dimensions_;
+  FrameLayout layout_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::shared_ptr<Tile>> tiles_;
+  // Areas of removed tiles that still have to be cleared.
+  std::vector<VideoRect> cleared_rects_;
+  bool has_work_ = false;
+  bool stopped_ = false;
+  TileId next_tile_id_ = 1;
+
+  std::atomic<uint64_t> canvases_presented_ = 0;
+  std::atomic<uint64_t> canvases_dropped_ = 0;
+  std::atomic<uint64_t> tiles_updated_ = 0;
+  std::atomic<uint64_t> tile_frames_dropped_ = 0;
+
+  // Only accessed by the compositor thread.
+  std::unique_ptr<FrameBuffer> canvas_;
+  std::optional<FrameBufferPool> output_pool_;
+  bool is_format_announced_ = false;
+  // Incremented on every change to the canvas. Changed areas are kept
+  // until a newer change covers the same rect, or the list gets too long.
+  uint64_t version_ = 0;
+  std::deque<Damage> damage_;
+  // Pooled canvases synced before this version need a full copy.
+  uint64_t damage_floor_ = 0;
+  // Version of the canvas each pooled buffer last received.
+  std::unordered_map<const FrameBuffer*, uint64_t> synced_versions_;
+
+  std::thread thread_;
+
+  void Run();
+  void DrawTile(Tile* tile, const FrameBuffer& frame);
+  void FillRect(const VideoRect& rect);
+  void AddDamage(const VideoRect& rect);
+  void CopyRect(const VideoRect& rect, FrameBuffer* dst) const;
+  // Returns false if the delegate had no buffer for the canvas.
+  bool Present(int64_t composited_at_us);
+};
+
+// Feeds the frames of a single player into a tile. Hand it to a pixel
+// buffer output producing RGBA or BGRA.
+class MosaicTileDelegate : public PooledPixelBufferOutputDelegate {
+ public:
+  MosaicTileDelegate(std::shared_ptr<MosaicCompositor> compositor,
+                     MosaicCompositor::TileId tile);
+
+  std::optional<FrameBufferPoolOptions> frame_buffer_pool_options()
+      const override;
+  void PresentFrame(std::shared_ptr<FrameBuffer> frame) override;
+
+ private:
+  std::shared_ptr<MosaicCompositor> compositor_;
+  MosaicCompositor::TileId tile_;
+};
+
+}  // namespace foxglove
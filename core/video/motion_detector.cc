@@ -0,0 +1,183 @@
+#include "video/motion_detector.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "base/cpu_features.h"
+#include "video/convert/convert.h"
+
+namespace foxglove {
+
+namespace {
+
+constexpr uint32_t kBlockSize = 8;
+
+bool IsSupported(PixelFormat format) {
+  return format == PixelFormat::kFormatRGBA ||
+         format == PixelFormat::kFormatBGRA || IsPlanarFormat(format);
+}
+
+// Sums the absolute differences of each of the |blocks| 8x8 blocks in a row
+// of blocks of |a| and |b|.
+void BlockRowSads(const uint8_t* a, const uint8_t* b, uint32_t pitch,
+                  uint32_t blocks, uint32_t* sads) {
+  uint32_t block = 0;
+#ifdef FOXGLOVE_HAS_SSE2
+  // Each 16 byte load covers two blocks, whose sums end up in the two
+  // 64-bit halves.
+  for (; block + 2 <= blocks; block += 2) {
+    __m128i sum = _mm_setzero_si128();
+    for (uint32_t y = 0; y < kBlockSize; y++) {
+      const auto offset = static_cast<size_t>(y) * pitch + block * kBlockSize;
+      const __m128i va =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + offset));
+      const __m128i vb =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + offset));
+      sum = _mm_add_epi64(sum, _mm_sad_epu8(va, vb));
+    }
+    sads[block] = static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+    sads[block + 1] =
+        static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(sum, 8)));
+  }
+#endif
+  for (; block < blocks; block++) {
+    uint32_t sum = 0;
+    for (uint32_t y = 0; y < kBlockSize; y++) {
+      const auto offset = static_cast<size_t>(y) * pitch + block * kBlockSize;
+      for (uint32_t x = 0; x < kBlockSize; x++) {
+        sum += std::abs(a[offset + x] - b[offset + x]);
+      }
+    }
+    sads[block] = sum;
+  }
+}
+
+}  // namespace
+
+MotionDetector::MotionDetector(const MotionDetectorOptions& options,
+                               MotionEventCallback callback)
+    : options_(options), callback_(std::move(callback)) {}
+
+void MotionDetector::Analyze(const FrameDescriptor& frame,
+                             const uint8_t* const* planes) {
+  if (!IsSupported(frame.pixel_format)) {
+    return;
+  }
+  const auto& dimensions = frame.dimensions;
+  const auto analysis_width = std::max(options_.analysis_width, kBlockSize);
+  const auto step =
+      std::max<uint32_t>(1, (dimensions.width + analysis_width - 1) /
+                                analysis_width);
+  const auto width = dimensions.width / step / kBlockSize * kBlockSize;
+  const auto height = dimensions.height / step / kBlockSize * kBlockSize;
+  if (width == 0 || height == 0) {
+    return;
+  }
+  if (frame.pixel_format != pixel_format_ || width != width_ ||
+      height != height_) {
+    pixel_format_ = frame.pixel_format;
+    width_ = width;
+    height_ = height;
+    current_.resize(static_cast<size_t>(width) * height);
+    previous_.resize(current_.size());
+    block_sads_.resize(width / kBlockSize);
+    has_previous_ = false;
+  }
+
+  Downsample(frame, planes, step);
+  if (!has_previous_) {
+    std::swap(current_, previous_);
+    has_previous_ = true;
+    return;
+  }
+
+  const auto blocks_x = width_ / kBlockSize;
+  const auto blocks_y = height_ / kBlockSize;
+  const auto threshold = static_cast<uint32_t>(
+      options_.block_threshold * kBlockSize * kBlockSize);
+  uint32_t changed = 0;
+  uint32_t min_x = blocks_x;
+  uint32_t min_y = blocks_y;
+  uint32_t max_x = 0;
+  uint32_t max_y = 0;
+  for (uint32_t by = 0; by < blocks_y; by++) {
+    const auto offset = static_cast<size_t>(by) * kBlockSize * width_;
+    BlockRowSads(current_.data() + offset, previous_.data() + offset, width_,
+                 blocks_x, block_sads_.data());
+    for (uint32_t bx = 0; bx < blocks_x; bx++) {
+      if (block_sads_[bx] > threshold) {
+        changed++;
+        min_x = std::min(min_x, bx);
+        min_y = std::min(min_y, by);
+        max_x = std::max(max_x, bx);
+        max_y = std::max(max_y, by);
+      }
+    }
+  }
+  std::swap(current_, previous_);
+
+  MotionEvent event;
+  event.level = static_cast<double>(changed) / (blocks_x * blocks_y);
+  event.is_motion = changed > 0 && event.level >= options_.motion_threshold;
+  const auto now = MonotonicTimeUs();
+  const bool is_due =
+      event.is_motion != is_motion_ ||
+      (event.is_motion &&
+       now - last_event_us_ >= options_.min_event_interval_ms * 1000);
+  if (!is_due) {
+    return;
+  }
+
+  if (event.is_motion) {
+    // Blocks map to |step| times as many picture pixels.
+    const auto scale = kBlockSize * step;
+    event.region = VideoRect{min_x * scale, min_y * scale,
+                             (max_x + 1 - min_x) * scale,
+                             (max_y + 1 - min_y) * scale}
+                       .ClippedTo(dimensions.width, dimensions.height);
+  }
+  event.pts_us = frame.timing.pts_us;
+  is_motion_ = event.is_motion;
+  last_event_us_ = now;
+  callback_(event);
+}
+
+void MotionDetector::Downsample(const FrameDescriptor& frame,
+                                const uint8_t* const* planes, uint32_t step) {
+  const auto src_pitch = frame.layout.pitches[0];
+  if (IsPlanarFormat(frame.pixel_format)) {
+    // The Y plane already is luma.
+    for (uint32_t y = 0; y < height_; y++) {
+      const auto* src = planes[0] + static_cast<size_t>(y) * step * src_pitch;
+      auto* dst = current_.data() + static_cast<size_t>(y) * width_;
+      if (step == 1) {
+        memcpy(dst, src, width_);
+        continue;
+      }
+      for (uint32_t x = 0; x < width_; x++) {
+        dst[x] = src[x * step];
+      }
+    }
+    return;
+  }
+
+  const bool bgra = frame.pixel_format == PixelFormat::kFormatBGRA;
+  sample_row_.resize(static_cast<size_t>(width_) * 4);
+  for (uint32_t y = 0; y < height_; y++) {
+    const auto* row = planes[0] + static_cast<size_t>(y) * step * src_pitch;
+    if (step > 1) {
+      for (uint32_t x = 0; x < width_; x++) {
+        memcpy(sample_row_.data() + x * 4,
+               row + static_cast<size_t>(x) * step * 4, 4);
+      }
+      row = sample_row_.data();
+    }
+    convert::RgbaToGray(row, width_ * 4,
+                        current_.data() + static_cast<size_t>(y) * width_,
+                        width_, width_, 1, bgra);
+  }
+}
+
+}  // namespace foxglove
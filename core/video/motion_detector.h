@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "events.h"
+#include "video/frame_analyzer.h"
+
+namespace foxglove {
+
+struct MotionDetectorOptions {
+  // Frames get point-sampled down to at most this width before comparing,
+  // which bounds the cost for large videos. Noise is averaged out by the
+  // per-block differences, not by the sampling.
+  uint32_t analysis_width = 160;
+  // Mean absolute luma difference (0-255) above which an 8x8 block of the
+  // downsampled frame counts as changed.
+  double block_threshold = 12;
+  // Share of changed blocks above which the picture counts as in motion.
+  double motion_threshold = 0.005;
+  // Minimum time between two events while motion lasts. Starts and ends of
+  // motion are always reported.
+  int64_t min_event_interval_ms = 500;
+};
+
+typedef std::function<void(const MotionEvent& event)> MotionEventCallback;
+
+// Detects motion by comparing the luma of consecutive downsampled frames in
+// 8x8 blocks. Works on RGBA, BGRA, I420 and NV12 pictures.
+class MotionDetector : public FrameAnalyzer {
+ public:
+  // |callback| runs on the vout thread.
+  MotionDetector(const MotionDetectorOptions& options,
+                 MotionEventCallback callback);
+
+  void Analyze(const FrameDescriptor& frame,
+               const uint8_t* const* planes) override;
+
+ private:
+  MotionDetectorOptions options_;
+  MotionEventCallback callback_;
+  PixelFormat pixel_format_ = PixelFormat::kNone;
+  // Size of the downsampled frames, multiples of the block size.
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  std::vector<uint8_t> current_;
+  std::vector<uint8_t> previous_;
+  bool has_previous_ = false;
+  std::vector<uint32_t> block_sads_;
+  // Scratch row for gathering sampled RGB pixels.
+  std::vector<uint8_t> sample_row_;
+  bool is_motion_ = false;
+  int64_t last_event_us_ = 0;
+
+  void Downsample(const FrameDescriptor& frame, const uint8_t* const* planes,
+                  uint32_t step);
+};
+
+}  // namespace foxglove
@@ -0,0 +1,32 @@
+#include "video/pixel_buffer_output.h"
+
+#include <cstring>
+
+namespace foxglove {
+
+bool PresentFrameTo(PixelBufferOutputDelegate* delegate,
+                    std::shared_ptr<FrameBuffer> frame) {
+  if (delegate->frame_buffer_pool_options()) {
+    delegate->PresentFrame(std::move(frame));
+    return true;
+  }
+
+  auto descriptor = frame->descriptor();
+  void* planes[kMaxPlanes] = {};
+  auto user_data = delegate->LockBuffer(planes, descriptor.dimensions);
+  if (!planes[0]) {
+    delegate->UnlockBuffer(user_data);
+    return false;
+  }
+  for (uint32_t i = 0; i < descriptor.layout.plane_count; i++) {
+    memcpy(planes[i], frame->plane(i), descriptor.layout.plane_size(i));
+  }
+  // Hand the frame back to its pool as early as possible.
+  frame.reset();
+  delegate->UnlockBuffer(user_data);
+  descriptor.timing.presented_at_us = MonotonicTimeUs();
+  delegate->PresentBuffer(descriptor, user_data);
+  return true;
+}
+
+}  // namespace foxglove
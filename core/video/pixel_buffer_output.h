@@ -1,17 +1,89 @@
 #pragma once
 
+#include <memory>
+#include <optional>
+
+#include "video/frame_buffer_pool.h"
 #include "video/video_output.h"
 
 namespace foxglove {
 
+struct PixelBufferOutputStats {
+  uint64_t frames_presented = 0;
+  // Dropped to stay below the maximum frame rate.
+  uint64_t frames_decimated = 0;
+  // Not presented because they matched their predecessor.
+  uint64_t frames_skipped_duplicate = 0;
+  // Dropped because the delegate held on to all pooled buffers.
+  uint64_t frames_dropped_pool_exhausted = 0;
+  // Dropped because LockBuffer() provided no buffer.
+  uint64_t frames_dropped_no_buffer = 0;
+};
+
 class PixelBufferOutputDelegate : public VideoOutputDelegate {
  public:
+  // Called before the first frame of a new format is locked. For planar
+  // formats LockBuffer() has to provide one buffer per plane of |layout|.
+  virtual void OnFormatChanged(PixelFormat /*pixel_format*/,
+                               const VideoDimensions& /*dimensions*/,
+                               const FrameLayout& /*layout*/) {}
+
+  // Leaving |buffer| empty drops the frame. UnlockBuffer() still gets
+  // called with the returned user data.
   virtual void* LockBuffer(void** buffer,
                            const VideoDimensions& dimensions) = 0;
   virtual void UnlockBuffer(void* user_data){};
   virtual void PresentBuffer(const VideoDimensions& dimensions,
                              void* user_data) = 0;
+  // Called instead of the overload above. Delegates that care about frame
+  // timing override this one.
+  virtual void PresentBuffer(const FrameDescriptor& frame, void* user_data) {
+    PresentBuffer(frame.dimensions, user_data);
+  }
+
+  // Delegates that return pool options don't have to manage any memory.
+  // The output then decodes into buffers taken from a pool it owns and hands
+  // them to PresentFrame() instead of calling LockBuffer()/PresentBuffer().
+  // FrameBuffer::timing() describes the picture. Derive from
+  // PooledPixelBufferOutputDelegate rather than overriding these directly.
+  virtual std::optional<FrameBufferPoolOptions> frame_buffer_pool_options()
+      const {
+    return std::nullopt;
+  }
+  virtual void PresentFrame(std::shared_ptr<FrameBuffer> /*frame*/) {}
+
+  // Lets the output hash every picture and skip presenting it if it's
+  // identical to the previous one, which saves uploads for static content.
+  // Skipped buffers still get locked and unlocked.
+  virtual bool skip_duplicate_frames() const { return false; }
+
   virtual ~PixelBufferOutputDelegate() = default;
 };
 
+// Base for delegates that receive pooled frames through PresentFrame() and
+// never lock buffers of their own.
+class PooledPixelBufferOutputDelegate : public PixelBufferOutputDelegate {
+ public:
+  std::optional<FrameBufferPoolOptions> frame_buffer_pool_options()
+      const override {
+    return FrameBufferPoolOptions();
+  }
+  void PresentFrame(std::shared_ptr<FrameBuffer> frame) override = 0;
+
+  // Never called, the output presents pooled frames instead.
+  void* LockBuffer(void** /*buffer*/,
+                   const VideoDimensions& /*dimensions*/) final {
+    return nullptr;
+  }
+  void PresentBuffer(const VideoDimensions& /*dimensions*/,
+                     void* /*user_data*/) final {}
+};
+
+// Hands a pooled |frame| to |delegate|, either as is if the delegate uses a
+// pool itself, or copied into the buffer returned by its LockBuffer(). The
+// caller has to announce format changes. Returns false if the delegate had
+// no buffer available.
+bool PresentFrameTo(PixelBufferOutputDelegate* delegate,
+                    std::shared_ptr<FrameBuffer> frame);
+
 }  // namespace foxglove
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace foxglove {
+
+enum class PixelFormat {
+  kNone = 0,
+  kFormatRGBA,
+  kFormatBGRA,
+  // 8-bit 4:2:0 YUV with separate Y, U and V planes.
+  kFormatI420,
+  // 8-bit 4:2:0 YUV with a Y plane and an interleaved UV plane.
+  kFormatNV12
+};
+
+inline bool IsPlanarFormat(PixelFormat format) {
+  return format == PixelFormat::kFormatI420 ||
+         format == PixelFormat::kFormatNV12;
+}
+
+}  // namespace foxglove
@@ -0,0 +1,333 @@
+#include "video/replay_buffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include "base/lz4.h"
+#include "video/convert/convert.h"
+
+namespace foxglove {
+
+namespace {
+
+// Frames arriving slightly out of order are dropped, larger jumps back in
+// media time start over.
+constexpr int64_t kMaxReorderUs = 500000;
+
+// (Re)allocates |buffer| unless it already has the given format.
+bool EnsureBuffer(std::unique_ptr<FrameBuffer>* buffer,
+                  PixelFormat pixel_format, uint32_t width, uint32_t height) {
+  if (*buffer && (*buffer)->pixel_format() == pixel_format &&
+      (*buffer)->dimensions().width == width &&
+      (*buffer)->dimensions().height == height) {
+    return true;
+  }
+  const auto layout = ComputeFrameLayout(pixel_format, width, height);
+  *buffer = std::make_unique<FrameBuffer>(
+      pixel_format, VideoDimensions(width, height, layout.pitches[0]), layout);
+  if (!(*buffer)->is_valid()) {
+    buffer->reset();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+struct ReplayBuffer::Playback {
+  std::unique_ptr<PixelBufferOutputDelegate> delegate;
+  int64_t from_pts_us;
+  double rate;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stopped = false;
+  std::thread thread;
+};
+
+ReplayBuffer::ReplayBuffer(const ReplayBufferOptions& options)
+    : options_(options) {}
+
+ReplayBuffer::~ReplayBuffer() { StopPlayback(); }
+
+void ReplayBuffer::AddFrame(const FrameBuffer& frame) {
+  const auto pts_us = frame.timing().pts_us;
+  if (pts_us < 0) {
+    return;
+  }
+  const auto interval = std::max<uint32_t>(options_.frame_interval, 1);
+  if (frame_count_++ % interval != 0) {
+    return;
+  }
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (!frames_.empty()) {
+      const auto newest_pts_us = frames_.back()->descriptor.timing.pts_us;
+      if (pts_us < newest_pts_us - kMaxReorderUs) {
+        frames_evicted_ += frames_.size();
+        frames_.clear();
+        memory_bytes_ = 0;
+        uncompressed_bytes_ = 0;
+      } else if (pts_us < newest_pts_us) {
+        return;
+      }
+    }
+  }
+
+  const auto* source = Downscale(frame);
+  if (!source) {
+    return;
+  }
+  auto stored = std::make_shared<StoredFrame>();
+  stored->descriptor = source->descriptor();
+  stored->descriptor.timing = frame.timing();
+  stored->descriptor.yuv_matrix = frame.yuv_matrix();
+
+  const auto& layout = source->layout();
+  size_t bound = 0;
+  for (uint32_t i = 0; i < layout.plane_count; i++) {
+    bound += lz4::CompressBound(layout.plane_size(i));
+  }
+  if (compress_buffer_.size() < bound) {
+    compress_buffer_.resize(bound);
+  }
+  size_t offset = 0;
+  for (uint32_t i = 0; i < layout.plane_count; i++) {
+    const auto size = lz4::Compress(source->plane(i), layout.plane_size(i),
+                                    compress_buffer_.data() + offset,
+                                    bound - offset);
+    stored->compressed_sizes[i] = static_cast<uint32_t>(size);
+    stored->uncompressed_size += layout.plane_size(i);
+    offset += size;
+  }
+  stored->data.assign(compress_buffer_.begin(),
+                      compress_buffer_.begin() + offset);
+
+  const std::lock_guard<std::mutex> lock(mutex_);
+  memory_bytes_ += stored->data.size();
+  uncompressed_bytes_ += stored->uncompressed_size;
+  frames_.push_back(std::move(stored));
+  frames_stored_++;
+  Evict();
+}
+
+void ReplayBuffer::Clear() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  frames_.clear();
+  memory_bytes_ = 0;
+  uncompressed_bytes_ = 0;
+}
+
+bool ReplayBuffer::StartPlayback(
+    std::unique_ptr<PixelBufferOutputDelegate> delegate, int64_t from_pts_us,
+    double rate) {
+  // Held until the new thread runs, so concurrent calls can't replace a
+  // playback whose thread wasn't joined yet.
+  const std::lock_guard<std::mutex> lock(playback_mutex_);
+  StopPlaybackLocked();
+  if (!FindFrame(from_pts_us)) {
+    return false;
+  }
+
+  playback_ = std::make_unique<Playback>();
+  playback_->delegate = std::move(delegate);
+  playback_->from_pts_us = from_pts_us;
+  playback_->rate = rate > 0 ? rate : 1.0;
+  is_playing_ = true;
+  playback_->thread =
+      std::thread(&ReplayBuffer::RunPlayback, this, playback_.get());
+  return true;
+}
+
+void ReplayBuffer::StopPlayback() {
+  const std::lock_guard<std::mutex> lock(playback_mutex_);
+  StopPlaybackLocked();
+}
+
+void ReplayBuffer::StopPlaybackLocked() {
+  if (!playback_) {
+    return;
+  }
+  {
+    const std::lock_guard<std::mutex> lock(playback_->mutex);
+    playback_->stopped = true;
+  }
+  playback_->cv.notify_one();
+  playback_->thread.join();
+  playback_.reset();
+}
+
+ReplayBufferStats ReplayBuffer::stats() const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  ReplayBufferStats stats;
+  stats.frames_stored = frames_stored_;
+  stats.frames_evicted = frames_evicted_;
+  stats.frame_count = frames_.size();
+  stats.memory_bytes = memory_bytes_;
+  stats.uncompressed_bytes = uncompressed_bytes_;
+  if (!frames_.empty()) {
+    stats.oldest_pts_us = frames_.front()->descriptor.timing.pts_us;
+    stats.newest_pts_us = frames_.back()->descriptor.timing.pts_us;
+  }
+  return stats;
+}
+
+const FrameBuffer* ReplayBuffer::Downscale(const FrameBuffer& frame) {
+  const auto pixel_format = frame.pixel_format();
+  if ((pixel_format != PixelFormat::kFormatRGBA &&
+       pixel_format != PixelFormat::kFormatBGRA) ||
+      options_.max_width == 0) {
+    return &frame;
+  }
+
+  auto width = frame.dimensions().width;
+  auto height = frame.dimensions().height;
+  uint32_t steps = 0;
+  while (width > options_.max_width && width >= 2 && height >= 2) {
+    width /= 2;
+    height /= 2;
+    steps++;
+  }
+  if (steps == 0) {
+    return &frame;
+  }
+  // Intermediate steps run in place in |scratch_|, the last one writes the
+  // compact result.
+  if (!EnsureBuffer(&downscaled_, pixel_format, width, height) ||
+      (steps > 1 &&
+       !EnsureBuffer(&scratch_, pixel_format, frame.dimensions().width / 2,
+                     frame.dimensions().height / 2))) {
+    return nullptr;
+  }
+
+  const uint8_t* src = frame.plane(0);
+  auto src_pitch = frame.pitch(0);
+  width = frame.dimensions().width;
+  height = frame.dimensions().height;
+  for (uint32_t step = 1; step <= steps; step++) {
+    width /= 2;
+    height /= 2;
+    auto* dst = step == steps ? downscaled_.get() : scratch_.get();
+    convert::HalveRgba(src, src_pitch, dst->plane(0), dst->pitch(0), width,
+                       height);
+    src = dst->plane(0);
+    src_pitch = dst->pitch(0);
+  }
+  return downscaled_.get();
+}
+
+void ReplayBuffer::Evict() {
+  const auto max_duration_us = options_.max_duration_ms * 1000;
+  const auto newest_pts_us = frames_.back()->descriptor.timing.pts_us;
+  while (frames_.size() > 1 &&
+         (memory_bytes_ > options_.max_memory_bytes ||
+          newest_pts_us - frames_.front()->descriptor.timing.pts_us >
+              max_duration_us)) {
+    memory_bytes_ -= frames_.front()->data.size();
+    uncompressed_bytes_ -= frames_.front()->uncompressed_size;
+    frames_.pop_front();
+    frames_evicted_++;
+  }
+}
+
+std::shared_ptr<const ReplayBuffer::StoredFrame> ReplayBuffer::FindFrame(
+    int64_t from_pts_us) const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  auto it = std::lower_bound(
+      frames_.begin(), frames_.end(), from_pts_us,
+      [](const auto& frame, int64_t pts_us) {
+        return frame->descriptor.timing.pts_us < pts_us;
+      });
+  return it != frames_.end() ? *it : nullptr;
+}
+
+void ReplayBuffer::RunPlayback(Playback* playback) {
+  using Clock = std::chrono::steady_clock;
+  auto* delegate = playback->delegate.get();
+  FrameBufferPool pool(
+      delegate->frame_buffer_pool_options().value_or(FrameBufferPoolOptions{}));
+  std::optional<FrameDescriptor> format;
+
+  auto next_pts_us = playback->from_pts_us;
+  int64_t first_pts_us = -1;
+  Clock::time_point start;
+  while (true) {
+    const auto stored = FindFrame(next_pts_us);
+    if (!stored) {
+      break;
+    }
+    const auto& descriptor = stored->descriptor;
+    const auto pts_us = descriptor.timing.pts_us;
+    next_pts_us = pts_us + 1;
+    if (first_pts_us < 0) {
+      first_pts_us = pts_us;
+      start = Clock::now();
+    }
+
+    const auto due =
+        start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double, std::micro>(
+                        (pts_us - first_pts_us) / playback->rate));
+    {
+      std::unique_lock<std::mutex> lock(playback->mutex);
+      if (playback->cv.wait_until(lock, due,
+                                  [playback] { return playback->stopped; })) {
+        break;
+      }
+    }
+
+    pool.Configure(descriptor.pixel_format, descriptor.dimensions,
+                   descriptor.layout);
+    auto frame = pool.Acquire();
+    if (!frame || !Decompress(*stored, frame.get())) {
+      continue;
+    }
+    if (!format || format->pixel_format != descriptor.pixel_format ||
+        format->dimensions != descriptor.dimensions ||
+        format->layout != descriptor.layout) {
+      delegate->OnFormatChanged(descriptor.pixel_format,
+                                descriptor.dimensions, descriptor.layout);
+      format = descriptor;
+    }
+    auto timing = descriptor.timing;
+    timing.presented_at_us = MonotonicTimeUs();
+    frame->set_timing(timing);
+    frame->set_yuv_matrix(descriptor.yuv_matrix);
+    PresentFrameTo(delegate, std::move(frame));
+  }
+  is_playing_ = false;
+}
+
+bool ReplayBuffer::Decompress(const StoredFrame& stored, FrameBuffer* frame) {
+  const auto& layout = stored.descriptor.layout;
+  size_t offset = 0;
+  for (uint32_t i = 0; i < layout.plane_count; i++) {
+    const auto size = stored.compressed_sizes[i];
+    if (!lz4::Decompress(stored.data.data() + offset, size, frame->plane(i),
+                         layout.plane_size(i))) {
+      return false;
+    }
+    offset += size;
+  }
+  return true;
+}
+
+ReplayBufferDelegate::ReplayBufferDelegate(
+    std::shared_ptr<ReplayBuffer> buffer)
+    : buffer_(std::move(buffer)) {}
+
+std::optional<FrameBufferPoolOptions>
+ReplayBufferDelegate::frame_buffer_pool_options() const {
+  // Frames are compressed right away, one being decoded and one being
+  // stored is enough.
+  FrameBufferPoolOptions pool_options;
+  pool_options.capacity = 2;
+  return pool_options;
+}
+
+void ReplayBufferDelegate::PresentFrame(std::shared_ptr<FrameBuffer> frame) {
+  buffer_->AddFrame(*frame);
+}
+
+}  // namespace foxglove
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "video/pixel_buffer_output.h"
+
+namespace foxglove {
+
+struct ReplayBufferOptions {
+  // Frames older than this, relative to the newest one, get evicted.
+  int64_t max_duration_ms = 30000;
+  // Compressed frames kept at most, the oldest ones get evicted first.
+  size_t max_memory_bytes = 64 * 1024 * 1024;
+  // RGBA and BGRA frames get halved until they're at most this wide, 0
+  // keeps their size. Other formats are stored as is.
+  uint32_t max_width = 640;
+  // Only every nth frame gets stored.
+  uint32_t frame_interval = 1;
+};
+
+struct ReplayBufferStats {
+  uint64_t frames_stored = 0;
+  uint64_t frames_evicted = 0;
+  // Frames currently buffered, and their size compressed and uncompressed.
+  size_t frame_count = 0;
+  size_t memory_bytes = 0;
+  size_t uncompressed_bytes = 0;
+  // Media time range of the buffered frames, -1 if empty.
+  int64_t oldest_pts_us = -1;
+  int64_t newest_pts_us = -1;
+};
+
+// Keeps the last seconds of a player's stream as LZ4 compressed, optionally
+// downscaled frames indexed by media time, and plays them back to a
+// separate delegate without touching the source. Frames without a
+// presentation time are ignored. A jump back in media time, e.g. from
+// seeking, starts over.
+class ReplayBuffer final {
+ public:
+  explicit ReplayBuffer(const ReplayBufferOptions& options = {});
+  // Stops playback.
+  ~ReplayBuffer();
+
+  ReplayBuffer(const ReplayBuffer&) = delete;
+  ReplayBuffer& operator=(const ReplayBuffer&) = delete;
+
+  // Compresses and stores |frame|. Must be called from a single thread.
+  void AddFrame(const FrameBuffer& frame);
+  void Clear();
+
+  // Presents the buffered frames from |from_pts_us| on to |delegate| on a
+  // separate thread, paced by their presentation times at |rate|. Ends once
+  // it runs out of frames, skips ahead if frames get evicted before being
+  // presented. Stops any previous playback. Returns false if there's no
+  // frame at or after |from_pts_us|.
+  bool StartPlayback(std::unique_ptr<PixelBufferOutputDelegate> delegate,
+                     int64_t from_pts_us, double rate = 1.0);
+  void StopPlayback();
+  bool is_playing() const { return is_playing_; }
+
+  // May be called from any thread.
+  ReplayBufferStats stats() const;
+
+ private:
+  struct StoredFrame {
+    FrameDescriptor descriptor;
+    // All planes compressed back to back.
+    std::vector<uint8_t> data;
+    std::array<uint32_t, kMaxPlanes> compressed_sizes{};
+    size_t uncompressed_size = 0;
+  };
+  struct Playback;
+
+  ReplayBufferOptions options_;
+
+  mutable std::mutex mutex_;
+  // Ordered by presentation time.
+  std::deque<std::shared_ptr<const StoredFrame>> frames_;
+  size_t memory_bytes_ = 0;
+  size_t uncompressed_bytes_ = 0;
+  uint64_t frames_stored_ = 0;
+  uint64_t frames_evicted_ = 0;
+
+  // Only accessed by the thread adding frames.
+  uint64_t frame_count_ = 0;
+  std::unique_ptr<FrameBuffer> scratch_;
+  std::unique_ptr<FrameBuffer> downscaled_;
+  std::vector<uint8_t> compress_buffer_;
+
+  // Guards starting and stopping playback. The playback thread never takes
+  // it, so it's held while joining.
+  std::mutex playback_mutex_;
+  std::unique_ptr<Playback> playback_;
+  std::atomic<bool> is_playing_ = false;
+
+  const FrameBuffer* Downscale(const FrameBuffer& frame);
+  void Evict();
+  std::shared_ptr<const StoredFrame> FindFrame(int64_t from_pts_us) const;
+  void StopPlaybackLocked();
+  void RunPlayback(Playback* playback);
+  static bool Decompress(const StoredFrame& stored, FrameBuffer* frame);
+};
+
+// Feeds the frames of a player into a ReplayBuffer. Compression runs on the
+// vout thread, wrap it in a FrameFanOutDelegate to move it off.
+class ReplayBufferDelegate : public PooledPixelBufferOutputDelegate {
+ public:
+  explicit ReplayBufferDelegate(std::shared_ptr<ReplayBuffer> buffer);
+
+  std::optional<FrameBufferPoolOptions> frame_buffer_pool_options()
+      const override;
+  void PresentFrame(std::shared_ptr<FrameBuffer> frame) override;
+
+ private:
+  std::shared_ptr<ReplayBuffer> buffer_;
+};
+
+}  // namespace foxglove
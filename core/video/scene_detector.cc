@@ -0,0 +1,163 @@
+#include "video/scene_detector.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#include "video/convert/convert.h"
+
+namespace foxglove {
+
+SceneDetector::SceneDetector(const SceneDetectorOptions& options)
+    : options_(options) {}
+
+std::vector<SceneThumbnail> SceneDetector::scenes() const {
+  const std::lock_guard<std::mutex> lock(scenes_mutex_);
+  return scenes_;
+}
+
+void SceneDetector::Reset() {
+  {
+    const std::lock_guard<std::mutex> lock(scenes_mutex_);
+    scenes_.clear();
+  }
+  is_reset_pending_ = true;
+}
+
+void SceneDetector::Analyze(const FrameDescriptor& frame,
+                            const uint8_t* const* planes) {
+  if (is_reset_pending_.exchange(false)) {
+    previous_.reset();
+    previous_pts_us_ = -1;
+    pending_scene_.reset();
+  }
+  const auto pts_us = frame.timing.pts_us;
+  if (pts_us < 0) {
+    return;
+  }
+
+  LumaStatistics statistics;
+  if (!ComputeLumaStatistics(frame, planes, options_.row_step,
+                             &statistics)) {
+    return;
+  }
+  const auto previous = std::exchange(previous_, statistics);
+  const auto previous_pts_us = std::exchange(previous_pts_us_, pts_us);
+
+  if (!previous) {
+    StartScene(frame, planes, 0);
+    return;
+  }
+  if (std::abs(pts_us - previous_pts_us) > options_.max_frame_gap_ms * 1000) {
+    // How long the pending scene lasted is unknown.
+    pending_scene_.reset();
+    return;
+  }
+  const auto score = HistogramDistance(*previous, statistics);
+  if (score >= options_.cut_threshold) {
+    StartScene(frame, planes, score);
+    return;
+  }
+  if (pending_scene_ && pts_us - pending_scene_->pts_us >=
+                            options_.min_scene_duration_ms * 1000) {
+    RecordScene(std::move(*pending_scene_));
+    pending_scene_.reset();
+  }
+}
+
+void SceneDetector::StartScene(const FrameDescriptor& frame,
+                               const uint8_t* const* planes, double score) {
+  // The frame is gone by the time the scene turns out to be long enough,
+  // so the thumbnail is taken right away.
+  pending_scene_.reset();
+  auto thumbnail = MakeThumbnail(frame, planes);
+  if (!thumbnail) {
+    return;
+  }
+  SceneThumbnail scene;
+  scene.pts_us = frame.timing.pts_us;
+  scene.score = score;
+  scene.thumbnail = std::move(thumbnail);
+  pending_scene_ = std::move(scene);
+}
+
+void SceneDetector::RecordScene(SceneThumbnail scene) {
+  const auto pts_us = scene.pts_us;
+  const auto min_distance_us = options_.min_scene_duration_ms * 1000;
+  const std::lock_guard<std::mutex> lock(scenes_mutex_);
+  const auto is_near = [pts_us, min_distance_us](const auto& recorded) {
+    return std::abs(recorded.pts_us - pts_us) < min_distance_us;
+  };
+  if (scenes_.size() >= options_.max_scenes ||
+      std::any_of(scenes_.begin(), scenes_.end(), is_near)) {
+    return;
+  }
+  auto it = std::upper_bound(
+      scenes_.begin(), scenes_.end(), pts_us,
+      [](int64_t pts_us, const auto& scene) { return pts_us < scene.pts_us; });
+  scenes_.insert(it, std::move(scene));
+}
+
+std::shared_ptr<const FrameBuffer> SceneDetector::MakeThumbnail(
+    const FrameDescriptor& frame, const uint8_t* const* planes) {
+  const auto width = frame.dimensions.width;
+  const auto height = frame.dimensions.height;
+  if (width == 0 || height == 0) {
+    return nullptr;
+  }
+  const auto thumbnail_width =
+      std::min(std::max(options_.thumbnail_width, 1u), width);
+  const auto thumbnail_height = static_cast<uint32_t>(std::max<uint64_t>(
+      1, static_cast<uint64_t>(height) * thumbnail_width / width));
+
+  const auto layout =
+      ComputeFrameLayout(PixelFormat::kFormatRGBA, width, height);
+  if (!scratch_ || scratch_->dimensions().width != width ||
+      scratch_->dimensions().height != height) {
+    scratch_ = std::make_unique<FrameBuffer>(
+        PixelFormat::kFormatRGBA,
+        VideoDimensions(width, height, layout.pitches[0]), layout);
+    if (!scratch_->is_valid()) {
+      scratch_.reset();
+      return nullptr;
+    }
+  }
+  uint8_t* scratch_planes[kMaxPlanes] = {scratch_->plane(0)};
+  if (!convert::ConvertPicture(frame.pixel_format, planes, frame.layout,
+                               PixelFormat::kFormatRGBA, scratch_planes,
+                               layout, width, height, frame.yuv_matrix)) {
+    return nullptr;
+  }
+
+  // Halve until within 2x of the thumbnail size, where bilinear scaling
+  // doesn't alias yet.
+  const auto pitch = layout.pitches[0];
+  auto scaled_width = width;
+  auto scaled_height = height;
+  while (scaled_width / 2 >= thumbnail_width &&
+         scaled_height / 2 >= thumbnail_height) {
+    scaled_width /= 2;
+    scaled_height /= 2;
+    convert::HalveRgba(scratch_->plane(0), pitch, scratch_->plane(0), pitch,
+                       scaled_width, scaled_height);
+  }
+
+  const auto thumbnail_layout = ComputeFrameLayout(
+      PixelFormat::kFormatRGBA, thumbnail_width, thumbnail_height);
+  auto thumbnail = std::make_shared<FrameBuffer>(
+      PixelFormat::kFormatRGBA,
+      VideoDimensions(thumbnail_width, thumbnail_height,
+                      thumbnail_layout.pitches[0]),
+      thumbnail_layout);
+  if (!thumbnail->is_valid()) {
+    return nullptr;
+  }
+  convert::RgbaScaler(scaled_width, scaled_height, thumbnail_width,
+                      thumbnail_height)
+      .Scale(scratch_->plane(0), pitch, thumbnail->plane(0),
+             thumbnail_layout.pitches[0]);
+  thumbnail->set_timing(frame.timing);
+  return thumbnail;
+}
+
+}  // namespace foxglove
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "video/frame_analyzer.h"
+#include "video/frame_buffer.h"
+#include "video/luma_statistics.h"
+
+namespace foxglove {
+
+struct SceneDetectorOptions {
+  // Only every nth row gets sampled for the histogram.
+  uint32_t row_step = 4;
+  // Histogram distance (0 to 2) to the previous frame at or above which a
+  // frame starts a new scene.
+  double cut_threshold = 0.5;
+  // Shorter scenes aren't recorded. Scenes starting closer than this to a
+  // recorded one are ignored too, e.g. after seeking back.
+  int64_t min_scene_duration_ms = 1000;
+  // Media time gaps beyond this, e.g. from seeking, aren't taken as cuts.
+  int64_t max_frame_gap_ms = 2000;
+  // Thumbnails are RGBA, this wide at most and keep the aspect ratio.
+  uint32_t thumbnail_width = 160;
+  // Cuts beyond this many scenes aren't recorded.
+  size_t max_scenes = 500;
+};
+
+struct SceneThumbnail {
+  // Media time of the scene's first frame in microseconds.
+  int64_t pts_us = -1;
+  // Histogram distance to the previous frame, 0 for the first scene.
+  double score = 0;
+  std::shared_ptr<const FrameBuffer> thumbnail;
+};
+
+// Detects scene cuts by comparing the luma histograms of consecutive frames
+// and keeps a thumbnail of the first frame of every scene, so chapter strips
+// can be built during normal playback. Frames without a presentation time
+// are ignored.
+class SceneDetector : public FrameAnalyzer {
+ public:
+  explicit SceneDetector(const SceneDetectorOptions& options = {});
+
+  // Returns the scenes recorded since the last reset, ordered by time. May
+  // be called from any thread.
+  std::vector<SceneThumbnail> scenes() const;
+  // Forgets all scenes, e.g. when other media gets opened. May be called
+  // from any thread.
+  void Reset();
+
+  void Analyze(const FrameDescriptor& frame,
+               const uint8_t* const* planes) override;
+
+ private:
+  SceneDetectorOptions options_;
+
+  mutable std::mutex scenes_mutex_;
+  std::vector<SceneThumbnail> scenes_;
+  std::atomic<bool> is_reset_pending_ = false;
+
+  // Only accessed by the vout thread.
+  std::optional<LumaStatistics> previous_;
+  int64_t previous_pts_us_ = -1;
+  // The latest scene, recorded once it lasted long enough.
+  std::optional<SceneThumbnail> pending_scene_;
+  // Full size RGBA copy of the picture being thumbnailed.
+  std::unique_ptr<FrameBuffer> scratch_;
+
+  void StartScene(const FrameDescriptor& frame, const uint8_t* const* planes,
+                  double score);
+  void RecordScene(SceneThumbnail scene);
+  std::shared_ptr<const FrameBuffer> MakeThumbnail(
+      const FrameDescriptor& frame, const uint8_t* const* planes);
+};
+
+}  // namespace foxglove
@@ -0,0 +1,426 @@
+#include "video/shared_frame_ring.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+
+namespace foxglove {
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+              "Shared memory atomics must be address free");
+
+namespace {
+
+constexpr size_t kPageSize = 4096;
+constexpr size_t kPlaneAlignment = 64;
+
+size_t AlignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+ErrorDetails ErrnoError(std::string_view message) {
+  const auto error = errno;
+  return ErrorDetails(message, strerror(error), error);
+}
+
+int CreateSharedMemory(const std::string& name) {
+  auto fd = memfd_create(name.c_str(), MFD_CLOEXEC);
+  if (fd >= 0 || errno != ENOSYS) {
+    return fd;
+  }
+
+  // Kernels before 3.17 lack memfd_create. An unlinked POSIX shared memory
+  // object behaves the same once it's open.
+  static std::atomic<uint32_t> counter = 0;
+  const auto shm_name = "/" + name + "-" + std::to_string(getpid()) + "-" +
+                        std::to_string(counter++);
+  fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC,
+                0600);
+  if (fd >= 0) {
+    shm_unlink(shm_name.c_str());
+  }
+  return fd;
+}
+
+// Waits and wakes are process shared, so FUTEX_PRIVATE_FLAG must not be set.
+long Futex(std::atomic<uint32_t>* word, int op, uint32_t value,
+           const timespec* timeout) {
+  return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value,
+                 timeout, nullptr, 0);
+}
+
+}  // namespace
+
+tl::expected<std::unique_ptr<SharedFrameRingWriter>, ErrorDetails>
+SharedFrameRingWriter::Create(const std::string& name,
+                              const SharedFrameRingOptions& options) {
+  if (options.slot_count < 2) {
+    return tl::make_unexpected(
+        ErrorDetails("A shared frame ring needs at least two slots"));
+  }
+
+  const auto memory_fd = CreateSharedMemory(name);
+  if (memory_fd < 0) {
+    return tl::make_unexpected(ErrnoError("Creating shared memory failed"));
+  }
+
+  auto event_fd = -1;
+  if (options.create_event_fd) {
+    event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (event_fd < 0) {
+      auto error = ErrnoError("Creating eventfd failed");
+      close(memory_fd);
+      return tl::make_unexpected(std::move(error));
+    }
+  }
+
+  std::unique_ptr<SharedFrameRingWriter> writer(
+      new SharedFrameRingWriter(memory_fd, event_fd, options.slot_count));
+  auto status = writer->Resize(kPageSize);
+  if (!status.ok()) {
+    return tl::make_unexpected(status.error());
+  }
+
+  auto header = new (writer->mapping_) SharedFrameRingHeader();
+  header->magic = kSharedFrameRingMagic;
+  header->version = kSharedFrameRingVersion;
+  header->slot_count = options.slot_count;
+  header->slots_offset = AlignUp(sizeof(SharedFrameRingHeader), kPageSize);
+  header->mapped_size = kPageSize;
+  return writer;
+}
+
+SharedFrameRingWriter::SharedFrameRingWriter(int memory_fd, int event_fd,
+                                             uint32_t slot_count)
+    : memory_fd_(memory_fd), event_fd_(event_fd), slot_count_(slot_count) {}
+
+SharedFrameRingWriter::~SharedFrameRingWriter() {
+  if (mapping_) {
+    munmap(mapping_, mapped_size_);
+  }
+  close(memory_fd_);
+  if (event_fd_ >= 0) {
+    close(event_fd_);
+  }
+}
+
+Status<ErrorDetails> SharedFrameRingWriter::Resize(size_t size) {
+  if (ftruncate(memory_fd_, static_cast<off_t>(size)) != 0) {
+    return ErrnoError("Resizing shared memory failed");
+  }
+
+  auto mapping =
+      mapping_ ? mremap(mapping_, mapped_size_, size, MREMAP_MAYMOVE)
+               : mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      memory_fd_, 0);
+  if (mapping == MAP_FAILED) {
+    return ErrnoError("Mapping shared memory failed");
+  }
+  mapping_ = static_cast<uint8_t*>(mapping);
+  mapped_size_ = size;
+  return OkStatus();
+}
+
+SharedFrameSlotHeader* SharedFrameRingWriter::slot(uint64_t index) const {
+  auto h = header();
+  return reinterpret_cast<SharedFrameSlotHeader*>(
+      mapping_ + h->slots_offset.load(std::memory_order_relaxed) +
+      (index % slot_count_) * h->slot_stride.load(std::memory_order_relaxed));
+}
+
+Status<ErrorDetails> SharedFrameRingWriter::Configure(
+    PixelFormat pixel_format, const VideoDimensions& dimensions,
+    const FrameLayout& layout) {
+  if (pixel_format == pixel_format_ && dimensions == dimensions_ &&
+      layout == layout_) {
+    return OkStatus();
+  }
+
+  std::array<uint64_t, kMaxPlanes> plane_offsets{};
+  size_t offset = AlignUp(sizeof(SharedFrameSlotHeader), kPlaneAlignment);
+  for (uint32_t i = 0; i < layout.plane_count; i++) {
+    plane_offsets[i] = offset;
+    offset = AlignUp(offset + layout.plane_size(i), kPlaneAlignment);
+  }
+  const auto slot_stride = AlignUp(offset, kPageSize);
+
+  auto h = header();
+  if (slot_stride > h->slot_stride.load(std::memory_order_relaxed)) {
+    const auto slots_offset = h->slots_offset.load(std::memory_order_relaxed);
+    // Growing the file doesn't disturb readers of the current slots.
+    auto status = Resize(slots_offset + slot_stride * slot_count_);
+    if (!status.ok()) {
+      return status;
+    }
+    h = header();
+  }
+
+  // Readers holding a frame of the old geometry see the generation change
+  // in IsCurrent(). The cleared slots hide frames published before.
+  h->generation.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  if (slot_stride > h->slot_stride.load(std::memory_order_relaxed)) {
+    h->slot_stride.store(slot_stride, std::memory_order_relaxed);
+    h->mapped_size.store(mapped_size_, std::memory_order_relaxed);
+  }
+  for (uint32_t i = 0; i < slot_count_; i++) {
+    new (slot(i)) SharedFrameSlotHeader();
+  }
+  h->generation.fetch_add(1, std::memory_order_release);
+
+  pixel_format_ = pixel_format;
+  dimensions_ = dimensions;
+  layout_ = layout;
+  plane_offsets_ = plane_offsets;
+  return OkStatus();
+}
+
+bool SharedFrameRingWriter::BeginWrite(void** planes) {
+  if (pixel_format_ == PixelFormat::kNone) {
+    return false;
+  }
+
+  // The next frame gets sequence number sequence_ + 1.
+  writing_ = slot(sequence_);
+  writing_->sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  for (uint32_t i = 0; i < layout_.plane_count; i++) {
+    planes[i] = reinterpret_cast<uint8_t*>(writing_) + plane_offsets_[i];
+  }
+  return true;
+}
+
+void SharedFrameRingWriter::Publish(int64_t pts_us) {
+  if (!writing_) {
+    return;
+  }
+
+  writing_->pts_us = pts_us;
+  writing_->pixel_format = static_cast<uint32_t>(pixel_format_);
+  writing_->width = dimensions_.width;
+  writing_->height = dimensions_.height;
+  writing_->plane_count = layout_.plane_count;
+  for (size_t i = 0; i < kMaxPlanes; i++) {
+    writing_->pitches[i] = layout_.pitches[i];
+    writing_->lines[i] = layout_.lines[i];
+    writing_->plane_offsets[i] = plane_offsets_[i];
+  }
+  writing_->sequence.store(++sequence_, std::memory_order_release);
+  writing_ = nullptr;
+
+  auto h = header();
+  h->latest_sequence.store(sequence_);
+  h->futex_word.fetch_add(1);
+  if (h->waiters.load() > 0) {
+    Futex(&h->futex_word, FUTEX_WAKE, INT_MAX, nullptr);
+  }
+
+  if (event_fd_ >= 0) {
+    const uint64_t value = 1;
+    [[maybe_unused]] auto written = write(event_fd_, &value, sizeof(value));
+  }
+}
+
+tl::expected<std::unique_ptr<SharedFrameRingReader>, ErrorDetails>
+SharedFrameRingReader::Open(int memory_fd, int event_fd) {
+  std::unique_ptr<SharedFrameRingReader> reader(
+      new SharedFrameRingReader(memory_fd, event_fd));
+
+  struct stat info;
+  if (fstat(memory_fd, &info) != 0) {
+    return tl::make_unexpected(ErrnoError("Querying shared memory failed"));
+  }
+  if (static_cast<size_t>(info.st_size) < sizeof(SharedFrameRingHeader)) {
+    return tl::make_unexpected(ErrorDetails("Not a shared frame ring"));
+  }
+
+  auto status = reader->Map(static_cast<size_t>(info.st_size));
+  if (!status.ok()) {
+    return tl::make_unexpected(status.error());
+  }
+
+  const auto header = reader->header();
+  if (header->magic != kSharedFrameRingMagic) {
+    return tl::make_unexpected(ErrorDetails("Not a shared frame ring"));
+  }
+  if (header->version != kSharedFrameRingVersion) {
+    return tl::make_unexpected(ErrorDetails(
+        "Unsupported shared frame ring version", header->version));
+  }
+  return reader;
+}
+
+SharedFrameRingReader::SharedFrameRingReader(int memory_fd, int event_fd)
+    : memory_fd_(memory_fd), event_fd_(event_fd) {}
+
+SharedFrameRingReader::~SharedFrameRingReader() {
+  if (mapping_) {
+    munmap(mapping_, mapped_size_);
+  }
+  close(memory_fd_);
+  if (event_fd_ >= 0) {
+    close(event_fd_);
+  }
+}
+
+Status<ErrorDetails> SharedFrameRingReader::Map(size_t size) {
+  // The ring header is written to for futex waits.
+  auto mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      memory_fd_, 0);
+  if (mapping == MAP_FAILED) {
+    return ErrnoError("Mapping shared memory failed");
+  }
+
+  if (mapping_) {
+    munmap(mapping_, mapped_size_);
+  }
+  mapping_ = static_cast<uint8_t*>(mapping);
+  mapped_size_ = size;
+  return OkStatus();
+}
+
+uint64_t SharedFrameRingReader::latest_sequence() const {
+  return header()->latest_sequence.load(std::memory_order_acquire);
+}
+
+bool SharedFrameRingReader::WaitForFrame(uint64_t sequence,
+                                         std::chrono::milliseconds timeout) {
+  auto h = header();
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+  // Pairs with the writer bumping futex_word before checking for waiters,
+  // so a wakeup can't get lost between the check and the wait.
+  h->waiters.fetch_add(1);
+  auto result = false;
+  while (true) {
+    const auto word = h->futex_word.load();
+    if (h->latest_sequence.load() > sequence) {
+      result = true;
+      break;
+    }
+
+    const auto remaining = deadline - std::chrono::steady_clock::now();
+    if (remaining <= std::chrono::steady_clock::duration::zero()) {
+      break;
+    }
+    const auto nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(remaining)
+            .count();
+    timespec relative_timeout{
+        static_cast<time_t>(nanoseconds / 1000000000),
+        static_cast<long>(nanoseconds % 1000000000)};
+    Futex(&h->futex_word, FUTEX_WAIT, word, &relative_timeout);
+  }
+  h->waiters.fetch_sub(1);
+  return result;
+}
+
+std::optional<SharedFrame> SharedFrameRingReader::AcquireLatest() {
+  auto h = header();
+  const auto generation = h->generation.load(std::memory_order_acquire);
+  if (generation & 1) {
+    return std::nullopt;
+  }
+
+  const auto size = h->mapped_size.load(std::memory_order_relaxed);
+  if (size > mapped_size_) {
+    // Touching pages beyond the end of the file raises SIGBUS.
+    struct stat info;
+    if (fstat(memory_fd_, &info) != 0 ||
+        static_cast<uint64_t>(info.st_size) < size || !Map(size).ok()) {
+      return std::nullopt;
+    }
+    h = header();
+  }
+
+  const auto sequence = h->latest_sequence.load(std::memory_order_acquire);
+  const auto slot = FindSlot(sequence);
+  if (!slot || slot->sequence.load(std::memory_order_acquire) != sequence) {
+    return std::nullopt;
+  }
+  const auto slot_stride = h->slot_stride.load(std::memory_order_relaxed);
+
+  SharedFrame frame;
+  frame.sequence = sequence;
+  frame.pts_us = slot->pts_us;
+  frame.pixel_format = static_cast<PixelFormat>(slot->pixel_format);
+  frame.layout.plane_count = slot->plane_count;
+  for (size_t i = 0; i < kMaxPlanes; i++) {
+    frame.layout.pitches[i] = slot->pitches[i];
+    frame.layout.lines[i] = slot->lines[i];
+  }
+  frame.dimensions = VideoDimensions(slot->width, slot->height,
+                                     frame.layout.pitches[0]);
+  if (frame.layout.plane_count > kMaxPlanes) {
+    return std::nullopt;
+  }
+  for (uint32_t i = 0; i < frame.layout.plane_count; i++) {
+    const auto plane_offset = slot->plane_offsets[i];
+    if (plane_offset < sizeof(SharedFrameSlotHeader) ||
+        plane_offset > slot_stride ||
+        frame.layout.plane_size(i) > slot_stride - plane_offset) {
+      return std::nullopt;
+    }
+    frame.planes[i] = reinterpret_cast<const uint8_t*>(slot) + plane_offset;
+  }
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot->sequence.load(std::memory_order_relaxed) != sequence ||
+      h->generation.load(std::memory_order_relaxed) != generation) {
+    return std::nullopt;
+  }
+  generation_ = generation;
+  return frame;
+}
+
+bool SharedFrameRingReader::IsCurrent(const SharedFrame& frame) const {
+  // Orders the caller's reads of the pixels before the checks below.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (header()->generation.load(std::memory_order_relaxed) != generation_) {
+    return false;
+  }
+
+  const auto slot = FindSlot(frame.sequence);
+  return slot &&
+         slot->sequence.load(std::memory_order_relaxed) == frame.sequence;
+}
+
+const SharedFrameSlotHeader* SharedFrameRingReader::FindSlot(
+    uint64_t sequence) const {
+  // The writer may be broken or hostile, so don't trust the header's
+  // geometry to stay within the mapping.
+  const auto h = header();
+  const uint64_t slot_count = h->slot_count;
+  const auto slots_offset = h->slots_offset.load(std::memory_order_relaxed);
+  const auto slot_stride = h->slot_stride.load(std::memory_order_relaxed);
+  if (sequence == 0 || slot_count == 0 ||
+      slot_stride < sizeof(SharedFrameSlotHeader) ||
+      slots_offset < sizeof(SharedFrameRingHeader) ||
+      slots_offset > mapped_size_ ||
+      (slots_offset | slot_stride) % alignof(SharedFrameSlotHeader) != 0 ||
+      slot_stride > (mapped_size_ - slots_offset) / slot_count) {
+    return nullptr;
+  }
+  return reinterpret_cast<const SharedFrameSlotHeader*>(
+      mapping_ + slots_offset + ((sequence - 1) % slot_count) * slot_stride);
+}
+
+void SharedFrameRingReader::ClearEvent() {
+  if (event_fd_ >= 0) {
+    uint64_t value;
+    [[maybe_unused]] auto bytes_read = read(event_fd_, &value, sizeof(value));
+  }
+}
+
+}  // namespace foxglove
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "base/error_details.h"
+#include "base/status.h"
+#include "third_party/expected.h"
+#include "video/frame_layout.h"
+#include "video/video_dimensions.h"
+
+// A ring of decoded frames in a memfd (or POSIX shared memory) mapping that
+// other processes can read in place. Doesn't depend on libvlc, so readers
+// can build just this file. Linux only.
+
+namespace foxglove {
+
+constexpr uint32_t kSharedFrameRingMagic = 0x46475246;  // "FRGF"
+// Bump on any change to the structures below.
+constexpr uint32_t kSharedFrameRingVersion = 1;
+
+// Lives at offset 0 of the mapping.
+struct alignas(64) SharedFrameRingHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t slot_count;
+  uint32_t reserved;
+  // Odd while the writer changes the geometry below.
+  std::atomic<uint32_t> generation;
+  // Incremented on every publish, readers futex-wait on it.
+  std::atomic<uint32_t> futex_word;
+  // Number of readers blocked in a futex wait.
+  std::atomic<uint32_t> waiters;
+  std::atomic<uint64_t> slots_offset;
+  std::atomic<uint64_t> slot_stride;
+  // Grows when larger frames get negotiated.
+  std::atomic<uint64_t> mapped_size;
+  // Sequence number of the newest published frame, 0 if there's none.
+  // Frame n lives in slot (n - 1) % slot_count.
+  std::atomic<uint64_t> latest_sequence;
+};
+
+// Precedes the pixel data of every slot.
+struct alignas(64) SharedFrameSlotHeader {
+  // Sequence number of the frame in this slot, 0 while it's being written.
+  std::atomic<uint64_t> sequence;
+  // Media time in microseconds, -1 if unknown.
+  int64_t pts_us;
+  uint32_t pixel_format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t plane_count;
+  uint32_t pitches[kMaxPlanes];
+  uint32_t lines[kMaxPlanes];
+  // Relative to the start of the slot header.
+  uint64_t plane_offsets[kMaxPlanes];
+};
+
+struct SharedFrameRingOptions {
+  // Readers have slot_count - 1 frame intervals to process a frame before
+  // it gets overwritten.
+  uint32_t slot_count = 4;
+  // Creates an eventfd that gets signaled on every publish, for readers
+  // that multiplex with poll() or epoll.
+  bool create_event_fd = true;
+};
+
+// Producer side. All methods must be called from a single thread.
+class SharedFrameRingWriter final {
+ public:
+  static tl::expected<std::unique_ptr<SharedFrameRingWriter>, ErrorDetails>
+  Create(const std::string& name, const SharedFrameRingOptions& options = {});
+  ~SharedFrameRingWriter();
+
+  SharedFrameRingWriter(const SharedFrameRingWriter&) = delete;
+  SharedFrameRingWriter& operator=(const SharedFrameRingWriter&) = delete;
+
+  // Grows the ring if frames of the given layout don't fit. Invalidates all
+  // published frames if the format, dimensions or layout change.
+  Status<ErrorDetails> Configure(PixelFormat pixel_format,
+                                 const VideoDimensions& dimensions,
+                                 const FrameLayout& layout);
+  // Fills |planes| with the slot to write the next frame into. Returns false
+  // if the ring isn't configured.
+  bool BeginWrite(void** planes);
+  // Publishes the frame written since BeginWrite() and wakes up readers.
+  void Publish(int64_t pts_us);
+
+  // Readers in other processes receive these via SCM_RIGHTS or
+  // /proc/<pid>/fd. They remain owned by the writer.
+  int memory_fd() const { return memory_fd_; }
+  int event_fd() const { return event_fd_; }
+
+  uint64_t frames_published() const { return sequence_; }
+
+ private:
+  SharedFrameRingWriter(int memory_fd, int event_fd, uint32_t slot_count);
+
+  int memory_fd_;
+  int event_fd_;
+  uint32_t slot_count_;
+  uint8_t* mapping_ = nullptr;
+  size_t mapped_size_ = 0;
+  uint64_t sequence_ = 0;
+  SharedFrameSlotHeader* writing_ = nullptr;
+
+  PixelFormat pixel_format_ = PixelFormat::kNone;
+  VideoDimensions dimensions_;
+  FrameLayout layout_;
+  std::array<uint64_t, kMaxPlanes> plane_offsets_{};
+
+  SharedFrameRingHeader* header() const {
+    return reinterpret_cast<SharedFrameRingHeader*>(mapping_);
+  }
+  SharedFrameSlotHeader* slot(uint64_t index) const;
+  Status<ErrorDetails> Resize(size_t size);
+};
+
+// A frame in the ring. The planes point into the shared mapping.
+struct SharedFrame {
+  uint64_t sequence = 0;
+  int64_t pts_us = -1;
+  PixelFormat pixel_format = PixelFormat::kNone;
+  VideoDimensions dimensions;
+  FrameLayout layout;
+  std::array<const uint8_t*, kMaxPlanes> planes{};
+};
+
+// Consumer side. Any number of readers may attach to a ring, but each
+// reader instance must only be used from a single thread.
+class SharedFrameRingReader final {
+ public:
+  // Takes ownership of the file descriptors. |event_fd| is optional.
+  static tl::expected<std::unique_ptr<SharedFrameRingReader>, ErrorDetails>
+  Open(int memory_fd, int event_fd = -1);
+  ~SharedFrameRingReader();
+
+  SharedFrameRingReader(const SharedFrameRingReader&) = delete;
+  SharedFrameRingReader& operator=(const SharedFrameRingReader&) = delete;
+
+  // Blocks until a frame newer than |sequence| is published. Returns false
+  // on timeout.
+  bool WaitForFrame(uint64_t sequence, std::chrono::milliseconds timeout);
+
+  // Returns the newest frame, if any. The planes are read in place and stay
+  // mapped until the next call, but the writer may overwrite them at any
+  // time. Check IsCurrent() after processing a frame to detect that.
+  std::optional<SharedFrame> AcquireLatest();
+  bool IsCurrent(const SharedFrame& frame) const;
+
+  uint64_t latest_sequence() const;
+
+  // Becomes readable whenever a frame got published, call ClearEvent()
+  // once it signaled. Returns -1 if there's no eventfd.
+  int event_fd() const { return event_fd_; }
+  void ClearEvent();
+
+ private:
+  SharedFrameRingReader(int memory_fd, int event_fd);
+
+  int memory_fd_;
+  int event_fd_;
+  uint8_t* mapping_ = nullptr;
+  size_t mapped_size_ = 0;
+  uint32_t generation_ = 0;
+
+  SharedFrameRingHeader* header() const {
+    return reinterpret_cast<SharedFrameRingHeader*>(mapping_);
+  }
+  Status<ErrorDetails> Map(size_t size);
+  // Returns nullptr if the header describes slots outside the mapping.
+  const SharedFrameSlotHeader* FindSlot(uint64_t sequence) const;
+};
+
+}  // namespace foxglove
@@ -0,0 +1,192 @@
+#include "video/tensor_export.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace foxglove {
+
+TensorExportDelegate::TensorExportDelegate(const TensorExportOptions& options,
+                                           std::shared_ptr<TensorRing> ring)
+    : options_(options), ring_(std::move(ring)) {}
+
+TensorExportStats TensorExportDelegate::stats() const {
+  TensorExportStats stats;
+  stats.tensors_published = tensors_published_;
+  stats.tensors_dropped = tensors_dropped_;
+  return stats;
+}
+
+std::optional<FrameBufferPoolOptions>
+TensorExportDelegate::frame_buffer_pool_options() const {
+  // Frames are processed right away, one being decoded and one being
+  // exported is enough.
+  FrameBufferPoolOptions pool_options;
+  pool_options.capacity = 2;
+  return pool_options;
+}
+
+void TensorExportDelegate::PresentFrame(std::shared_ptr<FrameBuffer> frame) {
+  const auto pixel_format = frame->pixel_format();
+  if (pixel_format != PixelFormat::kFormatRGBA &&
+      pixel_format != PixelFormat::kFormatBGRA) {
+    return;
+  }
+  const auto& dimensions = frame->dimensions();
+  if (pixel_format != pixel_format_ || dimensions.width != frame_width_ ||
+      dimensions.height != frame_height_) {
+    Configure(pixel_format, dimensions.width, dimensions.height);
+  }
+  if (content_rect_.is_empty()) {
+    return;
+  }
+
+  auto tensor =
+      ring_->BeginWrite(options_.data_type, options_.width, options_.height);
+  if (!tensor) {
+    tensors_dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  FillPadding(tensor.get());
+
+  const auto pitch = frame->pitch(0);
+  const auto* src = frame->plane(0) +
+                    static_cast<size_t>(source_rect_.y) * pitch +
+                    static_cast<size_t>(source_rect_.x) * 4;
+  const bool is_float = options_.data_type == TensorDataType::kFloat32;
+  const auto element_size = tensor->element_size();
+  for (uint32_t y = 0; y < content_rect_.height; y++) {
+    const uint8_t* row = src + static_cast<size_t>(y) * pitch;
+    if (scaler_) {
+      scaler_->ScaleRow(src, pitch, y, row_.data());
+      row = row_.data();
+    }
+
+    const auto offset =
+        (static_cast<size_t>(content_rect_.y + y) * options_.width +
+         content_rect_.x) *
+        element_size;
+    if (is_float) {
+      float* planes[3];
+      for (size_t c = 0; c < 3; c++) {
+        planes[c] = reinterpret_cast<float*>(
+            tensor->plane(channel_planes_[c]) + offset);
+      }
+      convert::PlanarizeRowFloat(row, planes, content_rect_.width,
+                                 scale_.data(), bias_.data());
+    } else {
+      uint8_t* planes[3];
+      for (size_t c = 0; c < 3; c++) {
+        planes[c] = tensor->plane(channel_planes_[c]) + offset;
+      }
+      convert::PlanarizeRow(row, planes, content_rect_.width);
+    }
+  }
+
+  tensor->set_timing(frame->timing());
+  ring_->Publish(std::move(tensor));
+  tensors_published_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TensorExportDelegate::Configure(PixelFormat pixel_format, uint32_t width,
+                                     uint32_t height) {
+  pixel_format_ = pixel_format;
+  frame_width_ = width;
+  frame_height_ = height;
+
+  // Bytes 0 to 2 of a pixel are R, G, B in RGBA frames and B, G, R in BGRA
+  // frames.
+  const bool is_reversed =
+      (pixel_format == PixelFormat::kFormatBGRA) != options_.bgr;
+  for (uint32_t c = 0; c < 3; c++) {
+    const auto plane = is_reversed ? 2 - c : c;
+    channel_planes_[c] = plane;
+    scale_[c] = 1.0f / (255.0f * options_.stddev[plane]);
+    bias_[c] = -options_.mean[plane] / options_.stddev[plane];
+  }
+
+  const uint32_t tensor_width = options_.width;
+  const uint32_t tensor_height = options_.height;
+  source_rect_ = {0, 0, width, height};
+  content_rect_ = {0, 0, tensor_width, tensor_height};
+  scaler_.reset();
+  if (width == 0 || height == 0 || tensor_width == 0 || tensor_height == 0) {
+    content_rect_ = {};
+    return;
+  }
+
+  const bool is_wider = static_cast<uint64_t>(width) * tensor_height >=
+                        static_cast<uint64_t>(height) * tensor_width;
+  switch (options_.resize_mode) {
+    case TensorResizeMode::kStretch:
+      break;
+    case TensorResizeMode::kLetterbox:
+      if (is_wider) {
+        content_rect_.height = static_cast<uint32_t>(std::max<uint64_t>(
+            1, static_cast<uint64_t>(height) * tensor_width / width));
+        content_rect_.y = (tensor_height - content_rect_.height) / 2;
+      } else {
+        content_rect_.width = static_cast<uint32_t>(std::max<uint64_t>(
+            1, static_cast<uint64_t>(width) * tensor_height / height));
+        content_rect_.x = (tensor_width - content_rect_.width) / 2;
+      }
+      break;
+    case TensorResizeMode::kCenterCrop:
+      if (is_wider) {
+        source_rect_.width = static_cast<uint32_t>(std::max<uint64_t>(
+            1, static_cast<uint64_t>(height) * tensor_width / tensor_height));
+        source_rect_.x = (width - source_rect_.width) / 2;
+      } else {
+        source_rect_.height = static_cast<uint32_t>(std::max<uint64_t>(
+            1, static_cast<uint64_t>(width) * tensor_height / tensor_width));
+        source_rect_.y = (height - source_rect_.height) / 2;
+      }
+      break;
+  }
+
+  if (source_rect_.width != content_rect_.width ||
+      source_rect_.height != content_rect_.height) {
+    scaler_ = std::make_unique<convert::RgbaScaler>(
+        source_rect_.width, source_rect_.height, content_rect_.width,
+        content_rect_.height);
+    row_.resize(static_cast<size_t>(content_rect_.width) * 4);
+  }
+}
+
+void TensorExportDelegate::FillPadding(Tensor* tensor) const {
+  const auto& rect = content_rect_;
+  const auto right = rect.x + rect.width;
+  const auto bottom = rect.y + rect.height;
+  FillRows(tensor, 0, rect.y, 0, options_.width);
+  FillRows(tensor, bottom, options_.height - bottom, 0, options_.width);
+  FillRows(tensor, rect.y, rect.height, 0, rect.x);
+  FillRows(tensor, rect.y, rect.height, right, options_.width - right);
+}
+
+void TensorExportDelegate::FillRows(Tensor* tensor, uint32_t y, uint32_t rows,
+                                    uint32_t x, uint32_t width) const {
+  if (rows == 0 || width == 0) {
+    return;
+  }
+  for (uint32_t plane = 0; plane < Tensor::kChannels; plane++) {
+    const auto first = static_cast<size_t>(y) * options_.width + x;
+    if (options_.data_type == TensorDataType::kUint8) {
+      for (uint32_t row = 0; row < rows; row++) {
+        memset(tensor->plane(plane) + first +
+                   static_cast<size_t>(row) * options_.width,
+               options_.pad_value, width);
+      }
+      continue;
+    }
+    const float value =
+        (options_.pad_value / 255.0f - options_.mean[plane]) /
+        options_.stddev[plane];
+    auto* data = reinterpret_cast<float*>(tensor->plane(plane)) + first;
+    for (uint32_t row = 0; row < rows; row++) {
+      auto* begin = data + static_cast<size_t>(row) * options_.width;
+      std::fill(begin, begin + width, value);
+    }
+  }
+}
+
+}  // namespace foxglove
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "video/convert/convert.h"
+#include "video/pixel_buffer_output.h"
+#include "video/tensor_ring.h"
+
+namespace foxglove {
+
+enum class TensorResizeMode {
+  // Scales to the tensor size, ignoring the aspect ratio.
+  kStretch,
+  // Scales to fit and pads the remaining area.
+  kLetterbox,
+  // Scales to fill and crops the excess around the frame's center.
+  kCenterCrop
+};
+
+struct TensorExportOptions {
+  uint32_t width = 224;
+  uint32_t height = 224;
+  TensorDataType data_type = TensorDataType::kFloat32;
+  TensorResizeMode resize_mode = TensorResizeMode::kLetterbox;
+  // Orders the channel planes B, G, R instead of R, G, B.
+  bool bgr = false;
+  // Per channel in tensor order. Float tensors hold
+  // (value / 255 - mean) / stddev, uint8 tensors the plain values.
+  std::array<float, 3> mean = {0, 0, 0};
+  std::array<float, 3> stddev = {1, 1, 1};
+  // Value of the letterbox bars before normalization.
+  uint8_t pad_value = 0;
+};
+
+struct TensorExportStats {
+  uint64_t tensors_published = 0;
+  // Frames skipped because consumers held all tensors of the ring.
+  uint64_t tensors_dropped = 0;
+};
+
+// Turns RGBA or BGRA frames into NCHW tensors for inference. Resizing,
+// cropping or letterboxing, normalization and the split into channel planes
+// happen in a single pass over the tensor, one row at a time, so no
+// intermediate picture is ever written. Tensors get published to a
+// TensorRing and are computed on the vout thread.
+class TensorExportDelegate : public PooledPixelBufferOutputDelegate {
+ public:
+  TensorExportDelegate(const TensorExportOptions& options,
+                       std::shared_ptr<TensorRing> ring);
+
+  TensorRing* ring() const { return ring_.get(); }
+  TensorExportStats stats() const;
+
+  std::optional<FrameBufferPoolOptions> frame_buffer_pool_options()
+      const override;
+  void PresentFrame(std::shared_ptr<FrameBuffer> frame) override;
+
+ private:
+  TensorExportOptions options_;
+  std::shared_ptr<TensorRing> ring_;
+
+  // Only accessed by the vout thread. Indexed by the byte of the frame's
+  // pixels, which get mapped to the tensor's channel order.
+  PixelFormat pixel_format_ = PixelFormat::kNone;
+  std::array<uint32_t, 3> channel_planes_{};
+  std::array<float, 3> scale_{};
+  std::array<float, 3> bias_{};
+  // Size of the frames the geometry below was computed for.
+  uint32_t frame_width_ = 0;
+  uint32_t frame_height_ = 0;
+  // The part of the frame that gets scaled into |content_rect_| of the
+  // tensor.
+  VideoRect source_rect_;
+  VideoRect content_rect_;
+  std::unique_ptr<convert::RgbaScaler> scaler_;
+  std::vector<uint8_t> row_;
+
+  std::atomic<uint64_t> tensors_published_ = 0;
+  std::atomic<uint64_t> tensors_dropped_ = 0;
+
+  void Configure(PixelFormat pixel_format, uint32_t width, uint32_t height);
+  void FillPadding(Tensor* tensor) const;
+  void FillRows(Tensor* tensor, uint32_t y, uint32_t rows, uint32_t x,
+                uint32_t width) const;
+};
+
+}  // namespace foxglove
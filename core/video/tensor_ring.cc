@@ -0,0 +1,87 @@
+#include "video/tensor_ring.h"
+
+#include <atomic>
+#include <cassert>
+#include <utility>
+
+namespace foxglove {
+
+Tensor::Tensor(TensorDataType data_type, uint32_t width, uint32_t height)
+    : data_type_(data_type),
+      width_(width),
+      height_(height),
+      memory_(byte_size()) {}
+
+TensorRing::TensorRing(size_t capacity) : capacity_(capacity) {
+  // One tensor being written plus the newest one.
+  assert(capacity_ >= 2);
+  tensors_.reserve(capacity_);
+}
+
+std::shared_ptr<Tensor> TensorRing::BeginWrite(TensorDataType data_type,
+                                               uint32_t width,
+                                               uint32_t height) {
+  if (!tensors_.empty()) {
+    const auto& tensor = tensors_.front();
+    if (tensor->data_type() != data_type || tensor->width() != width ||
+        tensor->height() != height) {
+      // Tensors still referenced elsewhere are freed along with their last
+      // reference.
+      tensors_.clear();
+      next_index_ = 0;
+    }
+  }
+
+  const auto count = tensors_.size();
+  for (size_t i = 0; i < count; i++) {
+    const auto index = (next_index_ + i) % count;
+    const auto& tensor = tensors_[index];
+    // Consumers can only add references to the newest tensor, which is
+    // also referenced by |latest_|.
+    if (tensor.use_count() == 1) {
+      // Pairs with the release of the consumer's last reference.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      next_index_ = (index + 1) % count;
+      return tensor;
+    }
+  }
+
+  if (count >= capacity_ || width == 0 || height == 0) {
+    return nullptr;
+  }
+  auto tensor = std::make_shared<Tensor>(data_type, width, height);
+  if (!tensor->is_valid()) {
+    return nullptr;
+  }
+  tensors_.push_back(tensor);
+  next_index_ = 0;
+  return tensor;
+}
+
+void TensorRing::Publish(std::shared_ptr<Tensor> tensor) {
+  tensor->set_sequence(++sequence_);
+  std::shared_ptr<Tensor> previous;
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    previous = std::exchange(latest_, std::move(tensor));
+  }
+  cv_.notify_all();
+}
+
+std::shared_ptr<const Tensor> TensorRing::AcquireLatest() const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return latest_;
+}
+
+std::shared_ptr<const Tensor> TensorRing::WaitForNewer(
+    uint64_t sequence, std::chrono::milliseconds timeout) const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!cv_.wait_for(lock, timeout, [this, sequence] {
+        return latest_ && latest_->sequence() > sequence;
+      })) {
+    return nullptr;
+  }
+  return latest_;
+}
+
+}  // namespace foxglove
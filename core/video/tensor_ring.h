@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "base/aligned_memory.h"
+#include "video/frame_descriptor.h"
+
+namespace foxglove {
+
+enum class TensorDataType { kUint8, kFloat32 };
+
+// A 1x3xHxW tensor, each channel plane holding height * width elements. The
+// planes start at AlignedMemory::kDefaultAlignment boundaries if their size
+// allows.
+class Tensor final {
+ public:
+  static constexpr uint32_t kChannels = 3;
+
+  Tensor(TensorDataType data_type, uint32_t width, uint32_t height);
+
+  Tensor(const Tensor&) = delete;
+  Tensor& operator=(const Tensor&) = delete;
+
+  bool is_valid() const { return static_cast<bool>(memory_); }
+
+  TensorDataType data_type() const { return data_type_; }
+  uint32_t width() const { return width_; }
+  uint32_t height() const { return height_; }
+  size_t element_size() const {
+    return data_type_ == TensorDataType::kFloat32 ? sizeof(float) : 1;
+  }
+  size_t plane_size() const {
+    return static_cast<size_t>(width_) * height_ * element_size();
+  }
+  // All planes, back to back.
+  uint8_t* data() const { return memory_.data(); }
+  size_t byte_size() const { return plane_size() * kChannels; }
+  uint8_t* plane(size_t channel) const {
+    return memory_.data() + channel * plane_size();
+  }
+
+  // Assigned by the ring, increases by one per published tensor.
+  uint64_t sequence() const { return sequence_; }
+  void set_sequence(uint64_t sequence) { sequence_ = sequence; }
+  // Timing of the frame the tensor was computed from.
+  const FrameTiming& timing() const { return timing_; }
+  void set_timing(const FrameTiming& timing) { timing_ = timing; }
+
+ private:
+  TensorDataType data_type_;
+  uint32_t width_;
+  uint32_t height_;
+  AlignedMemory memory_;
+  uint64_t sequence_ = 0;
+  FrameTiming timing_;
+};
+
+// A small ring of preallocated tensors that always hands out the newest one.
+// Consumers may hold on to tensors on any thread, a tensor gets reused once
+// all references have been dropped and a newer one got published.
+class TensorRing final {
+ public:
+  // Allocates up to |capacity| tensors, one of which is always being
+  // written while the newest one stays available to consumers.
+  explicit TensorRing(size_t capacity = 3);
+
+  TensorRing(const TensorRing&) = delete;
+  TensorRing& operator=(const TensorRing&) = delete;
+
+  // Producer side. Must be called from a single thread.
+  // Returns a tensor of the given shape to write into, or nullptr if
+  // consumers hold all of them. Discards tensors of other shapes.
+  std::shared_ptr<Tensor> BeginWrite(TensorDataType data_type, uint32_t width,
+                                     uint32_t height);
+  // Makes |tensor| the newest one and assigns its sequence number.
+  void Publish(std::shared_ptr<Tensor> tensor);
+
+  // Consumer side. May be called from any thread.
+  // Returns the newest tensor, or nullptr if there's none yet.
+  std::shared_ptr<const Tensor> AcquireLatest() const;
+  // Waits for a tensor with a sequence number above |sequence|. Returns
+  // nullptr on timeout.
+  std::shared_ptr<const Tensor> WaitForNewer(
+      uint64_t sequence, std::chrono::milliseconds timeout) const;
+
+ private:
+  size_t capacity_;
+  // Only accessed by the producer.
+  std::vector<std::shared_ptr<Tensor>> tensors_;
+  size_t next_index_ = 0;
+  uint64_t sequence_ = 0;
+
+  mutable std::mutex mutex_;
+  mutable std::condition_variable cv_;
+  std::shared_ptr<Tensor> latest_;
+};
+
+}  // namespace foxglove
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+
 namespace foxglove {
 
 struct VideoDimensions {
@@ -21,4 +24,31 @@ struct VideoDimensions {
   }
 };
 
+// A rectangle in pixels.
+struct VideoRect {
+  uint32_t x = 0;
+  uint32_t y = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+
+  bool is_empty() const { return width == 0 || height == 0; }
+
+  // Returns the part that lies within a |bounds_width| x |bounds_height|
+  // picture.
+  VideoRect ClippedTo(uint32_t bounds_width, uint32_t bounds_height) const {
+    VideoRect clipped;
+    clipped.x = std::min(x, bounds_width);
+    clipped.y = std::min(y, bounds_height);
+    clipped.width = std::min(width, bounds_width - clipped.x);
+    clipped.height = std::min(height, bounds_height - clipped.y);
+    return clipped;
+  }
+
+  bool operator==(const VideoRect& other) const {
+    return x == other.x && y == other.y && width == other.width &&
+           height == other.height;
+  }
+  bool operator!=(const VideoRect& other) const { return !operator==(other); }
+};
+
 }  // namespace foxglove
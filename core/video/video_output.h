@@ -1,13 +1,14 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 
+#include "video/frame_analyzer.h"
+#include "video/pixel_format.h"
 #include "video/video_dimensions.h"
 
 namespace foxglove {
 
-enum class PixelFormat { kNone = 0, kFormatRGBA, kFormatBGRA };
-
 typedef std::function<void(const VideoDimensions& dimensions)>
     VideoDimensionsCallback;
 
@@ -23,6 +24,41 @@ class VideoOutput {
       VideoDimensionsCallback dimensions_callback) = 0;
   virtual const VideoDimensions& dimensions() const = 0;
   virtual VideoOutputDelegate* output_delegate() const = 0;
+
+  // Limits delivered frames to |max_width| x |max_height| while keeping the
+  // aspect ratio. Frames are never upscaled and 0 means unlimited. Takes
+  // effect on the next format negotiation, e.g. when new media is opened.
+  // Returns false if the output doesn't support scaling.
+  virtual bool SetMaxOutputSize(uint32_t /*max_width*/,
+                                uint32_t /*max_height*/) {
+    return false;
+  }
+
+  // Delivers only |rect| of every frame, in coordinates of the decoded
+  // video. An empty rect shows the whole frame. The max output size applies
+  // to the crop that's set when the format gets negotiated, so set it
+  // before playback starts. Later changes take effect on the next frame but
+  // keep the current scale, so the delivered size may differ from the max
+  // output size until the next negotiation. Returns false if the output
+  // doesn't support cropping.
+  virtual bool SetCropRect(const VideoRect& /*rect*/) { return false; }
+
+  // Drops frames so that at most |max_fps| frames per second of media time
+  // get delivered, 0 means unlimited. Can be changed at any time. Returns
+  // false if the output doesn't support it.
+  virtual bool SetMaxFrameRate(double /*max_fps*/) { return false; }
+
+  // Runs |analyzer| on every decoded picture that isn't decimated. May be
+  // called from any thread. Returns false if the output doesn't support
+  // analysis.
+  virtual bool AddFrameAnalyzer(std::shared_ptr<FrameAnalyzer> /*analyzer*/) {
+    return false;
+  }
+  // Waits for a running analysis to finish. Returns false if |analyzer|
+  // wasn't added.
+  virtual bool RemoveFrameAnalyzer(const FrameAnalyzer* /*analyzer*/) {
+    return false;
+  }
 };
 
 }  // namespace foxglove
@@ -6,6 +6,10 @@
 #include "video/d3d11_output.h"
 #endif
 
+#ifdef __linux__
+#include "video/shared_frame_ring.h"
+#endif
+
 #include "video/pixel_buffer_output.h"
 
 namespace foxglove {
@@ -17,11 +21,21 @@ class VideoOutputFactory {
       std::unique_ptr<PixelBufferOutputDelegate> output_delegate,
       PixelFormat pixel_format) const = 0;
 
+  // Discards all frames, for checking real time decoding performance.
+  virtual std::unique_ptr<T> CreateNullOutput(
+      PixelFormat pixel_format = PixelFormat::kNone) const = 0;
+
 #ifdef _WIN32
   virtual std::unique_ptr<T> CreateD3D11Output(
       std::unique_ptr<D3D11OutputDelegate> output_delegate,
       winrt::com_ptr<IDXGIAdapter> adapter = nullptr) const = 0;
 #endif
+
+#ifdef __linux__
+  virtual std::unique_ptr<T> CreateSharedMemoryOutput(
+      std::shared_ptr<SharedFrameRingWriter> ring,
+      PixelFormat pixel_format) const = 0;
+#endif
 };
 
 }  // namespace foxglove
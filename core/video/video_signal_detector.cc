@@ -0,0 +1,85 @@
+#include "video/video_signal_detector.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace foxglove {
+
+VideoSignalDetector::VideoSignalDetector(
+    const VideoSignalDetectorOptions& options,
+    VideoSignalEventCallback callback)
+    : options_(options),
+      callback_(std::move(callback)),
+      black_{VideoSignalCondition::kBlack, options.black_duration_ms * 1000},
+      frozen_{VideoSignalCondition::kFrozen,
+              options.frozen_duration_ms * 1000} {}
+
+std::optional<LumaStatistics> VideoSignalDetector::statistics() const {
+  const std::lock_guard<std::mutex> lock(statistics_mutex_);
+  return statistics_;
+}
+
+void VideoSignalDetector::Analyze(const FrameDescriptor& frame,
+                                  const uint8_t* const* planes) {
+  const auto interval = std::max<uint32_t>(options_.frame_interval, 1);
+  if (frame_count_++ % interval != 0) {
+    return;
+  }
+
+  LumaStatistics statistics;
+  if (!ComputeLumaStatistics(frame, planes, options_.row_step,
+                             &statistics) ||
+      statistics.pixel_count == 0) {
+    return;
+  }
+
+  uint64_t black_pixels = 0;
+  // Includes the bin the threshold falls into.
+  const size_t black_bins = options_.black_luma_threshold / 4 + 1;
+  for (size_t i = 0; i < black_bins; i++) {
+    black_pixels += statistics.histogram[i];
+  }
+  const bool is_black = black_pixels >= options_.black_pixel_ratio *
+                                            statistics.pixel_count;
+
+  std::optional<LumaStatistics> previous;
+  {
+    const std::lock_guard<std::mutex> lock(statistics_mutex_);
+    previous = std::exchange(statistics_, statistics);
+  }
+  const bool is_unchanged =
+      previous && HistogramDistance(*previous, statistics) <=
+                      options_.frozen_distance_threshold;
+
+  const auto now_us = MonotonicTimeUs();
+  Update(&black_, is_black, now_us, frame.timing.pts_us);
+  // A black picture doesn't change either, report it as black only.
+  Update(&frozen_, is_unchanged && !is_black, now_us, frame.timing.pts_us);
+}
+
+void VideoSignalDetector::Update(Condition* condition, bool holds,
+                                 int64_t now_us, int64_t pts_us) {
+  VideoSignalEvent event;
+  event.condition = condition->type;
+  event.pts_us = pts_us;
+  if (!holds) {
+    condition->since_us = -1;
+    if (condition->is_active) {
+      condition->is_active = false;
+      callback_(event);
+    }
+    return;
+  }
+
+  if (condition->since_us < 0) {
+    condition->since_us = now_us;
+  }
+  if (!condition->is_active &&
+      now_us - condition->since_us >= condition->duration_us) {
+    condition->is_active = true;
+    event.is_active = true;
+    callback_(event);
+  }
+}
+
+}  // namespace foxglove
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+
+#include "events.h"
+#include "video/frame_analyzer.h"
+#include "video/luma_statistics.h"
+
+namespace foxglove {
+
+struct VideoSignalDetectorOptions {
+  // Only every nth frame gets analyzed.
+  uint32_t frame_interval = 5;
+  // Only every nth row of an analyzed frame gets sampled.
+  uint32_t row_step = 2;
+  // Pixels up to this luma count as black, rounded up to the histogram's
+  // bins of 4 levels. Limited range video is black at 16.
+  uint8_t black_luma_threshold = 32;
+  // Share of black pixels at or above which a frame is black.
+  double black_pixel_ratio = 0.98;
+  // How long frames have to be black to raise the condition.
+  int64_t black_duration_ms = 2000;
+  // Histogram distance to the previous analyzed frame up to which a frame
+  // counts as unchanged. Noise-free static scenes may count as frozen too.
+  double frozen_distance_threshold = 0.002;
+  // How long frames have to be unchanged to raise the condition.
+  int64_t frozen_duration_ms = 5000;
+};
+
+typedef std::function<void(const VideoSignalEvent& event)>
+    VideoSignalEventCallback;
+
+// Raises events when the video turns black or freezes, based on the luma
+// statistics of sampled frames. Durations are measured in wall time, so a
+// stream that stops delivering frames altogether isn't detected.
+class VideoSignalDetector : public FrameAnalyzer {
+ public:
+  // |callback| runs on the vout thread.
+  VideoSignalDetector(const VideoSignalDetectorOptions& options,
+                      VideoSignalEventCallback callback);
+
+  // Returns the statistics of the last analyzed frame. May be called from
+  // any thread.
+  std::optional<LumaStatistics> statistics() const;
+
+  void Analyze(const FrameDescriptor& frame,
+               const uint8_t* const* planes) override;
+
+ private:
+  struct Condition {
+    VideoSignalCondition type;
+    int64_t duration_us;
+    // When the condition started to hold, -1 if it doesn't.
+    int64_t since_us = -1;
+    bool is_active = false;
+  };
+
+  VideoSignalDetectorOptions options_;
+  VideoSignalEventCallback callback_;
+  uint64_t frame_count_ = 0;
+  Condition black_;
+  Condition frozen_;
+
+  mutable std::mutex statistics_mutex_;
+  std::optional<LumaStatistics> statistics_;
+
+  void Update(Condition* condition, bool holds, int64_t now_us,
+              int64_t pts_us);
+};
+
+}  // namespace foxglove
@@ -0,0 +1,231 @@
+#include "vlc/vlc_audio_analysis.h"
+
+#include <vlc/vlc.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "audio/loudness_meter.h"
+#include "audio/waveform.h"
+#include "base/logging.h"
+
+namespace foxglove {
+
+namespace {
+
+// State shared with VLC's audio thread while a file gets decoded.
+struct DecodeJob {
+  explicit DecodeJob(const AudioAnalysisOptions& options) : options(options) {}
+
+  const AudioAnalysisOptions& options;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool is_finished = false;
+  bool has_error = false;
+
+  // Only accessed by the audio thread until the player is released.
+  uint32_t sample_rate = 0;
+  uint32_t channels = 0;
+  uint64_t frame_count = 0;
+  std::optional<WaveformBuilder> waveform;
+  std::optional<LoudnessMeter> loudness;
+
+  int Setup(char* format, unsigned* rate, unsigned* channel_count) {
+    if (sample_rate == 0) {
+      sample_rate = *rate;
+      // BS.1770 weights surround channels differently and their order
+      // isn't known here, so anything but mono gets downmixed to stereo.
+      channels = *channel_count == 1 ? 1 : 2;
+      waveform.emplace(channels, options.frames_per_bucket);
+      loudness.emplace(sample_rate, channels);
+    }
+    memcpy(format, "FL32", 4);
+    *channel_count = channels;
+    // Asking for the sped up rate lets VLC pass samples through unchanged
+    // rather than resampling them to play faster.
+    *rate = sample_rate * options.playback_rate;
+    return 0;
+  }
+
+  void OnPlay(const void* samples, unsigned count) {
+    const auto* frames = static_cast<const float*>(samples);
+    frame_count += count;
+    waveform->Add(frames, count);
+    loudness->Add(frames, count);
+  }
+
+  void Finish(bool is_error) {
+    {
+      const std::lock_guard<std::mutex> lock(mutex);
+      is_finished = true;
+      has_error = has_error || is_error;
+    }
+    cv.notify_one();
+  }
+};
+
+std::optional<int64_t> ModificationTime(const std::string& path) {
+  std::error_code ec;
+  const auto time =
+      std::filesystem::last_write_time(std::filesystem::u8path(path), ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  return static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+}  // namespace
+
+tl::expected<std::unique_ptr<VlcAudioAnalysisService>, ErrorDetails>
+VlcAudioAnalysisService::Create(const AudioAnalysisOptions& options) {
+  // Muted audio would be analyzed, and cached, as silence.
+  if (options.playback_rate < 1 ||
+      options.playback_rate > kMaxAnalysisPlaybackRate) {
+    return tl::make_unexpected(ErrorDetails(
+        "Unsupported analysis playback rate", options.playback_rate));
+  }
+  const char* const arguments[] = {"--no-video", "--no-audio-time-stretch"};
+  auto instance = std::make_unique<VlcInstance>(
+      static_cast<int>(std::size(arguments)), arguments);
+  if (!instance->isValid()) {
+    return tl::make_unexpected(ErrorDetails("Creating libvlc instance failed"));
+  }
+  return std::unique_ptr<VlcAudioAnalysisService>(
+      new VlcAudioAnalysisService(options, std::move(instance)));
+}
+
+VlcAudioAnalysisService::VlcAudioAnalysisService(
+    const AudioAnalysisOptions& options, std::unique_ptr<VlcInstance> instance)
+    : options_(options), instance_(std::move(instance)) {
+  if (options_.cache_directory) {
+    cache_.emplace(*options_.cache_directory);
+  }
+  auto worker_count = options_.max_workers;
+  if (worker_count == 0) {
+    worker_count = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  workers_ = std::make_unique<TaskQueue>(worker_count, "audio-analysis");
+}
+
+VlcAudioAnalysisService::~VlcAudioAnalysisService() {
+  is_shutting_down_ = true;
+  workers_.reset();
+}
+
+void VlcAudioAnalysisService::Analyze(const std::string& path,
+                                      AudioAnalysisCallback callback) {
+  workers_->Enqueue([this, path, callback = std::move(callback)] {
+    const auto result = Run(path);
+    if (!is_shutting_down_) {
+      callback(path, result);
+    }
+  });
+}
+
+AudioAnalysisResult VlcAudioAnalysisService::Run(const std::string& path) {
+  const auto mtime = ModificationTime(path);
+  if (!mtime) {
+    return tl::make_unexpected(ErrorDetails("File not found"));
+  }
+  if (cache_) {
+    if (auto analysis = cache_->Load(path, *mtime)) {
+      return analysis;
+    }
+  }
+
+  auto result = Decode(path);
+  if (result && cache_) {
+    auto status = cache_->Store(path, *mtime, **result);
+    if (!status.ok()) {
+      LOG(ERROR) << "Caching audio analysis failed: "
+                 << status.error().ToString() << std::endl;
+    }
+  }
+  return result;
+}
+
+AudioAnalysisResult VlcAudioAnalysisService::Decode(const std::string& path) {
+  auto* media = libvlc_media_new_path(path.c_str());
+  if (!media) {
+    return tl::make_unexpected(ErrorDetails("Creating media failed"));
+  }
+  libvlc_media_add_option(media, ":no-video");
+  libvlc_media_add_option(media, ":no-spu");
+  auto* player = libvlc_media_player_new_from_media(instance_->get(), media);
+  libvlc_media_release(media);
+  if (!player) {
+    return tl::make_unexpected(ErrorDetails("Creating player failed"));
+  }
+
+  DecodeJob job(options_);
+  libvlc_audio_set_callbacks(
+      player,
+      [](void* opaque, const void* samples, unsigned count, int64_t) {
+        reinterpret_cast<DecodeJob*>(opaque)->OnPlay(samples, count);
+      },
+      nullptr, nullptr, nullptr, nullptr, &job);
+  libvlc_audio_set_format_callbacks(
+      player,
+      [](void** opaque, char* format, unsigned* rate,
+         unsigned* channels) -> int {
+        return reinterpret_cast<DecodeJob*>(*opaque)->Setup(format, rate,
+                                                           channels);
+      },
+      nullptr);
+
+  auto* event_manager = libvlc_media_player_event_manager(player);
+  libvlc_event_attach(
+      event_manager, libvlc_MediaPlayerStopping,
+      [](const libvlc_event_t*, void* opaque) {
+        reinterpret_cast<DecodeJob*>(opaque)->Finish(false);
+      },
+      &job);
+  libvlc_event_attach(
+      event_manager, libvlc_MediaPlayerEncounteredError,
+      [](const libvlc_event_t*, void* opaque) {
+        reinterpret_cast<DecodeJob*>(opaque)->Finish(true);
+      },
+      &job);
+
+  libvlc_media_player_set_rate(player,
+                               static_cast<float>(options_.playback_rate));
+  if (libvlc_media_player_play(player) != 0) {
+    job.Finish(true);
+  }
+  {
+    std::unique_lock<std::mutex> lock(job.mutex);
+    while (!job.is_finished && !is_shutting_down_) {
+      job.cv.wait_for(lock, std::chrono::milliseconds(100));
+    }
+  }
+  libvlc_media_player_stop_async(player);
+  // Joins VLC's threads, so the job isn't touched anymore afterwards.
+  libvlc_media_player_release(player);
+
+  if (is_shutting_down_) {
+    return tl::make_unexpected(ErrorDetails("Analysis cancelled"));
+  }
+  if (job.has_error) {
+    return tl::make_unexpected(ErrorDetails("Decoding failed"));
+  }
+  if (job.sample_rate == 0) {
+    return tl::make_unexpected(ErrorDetails("No audio track"));
+  }
+
+  auto analysis = std::make_shared<AudioAnalysis>();
+  analysis->sample_rate = job.sample_rate;
+  analysis->channels = job.channels;
+  analysis->frame_count = job.frame_count;
+  analysis->integrated_loudness = job.loudness->IntegratedLoudness();
+  analysis->waveform = job.waveform->Finish(options_.waveform_levels);
+  return analysis;
+}
+
+}  // namespace foxglove
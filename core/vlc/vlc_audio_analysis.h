@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "audio/audio_analysis.h"
+#include "base/error_details.h"
+#include "base/task_queue.h"
+#include "third_party/expected.h"
+#include "vlc/vlc_environment.h"
+
+namespace foxglove {
+
+// VLC mutes audio when playing faster than this.
+constexpr uint32_t kMaxAnalysisPlaybackRate = 4;
+
+struct AudioAnalysisOptions {
+  // Files analyzed at once, each by its own player. 0 uses one per core.
+  size_t max_workers = 0;
+  // Results are cached here if set.
+  std::optional<std::string> cache_directory;
+  // Resolution of the finest waveform level, and the number of levels.
+  uint32_t frames_per_bucket = 256;
+  uint32_t waveform_levels = 8;
+  // Speed at which files are decoded, 1 to kMaxAnalysisPlaybackRate.
+  uint32_t playback_rate = kMaxAnalysisPlaybackRate;
+};
+
+typedef tl::expected<std::shared_ptr<const AudioAnalysis>, ErrorDetails>
+    AudioAnalysisResult;
+typedef std::function<void(const std::string& path,
+                           const AudioAnalysisResult& result)>
+    AudioAnalysisCallback;
+
+// Computes waveform overviews and loudness of media files ahead of
+// playback. Every file gets decoded by a dedicated player without video on
+// a bounded pool of workers, audio being delivered through callbacks
+// instead of a sound device. Uses its own libvlc instance, so analysis
+// never shows up in the playback environment.
+class VlcAudioAnalysisService final {
+ public:
+  static tl::expected<std::unique_ptr<VlcAudioAnalysisService>, ErrorDetails>
+  Create(const AudioAnalysisOptions& options = {});
+  // Cancels running jobs, queued ones are dropped without a callback.
+  ~VlcAudioAnalysisService();
+
+  VlcAudioAnalysisService(const VlcAudioAnalysisService&) = delete;
+  VlcAudioAnalysisService& operator=(const VlcAudioAnalysisService&) =
+      delete;
+
+  // Queues |path| (UTF-8) for analysis, unless it's cached already.
+  // |callback| runs on a worker thread.
+  void Analyze(const std::string& path, AudioAnalysisCallback callback);
+
+ private:
+  AudioAnalysisOptions options_;
+  std::unique_ptr<VlcInstance> instance_;
+  std::optional<AudioAnalysisCache> cache_;
+  std::atomic<bool> is_shutting_down_ = false;
+  // Destroyed first, which joins the workers.
+  std::unique_ptr<TaskQueue> workers_;
+
+  VlcAudioAnalysisService(const AudioAnalysisOptions& options,
+                          std::unique_ptr<VlcInstance> instance);
+
+  AudioAnalysisResult Run(const std::string& path);
+  AudioAnalysisResult Decode(const std::string& path);
+};
+
+}  // namespace foxglove
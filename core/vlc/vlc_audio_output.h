@@ -0,0 +1,18 @@
+#pragma once
+
+#include "audio/audio_output.h"
+#include "base/error_details.h"
+#include "base/status.h"
+
+struct libvlc_media_player_t;
+
+namespace foxglove {
+
+class VlcAudioOutput : public AudioOutput {
+ public:
+  // Takes effect when the player (re)creates its audio output, e.g. when
+  // new media is opened.
+  virtual Status<ErrorDetails> Attach(libvlc_media_player_t* player) = 0;
+};
+
+}  // namespace foxglove
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstring>
+
+#include "video/pixel_format.h"
+
+namespace foxglove {
+
+// Returns the VLC fourcc used to request |format| from the decoder.
+inline const char* ToVlcChroma(PixelFormat format) {
+  switch (format) {
+    case PixelFormat::kFormatBGRA:
+      return "BGRA";
+    case PixelFormat::kFormatI420:
+      return "I420";
+    case PixelFormat::kFormatNV12:
+      return "NV12";
+    default:
+      return "RGBA";
+  }
+}
+
+// Returns kNone if |chroma| doesn't map to a supported format.
+inline PixelFormat FromVlcChroma(const char* chroma) {
+  for (auto format : {PixelFormat::kFormatRGBA, PixelFormat::kFormatBGRA,
+                      PixelFormat::kFormatI420, PixelFormat::kFormatNV12}) {
+    if (strncmp(chroma, ToVlcChroma(format), 4) == 0) {
+      return format;
+    }
+  }
+  return PixelFormat::kNone;
+}
+
+}  // namespace foxglove
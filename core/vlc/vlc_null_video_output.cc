@@ -0,0 +1,162 @@
+#include "vlc/vlc_null_video_output.h"
+
+#include <vlc/vlc.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "vlc/vlc_chroma.h"
+
+namespace foxglove {
+
+namespace {
+
+void UpdateMin(std::atomic<int64_t>& target, int64_t value) {
+  auto current = target.load(std::memory_order_relaxed);
+  while (value < current &&
+         !target.compare_exchange_weak(current, value,
+                                       std::memory_order_relaxed)) {
+  }
+}
+
+void UpdateMax(std::atomic<int64_t>& target, int64_t value) {
+  auto current = target.load(std::memory_order_relaxed);
+  while (value > current &&
+         !target.compare_exchange_weak(current, value,
+                                       std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+VlcNullVideoOutput::VlcNullVideoOutput(PixelFormat pixel_format)
+    : pixel_format_(pixel_format) {}
+
+Status<ErrorDetails> VlcNullVideoOutput::Attach(libvlc_media_player_t* player) {
+  player_ = player;
+
+  libvlc_video_set_callbacks(
+      player,
+      [](void* opaque, void** planes) -> void* {
+        auto instance = reinterpret_cast<VlcNullVideoOutput*>(opaque);
+        return instance->OnVideoLock(planes);
+      },
+      nullptr,
+      [](void* opaque, void* picture) {
+        auto instance = reinterpret_cast<VlcNullVideoOutput*>(opaque);
+        instance->OnVideoPicture(picture);
+      },
+      this);
+
+  libvlc_video_set_format_callbacks(
+      player,
+      [](void** opaque, char* chroma, unsigned* width, unsigned* height,
+         unsigned* pitches, unsigned* lines) -> unsigned {
+        auto instance = reinterpret_cast<VlcNullVideoOutput*>(*opaque);
+        if (instance != nullptr) {
+          return instance->Setup(chroma, width, height, pitches, lines);
+        }
+        return 0;
+      },
+      nullptr);
+
+  return OkStatus();
+}
+
+unsigned VlcNullVideoOutput::Setup(char* chroma, unsigned* width,
+                                   unsigned* height, unsigned* pitches,
+                                   unsigned* lines) {
+  auto format = pixel_format_;
+  if (format == PixelFormat::kNone) {
+    format = FromVlcChroma(chroma);
+    if (format == PixelFormat::kNone) {
+      format = PixelFormat::kFormatRGBA;
+    }
+  }
+  memcpy(chroma, ToVlcChroma(format), 4);
+
+  const auto layout = ComputeFrameLayout(format, *width, *height);
+  VideoDimensions dimensions(*width, *height, layout.pitches[0]);
+  if (!scratch_buffer_ || scratch_buffer_->pixel_format() != format ||
+      scratch_buffer_->layout() != layout) {
+    scratch_buffer_ = std::make_unique<FrameBuffer>(format, dimensions, layout);
+    if (!scratch_buffer_->is_valid()) {
+      scratch_buffer_.reset();
+      return 0;
+    }
+  }
+
+  for (uint32_t i = 0; i < layout.plane_count; i++) {
+    pitches[i] = layout.pitches[i];
+    lines[i] = layout.lines[i];
+  }
+
+  SetDimensions(std::move(dimensions));
+  return 1;
+}
+
+void* VlcNullVideoOutput::OnVideoLock(void** planes) {
+  locked_at_us_ = MonotonicTimeUs();
+  scratch_buffer_->GetPlanes(planes);
+  return nullptr;
+}
+
+void VlcNullVideoOutput::OnVideoPicture(void* /*picture*/) {
+  const auto now = MonotonicTimeUs();
+  const auto lock_to_display = now - locked_at_us_;
+
+  int64_t unset = 0;
+  first_presented_at_us_.compare_exchange_strong(unset, now,
+                                                 std::memory_order_relaxed);
+  last_presented_at_us_.store(now, std::memory_order_relaxed);
+  total_lock_to_display_us_.fetch_add(lock_to_display,
+                                      std::memory_order_relaxed);
+  UpdateMin(min_lock_to_display_us_, lock_to_display);
+  UpdateMax(max_lock_to_display_us_, lock_to_display);
+  frames_presented_.fetch_add(1, std::memory_order_release);
+}
+
+NullVideoOutputStats VlcNullVideoOutput::stats() const {
+  NullVideoOutputStats stats;
+  stats.frames_presented = frames_presented_.load(std::memory_order_acquire);
+  if (stats.frames_presented > 0) {
+    const auto duration_us =
+        last_presented_at_us_.load(std::memory_order_relaxed) -
+        first_presented_at_us_.load(std::memory_order_relaxed);
+    if (stats.frames_presented > 1 && duration_us > 0) {
+      stats.presented_frames_per_second =
+          (stats.frames_presented - 1) * 1000000.0 / duration_us;
+    }
+    stats.min_lock_to_display_us =
+        min_lock_to_display_us_.load(std::memory_order_relaxed);
+    stats.max_lock_to_display_us =
+        max_lock_to_display_us_.load(std::memory_order_relaxed);
+    stats.average_lock_to_display_us =
+        total_lock_to_display_us_.load(std::memory_order_relaxed) /
+        static_cast<int64_t>(stats.frames_presented);
+  }
+
+  if (player_) {
+    if (auto media = libvlc_media_player_get_media(player_)) {
+      libvlc_media_stats_t media_stats;
+      if (libvlc_media_get_stats(media, &media_stats)) {
+        stats.frames_late = media_stats.i_late_pictures;
+        stats.frames_dropped = media_stats.i_lost_pictures;
+      }
+      libvlc_media_release(media);
+    }
+  }
+  return stats;
+}
+
+void VlcNullVideoOutput::ResetStats() {
+  frames_presented_.store(0, std::memory_order_relaxed);
+  first_presented_at_us_.store(0, std::memory_order_relaxed);
+  last_presented_at_us_.store(0, std::memory_order_relaxed);
+  total_lock_to_display_us_.store(0, std::memory_order_relaxed);
+  min_lock_to_display_us_.store(std::numeric_limits<int64_t>::max(),
+                                std::memory_order_relaxed);
+  max_lock_to_display_us_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace foxglove
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <memory>
+
+#include "video/frame_buffer.h"
+#include "vlc/vlc_video_output.h"
+
+namespace foxglove {
+
+// VLC's clock still paces the output, so these describe playback of the
+// media in real time rather than how fast it could be decoded.
+struct NullVideoOutputStats {
+  uint64_t frames_presented = 0;
+  // Averaged between the first and the last presented frame. Matches the
+  // content's frame rate unless the decoder falls behind.
+  double presented_frames_per_second = 0;
+  // Time between VLC locking a buffer and displaying the picture, in
+  // microseconds. Includes waiting for the picture to be due, so it's the
+  // headroom the decoder left rather than its latency.
+  int64_t min_lock_to_display_us = 0;
+  int64_t average_lock_to_display_us = 0;
+  int64_t max_lock_to_display_us = 0;
+  // Taken from the statistics of the current media. Pictures the decoder
+  // couldn't finish in time show up here.
+  uint64_t frames_late = 0;
+  uint64_t frames_dropped = 0;
+};
+
+// Decodes into a single scratch buffer and discards every frame. Used to
+// check whether a machine keeps up with decoding some media in real time,
+// without any renderer in the loop.
+class VlcNullVideoOutput : public VlcVideoOutput {
+ public:
+  // kNone keeps the decoder's native chroma where possible, which leaves
+  // out any conversion cost.
+  explicit VlcNullVideoOutput(PixelFormat pixel_format);
+
+  Status<ErrorDetails> Attach(libvlc_media_player_t* player) override;
+
+  VideoOutputDelegate* output_delegate() const override { return nullptr; }
+
+  // May be called from any thread.
+  NullVideoOutputStats stats() const;
+  void ResetStats();
+
+ private:
+  PixelFormat pixel_format_;
+  libvlc_media_player_t* player_ = nullptr;
+  std::unique_ptr<FrameBuffer> scratch_buffer_;
+  int64_t locked_at_us_ = 0;
+
+  std::atomic<uint64_t> frames_presented_ = 0;
+  std::atomic<int64_t> first_presented_at_us_ = 0;
+  std::atomic<int64_t> last_presented_at_us_ = 0;
+  std::atomic<int64_t> total_lock_to_display_us_ = 0;
+  std::atomic<int64_t> min_lock_to_display_us_ =
+      std::numeric_limits<int64_t>::max();
+  std::atomic<int64_t> max_lock_to_display_us_ = 0;
+
+  unsigned Setup(char* chroma, unsigned* width, unsigned* height,
+                 unsigned* pitch, unsigned* lines);
+  void* OnVideoLock(void** planes);
+  void OnVideoPicture(void* picture);
+};
+
+}  // namespace foxglove
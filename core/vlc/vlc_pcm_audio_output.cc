@@ -0,0 +1,128 @@
+#include "vlc/vlc_pcm_audio_output.h"
+
+#include <vlc/vlc.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+namespace foxglove {
+
+namespace {
+
+const char* ToVlcAudioFormat(SampleFormat format) {
+  return format == SampleFormat::kS16 ? "S16N" : "FL32";
+}
+
+}  // namespace
+
+VlcPcmAudioOutput::VlcPcmAudioOutput(std::shared_ptr<AudioRing> ring)
+    : ring_(std::move(ring)) {}
+
+Status<ErrorDetails> VlcPcmAudioOutput::Attach(
+    libvlc_media_player_t* player) {
+  if (!ring_->is_valid() || ring_->format().channels == 0 ||
+      ring_->format().sample_rate == 0) {
+    return ErrorDetails("Invalid audio ring format or capacity");
+  }
+
+  libvlc_audio_set_callbacks(
+      player,
+      [](void* opaque, const void* samples, unsigned count, int64_t) {
+        auto instance = reinterpret_cast<VlcPcmAudioOutput*>(opaque);
+        instance->OnPlay(samples, count);
+      },
+      [](void* opaque, int64_t) {
+        auto instance = reinterpret_cast<VlcPcmAudioOutput*>(opaque);
+        instance->is_paused_ = true;
+      },
+      [](void* opaque, int64_t) {
+        auto instance = reinterpret_cast<VlcPcmAudioOutput*>(opaque);
+        instance->is_paused_ = false;
+      },
+      [](void* opaque, int64_t) {
+        auto instance = reinterpret_cast<VlcPcmAudioOutput*>(opaque);
+        instance->ring_->Flush();
+      },
+      nullptr, this);
+
+  libvlc_audio_set_format_callbacks(
+      player,
+      [](void** opaque, char* format, unsigned* rate,
+         unsigned* channels) -> int {
+        auto instance = reinterpret_cast<VlcPcmAudioOutput*>(*opaque);
+        if (instance != nullptr) {
+          return instance->Setup(format, rate, channels);
+        }
+        return -1;
+      },
+      nullptr);
+
+  return OkStatus();
+}
+
+bool VlcPcmAudioOutput::AddAudioAnalyzer(
+    std::shared_ptr<AudioAnalyzer> analyzer) {
+  const std::lock_guard<std::mutex> lock(analyzers_mutex_);
+  auto analyzers = analyzers_owner_
+                       ? std::make_unique<AnalyzerList>(*analyzers_owner_)
+                       : std::make_unique<AnalyzerList>();
+  analyzers->push_back(std::move(analyzer));
+  PublishAnalyzers(std::move(analyzers));
+  return true;
+}
+
+bool VlcPcmAudioOutput::RemoveAudioAnalyzer(const AudioAnalyzer* analyzer) {
+  const std::lock_guard<std::mutex> lock(analyzers_mutex_);
+  if (!analyzers_owner_) {
+    return false;
+  }
+  auto analyzers = std::make_unique<AnalyzerList>(*analyzers_owner_);
+  auto it = std::find_if(
+      analyzers->begin(), analyzers->end(),
+      [analyzer](const auto& entry) { return entry.get() == analyzer; });
+  if (it == analyzers->end()) {
+    return false;
+  }
+  analyzers->erase(it);
+  PublishAnalyzers(std::move(analyzers));
+  return true;
+}
+
+void VlcPcmAudioOutput::PublishAnalyzers(
+    std::unique_ptr<const AnalyzerList> analyzers) {
+  analyzers_.store(analyzers.get());
+  // OnPlay() counts itself as active before loading the list, so once the
+  // count drops to zero the audio thread can only see the new list. Waits
+  // for at most one buffer's analysis.
+  while (active_analyses_.load() != 0) {
+    std::this_thread::yield();
+  }
+  analyzers_owner_ = std::move(analyzers);
+}
+
+int VlcPcmAudioOutput::Setup(char* format, unsigned* rate,
+                             unsigned* channels) {
+  // VLC resamples and remixes to whatever is requested here.
+  const auto& ring_format = ring_->format();
+  memcpy(format, ToVlcAudioFormat(ring_format.sample_format), 4);
+  *rate = ring_format.sample_rate;
+  *channels = ring_format.channels;
+  is_paused_ = false;
+  return 0;
+}
+
+void VlcPcmAudioOutput::OnPlay(const void* samples, unsigned count) {
+  ring_->Write(samples, count);
+
+  active_analyses_.fetch_add(1);
+  if (const auto* analyzers = analyzers_.load()) {
+    for (const auto& analyzer : *analyzers) {
+      analyzer->Analyze(ring_->format(), samples, count);
+    }
+  }
+  active_analyses_.fetch_sub(1, std::memory_order_release);
+}
+
+}  // namespace foxglove
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "audio/audio_ring.h"
+#include "vlc/vlc_audio_output.h"
+
+namespace foxglove {
+
+// Has VLC convert decoded audio to the ring's format and writes it to the
+// ring instead of a sound device, so audio can be processed without one.
+// The callbacks run on VLC's audio thread and never block; frames that
+// don't fit into the ring get dropped. Volume and mute don't apply.
+class VlcPcmAudioOutput : public VlcAudioOutput {
+ public:
+  explicit VlcPcmAudioOutput(std::shared_ptr<AudioRing> ring);
+
+  Status<ErrorDetails> Attach(libvlc_media_player_t* player) override;
+
+  const AudioFormat& format() const override { return ring_->format(); }
+  bool AddAudioAnalyzer(std::shared_ptr<AudioAnalyzer> analyzer) override;
+  bool RemoveAudioAnalyzer(const AudioAnalyzer* analyzer) override;
+  AudioRing* ring() const { return ring_.get(); }
+  bool is_paused() const { return is_paused_; }
+
+ private:
+  std::shared_ptr<AudioRing> ring_;
+  std::atomic<bool> is_paused_ = false;
+
+  // The list is replaced as a whole whenever analyzers change, so the audio
+  // thread reads it without taking a lock.
+  typedef std::vector<std::shared_ptr<AudioAnalyzer>> AnalyzerList;
+  // Serializes adding and removing analyzers.
+  std::mutex analyzers_mutex_;
+  std::unique_ptr<const AnalyzerList> analyzers_owner_;
+  std::atomic<const AnalyzerList*> analyzers_ = nullptr;
+  // Non-zero while the audio thread runs analyzers.
+  std::atomic<uint32_t> active_analyses_ = 0;
+
+  int Setup(char* format, unsigned* rate, unsigned* channels);
+  void OnPlay(const void* samples, unsigned count);
+  void PublishAnalyzers(std::unique_ptr<const AnalyzerList> analyzers);
+};
+
+}  // namespace foxglove
@@ -1,22 +1,76 @@
 #include "vlc/vlc_pixel_buffer_output.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <iostream>
 
+#include "video/convert/convert.h"
+#include "video/frame_hash.h"
+#include "vlc/vlc_chroma.h"
 #include "vlc/vlc_player.h"
 
 namespace foxglove {
 
 namespace {
-constexpr static char* kVLCFormatBGRA = "BGRA";
-constexpr static char* kVLCFormatRGBA = "RGBA";
+
+// Shrinks |width| x |height| to fit into the given bounds, keeping the
+// aspect ratio. A bound of 0 is ignored.
+void ScaleToFit(uint32_t max_width, uint32_t max_height, unsigned* width,
+                unsigned* height) {
+  const uint64_t w = *width;
+  const uint64_t h = *height;
+  if (w == 0 || h == 0) {
+    return;
+  }
+
+  uint64_t scaled_w = w;
+  uint64_t scaled_h = h;
+  if (max_width > 0 && scaled_w > max_width) {
+    scaled_w = max_width;
+    scaled_h = h * max_width / w;
+  }
+  if (max_height > 0 && scaled_h > max_height) {
+    scaled_h = max_height;
+    scaled_w = w * max_height / h;
+  }
+
+  *width = static_cast<unsigned>(std::max<uint64_t>(scaled_w, 1));
+  *height = static_cast<unsigned>(std::max<uint64_t>(scaled_h, 1));
+}
+
+// Returns the byte offset of pixel (x, y) within a plane. |x| and |y| have
+// to be even for 4:2:0 formats.
+size_t PlaneOffset(PixelFormat format, const FrameLayout& layout,
+                   size_t plane, uint32_t x, uint32_t y) {
+  const size_t pitch = layout.pitches[plane];
+  if (!IsPlanarFormat(format)) {
+    return y * pitch + static_cast<size_t>(x) * 4;
+  }
+  if (plane == 0) {
+    return y * pitch + x;
+  }
+  // NV12 interleaves U and V, so its chroma rows are as wide as luma rows.
+  const size_t chroma_x = format == PixelFormat::kFormatNV12 ? x : x / 2;
+  return (y / 2) * pitch + chroma_x;
+}
+
 }  // namespace
 
 VlcPixelBufferOutput::VlcPixelBufferOutput(
     std::unique_ptr<PixelBufferOutputDelegate> delegate, PixelFormat format)
-    : delegate_(std::move(delegate)), pixel_format_(format) {}
+    : delegate_(std::move(delegate)),
+      pixel_format_(format),
+      skip_duplicate_frames_(delegate_->skip_duplicate_frames()) {
+  if (auto pool_options = delegate_->frame_buffer_pool_options()) {
+    frame_pool_ = std::make_unique<FrameBufferPool>(pool_options.value());
+  }
+}
 
 Status<ErrorDetails> VlcPixelBufferOutput::Attach(
     libvlc_media_player_t* player) {
+  player_ = player;
+
   libvlc_video_set_callbacks(
       player,
       [](void* opaque, void** planes) -> void* {
@@ -51,6 +105,64 @@ Status<ErrorDetails> VlcPixelBufferOutput::Attach(
   return OkStatus();
 }
 
+bool VlcPixelBufferOutput::SetMaxOutputSize(uint32_t max_width,
+                                            uint32_t max_height) {
+  max_output_width_ = max_width;
+  max_output_height_ = max_height;
+  return true;
+}
+
+bool VlcPixelBufferOutput::SetCropRect(const VideoRect& rect) {
+  {
+    const std::lock_guard<std::mutex> lock(crop_mutex_);
+    crop_rect_ = rect;
+  }
+  is_crop_changed_ = true;
+  return true;
+}
+
+VideoRect VlcPixelBufferOutput::crop_rect() {
+  const std::lock_guard<std::mutex> lock(crop_mutex_);
+  return crop_rect_;
+}
+
+bool VlcPixelBufferOutput::SetMaxFrameRate(double max_fps) {
+  frame_rate_limiter_.SetMaxFrameRate(max_fps);
+  return true;
+}
+
+bool VlcPixelBufferOutput::AddFrameAnalyzer(
+    std::shared_ptr<FrameAnalyzer> analyzer) {
+  const std::lock_guard<std::mutex> lock(analyzers_mutex_);
+  analyzers_.push_back(std::move(analyzer));
+  return true;
+}
+
+bool VlcPixelBufferOutput::RemoveFrameAnalyzer(const FrameAnalyzer* analyzer) {
+  const std::lock_guard<std::mutex> lock(analyzers_mutex_);
+  auto it = std::find_if(
+      analyzers_.begin(), analyzers_.end(),
+      [analyzer](const auto& entry) { return entry.get() == analyzer; });
+  if (it == analyzers_.end()) {
+    return false;
+  }
+  analyzers_.erase(it);
+  return true;
+}
+
+PixelBufferOutputStats VlcPixelBufferOutput::stats() const {
+  PixelBufferOutputStats stats;
+  stats.frames_presented = frames_presented_.load(std::memory_order_relaxed);
+  stats.frames_decimated = frames_decimated_.load(std::memory_order_relaxed);
+  stats.frames_skipped_duplicate =
+      frames_skipped_duplicate_.load(std::memory_order_relaxed);
+  stats.frames_dropped_pool_exhausted =
+      frames_dropped_pool_exhausted_.load(std::memory_order_relaxed);
+  stats.frames_dropped_no_buffer =
+      frames_dropped_no_buffer_.load(std::memory_order_relaxed);
+  return stats;
+}
+
 unsigned VlcPixelBufferOutput::Setup(char* chroma, unsigned* width,
                                      unsigned* height, unsigned* pitches,
                                      unsigned* lines) {
@@ -60,30 +172,113 @@ unsigned VlcPixelBufferOutput::Setup(char* chroma, unsigned* width,
   //   return 0;
   // }
 
+  output_format_ = pixel_format_ == PixelFormat::kNone
+                       ? PixelFormat::kFormatRGBA
+                       : pixel_format_;
+
+  // Converting the decoder's native chroma ourselves is cheaper than letting
+  // VLC run swscale and copying the much larger RGB picture afterwards.
+  vlc_format_ = output_format_;
+  const auto native_format = FromVlcChroma(chroma);
+  if (IsPlanarFormat(native_format) &&
+      convert::CanConvert(native_format, output_format_)) {
+    vlc_format_ = native_format;
+  }
   {
-    const char* vlc_format;
-    switch (pixel_format_) {
-      case PixelFormat::kFormatBGRA:
-        vlc_format = kVLCFormatBGRA;
-      default:
-        vlc_format = kVLCFormatRGBA;
-    }
-    auto len = std::char_traits<char>::length(vlc_format);
+    const char* vlc_chroma = ToVlcChroma(vlc_format_);
+    auto len = std::char_traits<char>::length(vlc_chroma);
     assert(len == 4);
-    memcpy(chroma, vlc_format, len);
+    memcpy(chroma, vlc_chroma, len);
   }
 
-  auto w = *width;
-  auto h = *height;
+  is_crop_changed_ = false;
+  const auto crop = crop_rect();
+  source_width_ = *width;
+  source_height_ = *height;
+  // VLC doesn't pass on the stream's colorimetry, so guess from the decoded
+  // height before scaling.
+  yuv_matrix_ = DefaultYuvMatrix(source_height_);
+  const auto visible = crop.ClippedTo(source_width_, source_height_);
 
-  pitches[0] = w * 4;
-  lines[0] = h;
+  // VLC scales the picture to whatever size we ask for, which is far
+  // cheaper than copying full resolution frames that get downscaled later.
+  if (visible.is_empty()) {
+    ScaleToFit(max_output_width_, max_output_height_, width, height);
+  } else {
+    // Scale the whole picture such that the cropped area fits.
+    unsigned visible_width = visible.width;
+    unsigned visible_height = visible.height;
+    ScaleToFit(max_output_width_, max_output_height_, &visible_width,
+               &visible_height);
+    *width = static_cast<unsigned>(std::max<uint64_t>(
+        uint64_t{source_width_} * visible_width / visible.width, 1));
+    *height = static_cast<unsigned>(std::max<uint64_t>(
+        uint64_t{source_height_} * visible_height / visible.height, 1));
+  }
 
-  SetDimensions(VideoDimensions(w, h, pitches[0]));
+  vlc_width_ = *width;
+  vlc_height_ = *height;
+  vlc_layout_ = ComputeFrameLayout(vlc_format_, vlc_width_, vlc_height_);
+  for (uint32_t i = 0; i < vlc_layout_.plane_count; i++) {
+    pitches[i] = vlc_layout_.pitches[i];
+    lines[i] = vlc_layout_.lines[i];
+  }
 
+  ConfigureOutput(crop);
   return 1;
 }
 
+void VlcPixelBufferOutput::ConfigureOutput(const VideoRect& crop_rect) {
+  picture_crop_.reset();
+  const auto crop = crop_rect.ClippedTo(source_width_, source_height_);
+  if (!crop.is_empty()) {
+    // Map the crop from the decoded video to VLC's (scaled) picture.
+    VideoRect rect;
+    rect.x = static_cast<uint32_t>(uint64_t{crop.x} * vlc_width_ /
+                                   source_width_);
+    rect.y = static_cast<uint32_t>(uint64_t{crop.y} * vlc_height_ /
+                                   source_height_);
+    rect.width = static_cast<uint32_t>(std::max<uint64_t>(
+        uint64_t{crop.width} * vlc_width_ / source_width_, 1));
+    rect.height = static_cast<uint32_t>(std::max<uint64_t>(
+        uint64_t{crop.height} * vlc_height_ / source_height_, 1));
+    if (IsPlanarFormat(vlc_format_)) {
+      // Chroma is subsampled, so the crop has to start on an even pixel.
+      rect.x &= ~1u;
+      rect.y &= ~1u;
+    }
+    rect = rect.ClippedTo(vlc_width_, vlc_height_);
+    if (!rect.is_empty()) {
+      picture_crop_ = rect;
+    }
+  }
+
+  const auto w = picture_crop_ ? picture_crop_->width : vlc_width_;
+  const auto h = picture_crop_ ? picture_crop_->height : vlc_height_;
+  layout_ = ComputeFrameLayout(output_format_, w, h);
+
+  if (vlc_format_ == output_format_ && !picture_crop_) {
+    source_buffer_.reset();
+  } else if (!source_buffer_ ||
+             source_buffer_->pixel_format() != vlc_format_ ||
+             source_buffer_->layout() != vlc_layout_) {
+    source_buffer_ = std::make_unique<FrameBuffer>(
+        vlc_format_,
+        VideoDimensions(vlc_width_, vlc_height_, vlc_layout_.pitches[0]),
+        vlc_layout_);
+  }
+
+  VideoDimensions dimensions(w, h, layout_.pitches[0]);
+  if (frame_pool_) {
+    // Keeps the existing buffers if only the format got renegotiated.
+    frame_pool_->Configure(output_format_, dimensions, layout_);
+  }
+
+  last_frame_hash_.reset();
+  delegate_->OnFormatChanged(output_format_, dimensions, layout_);
+  SetDimensions(std::move(dimensions));
+}
+
 void VlcPixelBufferOutput::Cleanup() {
   std::cerr << "RESET " << std::endl;
 
@@ -104,15 +299,84 @@ void VlcPixelBufferOutput::Cleanup() {
 
   // SendEmptyFrame();
   // SetDimensions(VideoDimensions());
+
+  pending_frame_.reset();
 }
 
 void* VlcPixelBufferOutput::OnVideoLock(void** planes) {
+  if (is_crop_changed_.exchange(false)) {
+    // Only our copy depends on the crop, so VLC keeps rendering the same
+    // picture.
+    ConfigureOutput(crop_rect());
+  }
+
+  timing_.decoded_at_us = MonotonicTimeUs();
+  // Deciding here rather than on display saves the delegate's buffer and,
+  // for converted frames, the conversion.
+  is_decimated_ = frame_rate_limiter_.is_enabled() &&
+                  !frame_rate_limiter_.ShouldPresent(CurrentPtsUs());
+  is_missing_buffer_ = false;
+
+  if (source_buffer_) {
+    source_buffer_->GetPlanes(planes);
+    return nullptr;
+  }
+
+  if (is_decimated_) {
+    return LockDiscardBuffer(planes);
+  }
+
+  if (frame_pool_) {
+    return LockPooledFrame(planes);
+  }
+
+  // VLC doesn't clear the planes, so a missing buffer wouldn't show.
+  std::fill(planes, planes + kMaxPlanes, nullptr);
   auto user_data = delegate_->LockBuffer(planes, current_dimensions_);
-  assert(planes[0]);
+  if (!planes[0]) {
+    // The delegate couldn't provide a buffer, e.g. because allocating one
+    // failed, so this frame gets dropped.
+    delegate_->UnlockBuffer(user_data);
+    frames_dropped_no_buffer_.fetch_add(1, std::memory_order_relaxed);
+    is_missing_buffer_ = true;
+    return LockDiscardBuffer(planes);
+  }
+  std::copy(planes, planes + kMaxPlanes, locked_planes_.begin());
   return user_data;
 }
 
+void* VlcPixelBufferOutput::LockPooledFrame(void** planes) {
+  pending_frame_ = frame_pool_->Acquire();
+  if (pending_frame_) {
+    pending_frame_->GetPlanes(planes);
+    return pending_frame_.get();
+  }
+
+  // All buffers are still held by the delegate, so this frame gets dropped.
+  frames_dropped_pool_exhausted_.fetch_add(1, std::memory_order_relaxed);
+  return LockDiscardBuffer(planes);
+}
+
+void* VlcPixelBufferOutput::LockDiscardBuffer(void** planes) {
+  if (!discard_buffer_ || discard_buffer_->pixel_format() != output_format_ ||
+      discard_buffer_->layout() != layout_) {
+    discard_buffer_ = std::make_unique<FrameBuffer>(
+        output_format_, current_dimensions_, layout_);
+  }
+  discard_buffer_->GetPlanes(planes);
+  return nullptr;
+}
+
+int64_t VlcPixelBufferOutput::CurrentPtsUs() const {
+  const auto time_ms = libvlc_media_player_get_time(player_);
+  return time_ms >= 0 ? time_ms * 1000 : -1;
+}
+
 void VlcPixelBufferOutput::OnVideoUnlock(void* user_data, void* const* planes) {
+  if (source_buffer_ || frame_pool_ || is_decimated_ || is_missing_buffer_) {
+    return;
+  }
+
   delegate_->UnlockBuffer(user_data);
 }
 
@@ -122,7 +386,156 @@ void VlcPixelBufferOutput::OnVideoPicture(void* user_data) {
   //   return;
   // }
 
-  delegate_->PresentBuffer(current_dimensions_, user_data);
+  // The display callback runs right when the picture is due, so the
+  // player's current time is the picture's presentation time.
+  timing_.sequence++;
+  timing_.pts_us = CurrentPtsUs();
+
+  if (is_decimated_) {
+    frames_decimated_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  if (is_missing_buffer_) {
+    return;
+  }
+
+  RunAnalyzers();
+
+  if (skip_duplicate_frames_ && IsDuplicateFrame()) {
+    pending_frame_.reset();
+    frames_skipped_duplicate_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  if (source_buffer_) {
+    PresentConvertedFrame(timing_);
+    return;
+  }
+
+  timing_.presented_at_us = MonotonicTimeUs();
+  if (frame_pool_) {
+    if (pending_frame_) {
+      pending_frame_->set_timing(timing_);
+      pending_frame_->set_yuv_matrix(yuv_matrix_);
+      delegate_->PresentFrame(std::move(pending_frame_));
+      frames_presented_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return;
+  }
+
+  delegate_->PresentBuffer(FrameDescriptor{output_format_, current_dimensions_,
+                                           layout_, timing_, yuv_matrix_},
+                           user_data);
+  frames_presented_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void VlcPixelBufferOutput::PresentConvertedFrame(FrameTiming timing) {
+  if (frame_pool_) {
+    auto frame = frame_pool_->Acquire();
+    if (!frame) {
+      frames_dropped_pool_exhausted_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    void* planes[kMaxPlanes] = {};
+    frame->GetPlanes(planes);
+    ConvertSourceBuffer(planes);
+    timing.presented_at_us = MonotonicTimeUs();
+    frame->set_timing(timing);
+    frame->set_yuv_matrix(yuv_matrix_);
+    delegate_->PresentFrame(std::move(frame));
+    frames_presented_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  void* planes[kMaxPlanes] = {};
+  auto user_data = delegate_->LockBuffer(planes, current_dimensions_);
+  if (!planes[0]) {
+    delegate_->UnlockBuffer(user_data);
+    frames_dropped_no_buffer_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  ConvertSourceBuffer(planes);
+  delegate_->UnlockBuffer(user_data);
+  timing.presented_at_us = MonotonicTimeUs();
+  delegate_->PresentBuffer(FrameDescriptor{output_format_, current_dimensions_,
+                                           layout_, timing, yuv_matrix_},
+                           user_data);
+  frames_presented_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool VlcPixelBufferOutput::IsDuplicateFrame() {
+  // Hashing the source picture also saves converting duplicates.
+  const FrameBuffer* frame =
+      source_buffer_ ? source_buffer_.get() : pending_frame_.get();
+  if (frame_pool_ && !frame) {
+    // Gets dropped anyway.
+    return false;
+  }
+
+  const uint8_t* planes[kMaxPlanes] = {};
+  for (size_t i = 0; i < kMaxPlanes; i++) {
+    planes[i] = frame ? frame->plane(i)
+                      : static_cast<const uint8_t*>(locked_planes_[i]);
+  }
+  const auto hash = HashPicture(planes, frame ? frame->layout() : layout_);
+  const auto is_duplicate = last_frame_hash_ == hash;
+  last_frame_hash_ = hash;
+  return is_duplicate;
+}
+
+void VlcPixelBufferOutput::RunAnalyzers() {
+  const std::lock_guard<std::mutex> lock(analyzers_mutex_);
+  if (analyzers_.empty()) {
+    return;
+  }
+
+  // Analyzing the source picture sees it before cropping and conversion.
+  const FrameBuffer* frame =
+      source_buffer_ ? source_buffer_.get() : pending_frame_.get();
+  if (frame_pool_ && !frame) {
+    return;
+  }
+
+  FrameDescriptor descriptor;
+  const uint8_t* planes[kMaxPlanes] = {};
+  if (frame) {
+    descriptor = frame->descriptor();
+    for (size_t i = 0; i < kMaxPlanes; i++) {
+      planes[i] = frame->plane(i);
+    }
+  } else {
+    descriptor =
+        FrameDescriptor{output_format_, current_dimensions_, layout_, {}};
+    for (size_t i = 0; i < kMaxPlanes; i++) {
+      planes[i] = static_cast<const uint8_t*>(locked_planes_[i]);
+    }
+  }
+  descriptor.timing = timing_;
+  descriptor.yuv_matrix = yuv_matrix_;
+  for (const auto& analyzer : analyzers_) {
+    analyzer->Analyze(descriptor, planes);
+  }
+}
+
+void VlcPixelBufferOutput::ConvertSourceBuffer(void* const* planes) {
+  const auto& src_layout = source_buffer_->layout();
+  const auto crop =
+      picture_crop_.value_or(VideoRect{0, 0, vlc_width_, vlc_height_});
+  const uint8_t* src_planes[kMaxPlanes] = {};
+  uint8_t* dst_planes[kMaxPlanes] = {};
+  for (size_t i = 0; i < src_layout.plane_count; i++) {
+    src_planes[i] = source_buffer_->plane(i) +
+                    PlaneOffset(vlc_format_, src_layout, i, crop.x, crop.y);
+  }
+  for (size_t i = 0; i < kMaxPlanes; i++) {
+    dst_planes[i] = static_cast<uint8_t*>(planes[i]);
+  }
+
+  [[maybe_unused]] auto converted = convert::ConvertPicture(
+      vlc_format_, src_planes, src_layout, output_format_, dst_planes,
+      layout_, crop.width, crop.height, yuv_matrix_);
+  assert(converted);
 }
 
 }  // namespace foxglove
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
 
+#include "video/frame_rate_limiter.h"
 #include "video/pixel_buffer_output.h"
 #include "vlc/vlc_video_output.h"
 
@@ -19,16 +25,82 @@ class VlcPixelBufferOutput : public VlcVideoOutput {
     return delegate_.get();
   }
 
+  bool SetMaxOutputSize(uint32_t max_width, uint32_t max_height) override;
+  bool SetCropRect(const VideoRect& rect) override;
+  bool SetMaxFrameRate(double max_fps) override;
+  bool AddFrameAnalyzer(std::shared_ptr<FrameAnalyzer> analyzer) override;
+  bool RemoveFrameAnalyzer(const FrameAnalyzer* analyzer) override;
+
+  // May be called from any thread.
+  PixelBufferOutputStats stats() const;
+
  private:
   std::unique_ptr<PixelBufferOutputDelegate> delegate_;
   PixelFormat pixel_format_;
+  // The format and layout of the frames handed to the delegate.
+  PixelFormat output_format_ = PixelFormat::kNone;
+  FrameLayout layout_;
+  // The picture VLC renders.
+  PixelFormat vlc_format_ = PixelFormat::kNone;
+  FrameLayout vlc_layout_;
+  uint32_t vlc_width_ = 0;
+  uint32_t vlc_height_ = 0;
+  // Size of the decoded video, before VLC scales it.
+  uint32_t source_width_ = 0;
+  uint32_t source_height_ = 0;
+  YuvMatrix yuv_matrix_ = YuvMatrix::kBt601;
+  // Holds VLC's picture if it gets cropped or converted to |output_format_|
+  // by us rather than by VLC.
+  std::unique_ptr<FrameBuffer> source_buffer_;
+  // The part of VLC's picture that gets delivered, if cropping.
+  std::optional<VideoRect> picture_crop_;
+  std::mutex crop_mutex_;
+  VideoRect crop_rect_;
+  std::atomic<bool> is_crop_changed_ = false;
+  std::unique_ptr<FrameBufferPool> frame_pool_;
+  // The pooled buffer VLC is currently rendering into.
+  std::shared_ptr<FrameBuffer> pending_frame_;
+  // Receives frames that get dropped before reaching the delegate.
+  std::unique_ptr<FrameBuffer> discard_buffer_;
+  std::atomic<uint32_t> max_output_width_ = 0;
+  std::atomic<uint32_t> max_output_height_ = 0;
+  libvlc_media_player_t* player_ = nullptr;
+  // Timing of the picture VLC is currently rendering.
+  FrameTiming timing_;
+  // The delegate's buffer VLC is currently rendering into.
+  std::array<void*, kMaxPlanes> locked_planes_{};
+  bool skip_duplicate_frames_;
+  std::optional<uint64_t> last_frame_hash_;
+  FrameRateLimiter frame_rate_limiter_;
+  // Whether the picture VLC is currently rendering gets dropped.
+  bool is_decimated_ = false;
+  // Whether the delegate had no buffer for the picture VLC is currently
+  // rendering, which then gets dropped.
+  bool is_missing_buffer_ = false;
+  std::mutex analyzers_mutex_;
+  std::vector<std::shared_ptr<FrameAnalyzer>> analyzers_;
+
+  std::atomic<uint64_t> frames_presented_ = 0;
+  std::atomic<uint64_t> frames_decimated_ = 0;
+  std::atomic<uint64_t> frames_skipped_duplicate_ = 0;
+  std::atomic<uint64_t> frames_dropped_pool_exhausted_ = 0;
+  std::atomic<uint64_t> frames_dropped_no_buffer_ = 0;
 
   unsigned Setup(char* chroma, unsigned* width, unsigned* height,
                  unsigned* pitch, unsigned* lines);
   void Cleanup();
+  VideoRect crop_rect();
+  void ConfigureOutput(const VideoRect& crop_rect);
   void* OnVideoLock(void** planes);
   void OnVideoUnlock(void* picture, void* const* planes);
   void OnVideoPicture(void* picture);
+  void* LockPooledFrame(void** planes);
+  void* LockDiscardBuffer(void** planes);
+  int64_t CurrentPtsUs() const;
+  void PresentConvertedFrame(FrameTiming timing);
+  bool IsDuplicateFrame();
+  void RunAnalyzers();
+  void ConvertSourceBuffer(void* const* planes);
 };
 
 }  // namespace foxglove
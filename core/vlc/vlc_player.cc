@@ -2,7 +2,11 @@
 
 #include "base/logging.h"
 #include "vlc/vlc_d3d11_output.h"
+#include "vlc/vlc_null_video_output.h"
 #include "vlc/vlc_pixel_buffer_output.h"
+#ifdef __linux__
+#include "vlc/vlc_shared_memory_output.h"
+#endif
 #include "vlc_player_impl.h"
 
 namespace foxglove {
@@ -20,6 +24,11 @@ std::unique_ptr<VlcPlayer::VideoOutputType> VlcPlayer::CreatePixelBufferOutput(
                                                 pixel_format);
 }
 
+std::unique_ptr<VlcPlayer::VideoOutputType> VlcPlayer::CreateNullOutput(
+    PixelFormat pixel_format) const {
+  return std::make_unique<VlcNullVideoOutput>(pixel_format);
+}
+
 #ifdef _WIN32
 std::unique_ptr<VlcPlayer::VideoOutputType> VlcPlayer::CreateD3D11Output(
     std::unique_ptr<D3D11OutputDelegate> output_delegate,
@@ -28,6 +37,15 @@ std::unique_ptr<VlcPlayer::VideoOutputType> VlcPlayer::CreateD3D11Output(
 }
 #endif
 
+#ifdef __linux__
+std::unique_ptr<VlcPlayer::VideoOutputType>
+VlcPlayer::CreateSharedMemoryOutput(std::shared_ptr<SharedFrameRingWriter> ring,
+                                    PixelFormat pixel_format) const {
+  return std::make_unique<VlcSharedMemoryOutput>(std::move(ring),
+                                                 pixel_format);
+}
+#endif
+
 Status<ErrorDetails> VlcPlayer::SetVideoOutput(
     std::unique_ptr<VlcPlayer::VideoOutputType> video_output) {
   assert(impl_);
@@ -40,6 +58,18 @@ VlcPlayer::VideoOutputType* VlcPlayer::GetVideoOutput() const {
   return impl_->GetVideoOutput();
 }
 
+Status<ErrorDetails> VlcPlayer::SetAudioOutput(
+    std::unique_ptr<VlcAudioOutput> audio_output) {
+  assert(impl_);
+  assert(audio_output);
+  return impl_->SetAudioOutput(std::move(audio_output));
+}
+
+VlcAudioOutput* VlcPlayer::GetAudioOutput() const {
+  assert(impl_);
+  return impl_->GetAudioOutput();
+}
+
 void VlcPlayer::SetEventDelegate(
     std::unique_ptr<PlayerEventDelegate> event_delegate) {
   assert(impl_);
@@ -106,6 +136,50 @@ void VlcPlayer::SetPositionReportingEnabled(bool is_enabled) {
   impl_->SetPositionReportingEnabled(is_enabled);
 }
 
+bool VlcPlayer::SetMaxFrameRate(double max_fps) {
+  assert(impl_);
+  return impl_->SetMaxFrameRate(max_fps);
+}
+
+bool VlcPlayer::SetCropRect(const VideoRect& rect) {
+  assert(impl_);
+  return impl_->SetCropRect(rect);
+}
+
+bool VlcPlayer::SetMotionDetection(
+    std::optional<MotionDetectorOptions> options) {
+  assert(impl_);
+  return impl_->SetMotionDetection(std::move(options));
+}
+
+bool VlcPlayer::SetVideoSignalDetection(
+    std::optional<VideoSignalDetectorOptions> options) {
+  assert(impl_);
+  return impl_->SetVideoSignalDetection(std::move(options));
+}
+
+std::optional<LumaStatistics> VlcPlayer::luma_statistics() const {
+  assert(impl_);
+  return impl_->luma_statistics();
+}
+
+bool VlcPlayer::SetSceneDetection(
+    std::optional<SceneDetectorOptions> options) {
+  assert(impl_);
+  return impl_->SetSceneDetection(std::move(options));
+}
+
+std::vector<SceneThumbnail> VlcPlayer::scenes() const {
+  assert(impl_);
+  return impl_->scenes();
+}
+
+bool VlcPlayer::SetAudioLevelMetering(
+    std::optional<AudioLevelMeterOptions> options) {
+  assert(impl_);
+  return impl_->SetAudioLevelMetering(std::move(options));
+}
+
 int64_t VlcPlayer::duration() {
   assert(impl_);
   return impl_->duration();
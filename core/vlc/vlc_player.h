@@ -1,9 +1,16 @@
 #pragma once
 
 #include <mutex>
+#include <optional>
+#include <vector>
 
+#include "audio/audio_level_meter.h"
 #include "events.h"
 #include "player.h"
+#include "video/motion_detector.h"
+#include "video/scene_detector.h"
+#include "video/video_signal_detector.h"
+#include "vlc/vlc_audio_output.h"
 #include "vlc/vlc_environment.h"
 #include "vlc/vlc_video_output.h"
 
@@ -23,6 +30,10 @@ class VlcPlayer : public Player<VlcVideoOutput> {
       std::unique_ptr<PixelBufferOutputDelegate> output_delegate,
       PixelFormat pixel_format) const override;
 
+  // |VideoOutputFactory|
+  std::unique_ptr<VideoOutputType> CreateNullOutput(
+      PixelFormat pixel_format = PixelFormat::kNone) const override;
+
 #ifdef _WIN32
   // |VideoOutputFactory|
   std::unique_ptr<VideoOutputType> CreateD3D11Output(
@@ -30,11 +41,23 @@ class VlcPlayer : public Player<VlcVideoOutput> {
       winrt::com_ptr<IDXGIAdapter> adapter = nullptr) const override;
 #endif
 
+#ifdef __linux__
+  // |VideoOutputFactory|
+  std::unique_ptr<VideoOutputType> CreateSharedMemoryOutput(
+      std::shared_ptr<SharedFrameRingWriter> ring,
+      PixelFormat pixel_format) const override;
+#endif
+
   Status<ErrorDetails> SetVideoOutput(
       std::unique_ptr<VideoOutputType> output) override;
 
   VideoOutputType* GetVideoOutput() const override;
 
+  // Routes audio to |output| instead of the sound device, starting with the
+  // next audio output VLC creates.
+  Status<ErrorDetails> SetAudioOutput(std::unique_ptr<VlcAudioOutput> output);
+  VlcAudioOutput* GetAudioOutput() const;
+
   bool Open(std::unique_ptr<Media> media) override;
   bool Play() override;
   void Pause() override;
@@ -47,6 +70,37 @@ class VlcPlayer : public Player<VlcVideoOutput> {
   void SetMute(bool is_muted) override;
   int64_t duration() override;
   void SetPositionReportingEnabled(bool is_enabled);
+  // Limits the frame rate of the current video output, 0 means unlimited.
+  // Returns false if there's no output or it doesn't support limiting.
+  bool SetMaxFrameRate(double max_fps);
+  // Crops the current video output to |rect|, an empty rect removes the
+  // crop. See VideoOutput::SetCropRect() for how it interacts with the max
+  // output size. Returns false if there's no output or it doesn't support
+  // cropping.
+  bool SetCropRect(const VideoRect& rect);
+  // Raises PlayerEventDelegate::OnMotion() for the frames of the video
+  // output, or stops if |options| is empty. Carries over to outputs set
+  // later. Returns false if the output doesn't support analysis.
+  bool SetMotionDetection(std::optional<MotionDetectorOptions> options);
+  // Raises PlayerEventDelegate::OnVideoSignal() when the video turns black
+  // or freezes, or stops if |options| is empty. Behaves like
+  // SetMotionDetection() otherwise.
+  bool SetVideoSignalDetection(
+      std::optional<VideoSignalDetectorOptions> options);
+  // Luma statistics of the last frame analyzed by the video signal
+  // detection, if enabled.
+  std::optional<LumaStatistics> luma_statistics() const;
+  // Records a thumbnail of every scene of the current media, or stops and
+  // forgets them if |options| is empty. Opening media starts a new list.
+  // Returns false if the output doesn't support analysis.
+  bool SetSceneDetection(std::optional<SceneDetectorOptions> options);
+  // The scenes of the current media recorded so far, ordered by time.
+  std::vector<SceneThumbnail> scenes() const;
+  // Raises PlayerEventDelegate::OnAudioLevel() for the audio of the audio
+  // output, or stops if |options| is empty. Carries over to outputs set
+  // later. Returns false if there's no audio output or it doesn't support
+  // analysis.
+  bool SetAudioLevelMetering(std::optional<AudioLevelMeterOptions> options);
 
  private:
   class Impl;
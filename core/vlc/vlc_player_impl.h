@@ -7,6 +7,7 @@
 #include "base/thread_checker.h"
 #include "events.h"
 #include "player.h"
+#include "vlc/vlc_audio_output.h"
 #include "vlc/vlc_environment.h"
 #include "vlc/vlc_media.h"
 #include "vlc/vlc_video_output.h"
@@ -108,6 +109,15 @@ class VlcPlayer::Impl : public std::enable_shared_from_this<VlcPlayer::Impl> {
                                                       dimensions.height);
           }
         });
+    if (motion_detector_) {
+      video_output_->AddFrameAnalyzer(motion_detector_);
+    }
+    if (video_signal_detector_) {
+      video_output_->AddFrameAnalyzer(video_signal_detector_);
+    }
+    if (scene_detector_) {
+      video_output_->AddFrameAnalyzer(scene_detector_);
+    }
     return video_output_->Attach(media_player_.get());
   }
 
@@ -116,6 +126,21 @@ class VlcPlayer::Impl : public std::enable_shared_from_this<VlcPlayer::Impl> {
     return video_output_.get();
   }
 
+  Status<ErrorDetails> SetAudioOutput(
+      std::unique_ptr<VlcAudioOutput> audio_output) {
+    assert(thread_checker_.IsCreationThreadCurrent());
+    audio_output_ = std::move(audio_output);
+    if (audio_level_meter_) {
+      audio_output_->AddAudioAnalyzer(audio_level_meter_);
+    }
+    return audio_output_->Attach(media_player_.get());
+  }
+
+  VlcAudioOutput* GetAudioOutput() const {
+    assert(thread_checker_.IsCreationThreadCurrent());
+    return audio_output_.get();
+  }
+
   bool Open(std::unique_ptr<Media> media) {
     assert(thread_checker_.IsCreationThreadCurrent());
 
@@ -136,6 +161,9 @@ class VlcPlayer::Impl : public std::enable_shared_from_this<VlcPlayer::Impl> {
     }
 
     Stop();
+    if (scene_detector_) {
+      scene_detector_->Reset();
+    }
 
     libvlc_media_player_set_media(media_player_.get(), vlc_media_ptr);
 
@@ -237,6 +265,89 @@ class VlcPlayer::Impl : public std::enable_shared_from_this<VlcPlayer::Impl> {
     position_reporting_enabled_ = is_enabled;
   }
 
+  bool SetMaxFrameRate(double max_fps) {
+    assert(thread_checker_.IsCreationThreadCurrent());
+    return video_output_ && video_output_->SetMaxFrameRate(max_fps);
+  }
+
+  bool SetCropRect(const VideoRect& rect) {
+    assert(thread_checker_.IsCreationThreadCurrent());
+    return video_output_ && video_output_->SetCropRect(rect);
+  }
+
+  bool SetMotionDetection(std::optional<MotionDetectorOptions> options) {
+    assert(thread_checker_.IsCreationThreadCurrent());
+    std::shared_ptr<MotionDetector> detector;
+    if (options) {
+      detector = std::make_shared<MotionDetector>(
+          *options, [this](const MotionEvent& event) {
+            if (event_delegate_) {
+              event_delegate_->OnMotion(event);
+            }
+          });
+    }
+    return ReplaceFrameAnalyzer(&motion_detector_, std::move(detector));
+  }
+
+  bool SetVideoSignalDetection(
+      std::optional<VideoSignalDetectorOptions> options) {
+    assert(thread_checker_.IsCreationThreadCurrent());
+    std::shared_ptr<VideoSignalDetector> detector;
+    if (options) {
+      detector = std::make_shared<VideoSignalDetector>(
+          *options, [this](const VideoSignalEvent& event) {
+            if (event_delegate_) {
+              event_delegate_->OnVideoSignal(event);
+            }
+          });
+    }
+    return ReplaceFrameAnalyzer(&video_signal_detector_, std::move(detector));
+  }
+
+  bool SetAudioLevelMetering(std::optional<AudioLevelMeterOptions> options) {
+    assert(thread_checker_.IsCreationThreadCurrent());
+    if (audio_level_meter_ && audio_output_) {
+      audio_output_->RemoveAudioAnalyzer(audio_level_meter_.get());
+    }
+    audio_level_meter_.reset();
+    if (!options) {
+      return true;
+    }
+    audio_level_meter_ = std::make_shared<AudioLevelMeter>(
+        *options, [this](const AudioLevelEvent& event) {
+          if (event_delegate_) {
+            event_delegate_->OnAudioLevel(event);
+          }
+        });
+    return audio_output_ &&
+           audio_output_->AddAudioAnalyzer(audio_level_meter_);
+  }
+
+  bool SetSceneDetection(std::optional<SceneDetectorOptions> options) {
+    assert(thread_checker_.IsCreationThreadCurrent());
+    std::shared_ptr<SceneDetector> detector;
+    if (options) {
+      detector = std::make_shared<SceneDetector>(*options);
+    }
+    return ReplaceFrameAnalyzer(&scene_detector_, std::move(detector));
+  }
+
+  std::vector<SceneThumbnail> scenes() const {
+    assert(thread_checker_.IsCreationThreadCurrent());
+    if (!scene_detector_) {
+      return {};
+    }
+    return scene_detector_->scenes();
+  }
+
+  std::optional<LumaStatistics> luma_statistics() const {
+    assert(thread_checker_.IsCreationThreadCurrent());
+    if (!video_signal_detector_) {
+      return std::nullopt;
+    }
+    return video_signal_detector_->statistics();
+  }
+
   int64_t id() const { return id_; }
 
   int64_t duration() const {
@@ -254,10 +365,30 @@ class VlcPlayer::Impl : public std::enable_shared_from_this<VlcPlayer::Impl> {
   bool shutting_down_ = false;
   std::shared_ptr<VlcEnvironment> environment_;
   std::unique_ptr<VlcVideoOutput> video_output_;
+  std::unique_ptr<VlcAudioOutput> audio_output_;
   std::unique_ptr<PlayerEventDelegate> event_delegate_;
+  std::shared_ptr<MotionDetector> motion_detector_;
+  std::shared_ptr<VideoSignalDetector> video_signal_detector_;
+  std::shared_ptr<SceneDetector> scene_detector_;
+  std::shared_ptr<AudioLevelMeter> audio_level_meter_;
   VLC::MediaPlayer media_player_;
   std::unique_ptr<VLC::MediaPlayerEventManager> player_event_manager_;
 
+  // Swaps |*current| for |analyzer| on the video output. Returns false if
+  // |analyzer| is set but couldn't be added.
+  template <typename T>
+  bool ReplaceFrameAnalyzer(std::shared_ptr<T>* current,
+                            std::shared_ptr<T> analyzer) {
+    if (*current && video_output_) {
+      video_output_->RemoveFrameAnalyzer(current->get());
+    }
+    *current = std::move(analyzer);
+    if (!*current) {
+      return true;
+    }
+    return video_output_ && video_output_->AddFrameAnalyzer(*current);
+  }
+
   void SetupEventHandlers() {
     player_event_manager_ = std::make_unique<VLC::MediaPlayerEventManager>(
         media_player_.eventManager());
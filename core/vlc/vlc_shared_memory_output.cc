@@ -0,0 +1,85 @@
+#include "vlc/vlc_shared_memory_output.h"
+
+#include <vlc/vlc.h>
+
+#include <cassert>
+#include <cstring>
+
+#include "base/logging.h"
+#include "vlc/vlc_chroma.h"
+
+namespace foxglove {
+
+VlcSharedMemoryOutput::VlcSharedMemoryOutput(
+    std::shared_ptr<SharedFrameRingWriter> ring, PixelFormat format)
+    : ring_(std::move(ring)),
+      pixel_format_(format == PixelFormat::kNone ? PixelFormat::kFormatRGBA
+                                                 : format) {}
+
+Status<ErrorDetails> VlcSharedMemoryOutput::Attach(
+    libvlc_media_player_t* player) {
+  player_ = player;
+
+  libvlc_video_set_callbacks(
+      player,
+      [](void* opaque, void** planes) -> void* {
+        auto instance = reinterpret_cast<VlcSharedMemoryOutput*>(opaque);
+        return instance->OnVideoLock(planes);
+      },
+      nullptr,
+      [](void* opaque, void* picture) {
+        auto instance = reinterpret_cast<VlcSharedMemoryOutput*>(opaque);
+        instance->OnVideoPicture(picture);
+      },
+      this);
+
+  libvlc_video_set_format_callbacks(
+      player,
+      [](void** opaque, char* chroma, unsigned* width, unsigned* height,
+         unsigned* pitches, unsigned* lines) -> unsigned {
+        auto instance = reinterpret_cast<VlcSharedMemoryOutput*>(*opaque);
+        if (instance != nullptr) {
+          return instance->Setup(chroma, width, height, pitches, lines);
+        }
+        return 0;
+      },
+      nullptr);
+
+  return OkStatus();
+}
+
+unsigned VlcSharedMemoryOutput::Setup(char* chroma, unsigned* width,
+                                      unsigned* height, unsigned* pitches,
+                                      unsigned* lines) {
+  memcpy(chroma, ToVlcChroma(pixel_format_), 4);
+
+  const auto layout = ComputeFrameLayout(pixel_format_, *width, *height);
+  VideoDimensions dimensions(*width, *height, layout.pitches[0]);
+  auto status = ring_->Configure(pixel_format_, dimensions, layout);
+  if (!status.ok()) {
+    LOG(ERROR) << "Configuring shared frame ring failed: "
+               << status.error().ToString() << std::endl;
+    return 0;
+  }
+
+  for (uint32_t i = 0; i < layout.plane_count; i++) {
+    pitches[i] = layout.pitches[i];
+    lines[i] = layout.lines[i];
+  }
+
+  SetDimensions(std::move(dimensions));
+  return 1;
+}
+
+void* VlcSharedMemoryOutput::OnVideoLock(void** planes) {
+  [[maybe_unused]] auto locked = ring_->BeginWrite(planes);
+  assert(locked);
+  return nullptr;
+}
+
+void VlcSharedMemoryOutput::OnVideoPicture(void* /*picture*/) {
+  const auto time_ms = libvlc_media_player_get_time(player_);
+  ring_->Publish(time_ms >= 0 ? time_ms * 1000 : -1);
+}
+
+}  // namespace foxglove
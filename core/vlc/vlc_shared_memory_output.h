@@ -0,0 +1,34 @@
+#pragma once
+
+#include <memory>
+
+#include "video/shared_frame_ring.h"
+#include "vlc/vlc_video_output.h"
+
+namespace foxglove {
+
+// Decodes straight into a SharedFrameRingWriter so other processes can read
+// frames without any copies.
+class VlcSharedMemoryOutput : public VlcVideoOutput {
+ public:
+  VlcSharedMemoryOutput(std::shared_ptr<SharedFrameRingWriter> ring,
+                        PixelFormat format);
+
+  Status<ErrorDetails> Attach(libvlc_media_player_t* player) override;
+
+  VideoOutputDelegate* output_delegate() const override { return nullptr; }
+
+  SharedFrameRingWriter* ring() const { return ring_.get(); }
+
+ private:
+  std::shared_ptr<SharedFrameRingWriter> ring_;
+  PixelFormat pixel_format_;
+  libvlc_media_player_t* player_ = nullptr;
+
+  unsigned Setup(char* chroma, unsigned* width, unsigned* height,
+                 unsigned* pitch, unsigned* lines);
+  void* OnVideoLock(void** planes);
+  void OnVideoPicture(void* picture);
+};
+
+}  // namespace foxglove